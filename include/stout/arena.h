@@ -0,0 +1,120 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "stout/bytes.h"
+#include "stout/pmr.h"
+
+////////////////////////////////////////////////////////////////////////
+
+namespace stout {
+
+////////////////////////////////////////////////////////////////////////
+
+// A memory resource for short-lived data, e.g., everything allocated
+// while handling a single request. Allocation bumps a pointer through
+// chunks obtained from 'upstream' (which grow geometrically starting
+// at 'initialSize' bytes) and deallocation does nothing; all of the
+// memory is released at once by 'reset()' or when the arena is
+// destroyed. Pass an arena to the 'stout::pmr' collections (or any
+// 'std::pmr' container) to allocate from it:
+//
+//   stout::Arena arena;
+//   stout::pmr::hashmap<int, std::pmr::string> map(&arena);
+//
+// Containers allocating from an arena must be destroyed (or at least
+// not used anymore) before the arena is reset or destroyed. An arena
+// is not thread-safe.
+class Arena : public std::pmr::memory_resource {
+ public:
+  explicit Arena(
+      size_t initialSize = 4096,
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+    : resource(initialSize, upstream) {}
+
+  // Allocates from 'buffer' first, which must outlive the arena, and
+  // only then from 'upstream'. See 'MonotonicBuffer'.
+  Arena(
+      void* buffer,
+      size_t size,
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+    : resource(buffer, size, upstream) {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Releases all of the memory allocated from the arena.
+  void reset() {
+    resource.release();
+    allocated_ = 0;
+  }
+
+  // Returns the number of bytes allocated from the arena since it was
+  // created or last reset.
+  Bytes allocated() const {
+    return Bytes(allocated_);
+  }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    void* result = resource.allocate(bytes, alignment);
+    allocated_ += bytes;
+    return result;
+  }
+
+  void do_deallocate(void*, size_t, size_t) override {}
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& that) const noexcept override {
+    return this == &that;
+  }
+
+  std::pmr::monotonic_buffer_resource resource;
+  size_t allocated_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+template <size_t N>
+struct InlineBuffer {
+  alignas(std::max_align_t) unsigned char buffer[N];
+};
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// An 'Arena' whose first 'N' bytes are part of the object itself, so
+// data that fits never touches the global allocator, e.g., when put on
+// the stack:
+//
+//   stout::MonotonicBuffer<16 * 1024> arena;
+//   stout::pmr::hashset<int> set(&arena);
+template <size_t N>
+class MonotonicBuffer : private internal::InlineBuffer<N>, public Arena {
+ public:
+  explicit MonotonicBuffer(
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+    : Arena(internal::InlineBuffer<N>::buffer, N, upstream) {}
+};
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace stout
+
+////////////////////////////////////////////////////////////////////////
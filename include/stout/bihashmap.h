@@ -0,0 +1,252 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "stout/footprint.h"
+#include "stout/hash.h"
+#include "stout/none.h"
+#include "stout/option.h"
+#include "stout/views.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// A bidirectional hash map, i.e., a one-to-one mapping between keys
+// and values with O(1) lookups of a value by its key ('get') as well
+// as of a key by its value ('get_key'), rather than scanning with
+// 'hashmap::contains_value' or keeping a reverse map in sync by hand.
+//
+// Each key/value pair is stored once; the index of the values refers
+// to the pairs rather than holding copies of them.
+//
+// Since every value has exactly one key, putting a value that's
+// already bound to another key removes that key (and putting a key
+// that's already bound removes its old value). The values can't be
+// modified in place since they're indexed.
+template <
+    typename Key,
+    typename Value,
+    typename KeyHash = stout::Hash<Key>,
+    typename ValueHash = stout::Hash<Value>>
+class BiHashMap {
+ public:
+  typedef std::unordered_map<Key, Value, KeyHash> map;
+  typedef typename map::value_type entry;
+  typedef typename map::const_iterator const_iterator;
+
+  BiHashMap() = default;
+
+  BiHashMap(std::initializer_list<std::pair<Key, Value>> list) {
+    for (const std::pair<Key, Value>& pair : list) {
+      put(pair.first, pair.second);
+    }
+  }
+
+  BiHashMap(const BiHashMap& that) : entries_(that.entries_) {
+    index();
+  }
+
+  BiHashMap& operator=(const BiHashMap& that) {
+    if (this != &that) {
+      values_.clear();
+      entries_ = that.entries_;
+      index();
+    }
+    return *this;
+  }
+
+  // Moving the entries keeps them at the same addresses so the index
+  // can be moved too.
+  BiHashMap(BiHashMap&&) = default;
+  BiHashMap& operator=(BiHashMap&&) = default;
+
+  // Binds 'key' to 'value', removing any existing binding of either.
+  void put(const Key& key, const Value& value) {
+    erase(key);
+    erase_value(value);
+
+    auto entry = entries_.emplace(key, value).first;
+    values_.emplace(std::cref(entry->second), &entry->first);
+  }
+
+  Option<Value> get(const Key& key) const {
+    auto iterator = entries_.find(key);
+    if (iterator == entries_.end()) {
+      return None();
+    }
+    return iterator->second;
+  }
+
+  Option<Key> get_key(const Value& value) const {
+    auto iterator = values_.find(std::cref(value));
+    if (iterator == values_.end()) {
+      return None();
+    }
+    return *iterator->second;
+  }
+
+  const Value& at(const Key& key) const {
+    return entries_.at(key);
+  }
+
+  const Key& at_value(const Value& value) const {
+    return *values_.at(std::cref(value));
+  }
+
+  bool contains(const Key& key) const {
+    return entries_.count(key) > 0;
+  }
+
+  bool contains_value(const Value& value) const {
+    return values_.count(std::cref(value)) > 0;
+  }
+
+  // Removes the binding of 'key', returning the number of bindings
+  // removed (0 or 1).
+  size_t erase(const Key& key) {
+    auto iterator = entries_.find(key);
+    if (iterator == entries_.end()) {
+      return 0;
+    }
+
+    values_.erase(std::cref(iterator->second));
+    entries_.erase(iterator);
+    return 1;
+  }
+
+  // Removes the binding of 'value', returning the number of bindings
+  // removed (0 or 1).
+  size_t erase_value(const Value& value) {
+    auto iterator = values_.find(std::cref(value));
+    if (iterator == values_.end()) {
+      return 0;
+    }
+
+    const Key* key = iterator->second;
+    values_.erase(iterator);
+    entries_.erase(*key);
+    return 1;
+  }
+
+  // Returns a view of the keys in this map that iterates the map in
+  // place, prefer this to 'keys()' unless a copy is needed.
+  auto keys_view() const {
+    return stout::keys_view(entries_.begin(), entries_.end());
+  }
+
+  // Returns a view of the values in this map that iterates the map in
+  // place, prefer this to 'values()' unless a copy is needed.
+  auto values_view() const {
+    return stout::values_view(entries_.begin(), entries_.end());
+  }
+
+  std::vector<Key> keys() const {
+    std::vector<Key> result;
+    result.reserve(entries_.size());
+    for (const entry& entry : entries_) {
+      result.push_back(entry.first);
+    }
+    return result;
+  }
+
+  std::vector<Value> values() const {
+    std::vector<Value> result;
+    result.reserve(entries_.size());
+    for (const entry& entry : entries_) {
+      result.push_back(entry.second);
+    }
+    return result;
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  bool empty() const {
+    return entries_.empty();
+  }
+
+  void clear() {
+    values_.clear();
+    entries_.clear();
+  }
+
+  void reserve(size_t size) {
+    entries_.reserve(size);
+    values_.reserve(size);
+  }
+
+  // Support for iteration; this allows using `foreachpair` and
+  // related constructs. Only const iteration is supported since the
+  // values are indexed.
+  const_iterator begin() const {
+    return entries_.begin();
+  }
+
+  const_iterator end() const {
+    return entries_.end();
+  }
+
+  // Estimates the heap used by the entries and the index, see
+  // stout/footprint.h.
+  friend size_t heapFootprint(const BiHashMap& map) {
+    return stout::heapFootprint(map.entries_) +
+      stout::heapFootprint(map.values_);
+  }
+
+ private:
+  typedef std::reference_wrapper<const Value> ValueReference;
+
+  struct ValueReferenceHash {
+    size_t operator()(const ValueReference& value) const {
+      return ValueHash()(value.get());
+    }
+  };
+
+  struct ValueReferenceEqual {
+    bool operator()(
+        const ValueReference& left,
+        const ValueReference& right) const {
+      return left.get() == right.get();
+    }
+  };
+
+  // Rebuilds the index of the values from the entries.
+  void index() {
+    values_.reserve(entries_.size());
+    for (const entry& entry : entries_) {
+      values_.emplace(std::cref(entry.second), &entry.first);
+    }
+  }
+
+  // The entries, which don't move once inserted (the standard
+  // guarantees that references to the elements of an unordered map
+  // remain valid until they're erased).
+  map entries_;
+
+  // The index of the values, referring to the value and key of each
+  // entry in 'entries_'.
+  std::unordered_map<
+      ValueReference,
+      const Key*,
+      ValueReferenceHash,
+      ValueReferenceEqual>
+    values_;
+};
+
+////////////////////////////////////////////////////////////////////////
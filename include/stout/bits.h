@@ -35,6 +35,36 @@ inline int countSetBits(uint32_t value) {
 
 ////////////////////////////////////////////////////////////////////////
 
+// Counts set bits from a 64 bit unsigned integer, using the population
+// count instruction where available.
+inline int popcount(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(value);
+#else
+  return countSetBits(static_cast<uint32_t>(value)) +
+    countSetBits(static_cast<uint32_t>(value >> 32));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// Returns the index of the lowest set bit of a 64 bit unsigned
+// integer, which must not be 0.
+inline int countTrailingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(value);
+#else
+  int count = 0;
+  while ((value & 1) == 0) {
+    value >>= 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////
+
 } // namespace bits
 
 ////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,263 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "stout/error.h"
+#include "stout/try.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// A Bloom filter is a compact, probabilistic set that can tell that an
+// element is definitely not in the set, or that it may be. It's useful
+// as a pre-check before a more expensive lookup, e.g., of a large
+// 'hashset' or of a file on disk.
+//
+// This is a "split block" Bloom filter: every element maps to a single
+// 32 byte block (so at most one cache line is touched per operation)
+// in which it sets one bit in each of the block's eight 32 bit words.
+// The eight words are independent so the compiler can vectorize both
+// 'add' and 'mayContain'. Compared to a classic Bloom filter this uses
+// slightly more space for the same false positive rate but is much
+// faster.
+//
+// The 'Hash' of an element is mixed before use, so hashes with poor
+// distribution (e.g., 'std::hash<int>') are fine, but the same 'Hash'
+// must be used when parsing a serialized filter.
+template <typename T, typename Hash = std::hash<T>>
+class BloomFilter {
+ public:
+  // Creates a filter sized for 'elements' elements that has at most
+  // (about) the given false positive rate once they've been added,
+  // which must be in (0, 1).
+  BloomFilter(size_t elements, double falsePositiveRate)
+    : blocks(std::max<size_t>(1, size(elements, falsePositiveRate))) {}
+
+  // Parses a filter from the output of 'serialize'.
+  static Try<BloomFilter> parse(const std::string& data) {
+    if (data.size() < HEADER ||
+        data.compare(0, MAGIC.size(), MAGIC) != 0) {
+      return Error("Not a serialized BloomFilter");
+    }
+
+    const uint64_t count = decode(data, MAGIC.size());
+
+    if (count == 0 || (data.size() - HEADER) / sizeof(Block) != count ||
+        (data.size() - HEADER) % sizeof(Block) != 0) {
+      return Error(
+          "Expecting " + std::to_string(count) + " blocks in serialized"
+          " BloomFilter of " + std::to_string(data.size()) + " bytes");
+    }
+
+    BloomFilter filter;
+    filter.blocks.resize(count);
+
+    size_t offset = HEADER;
+    for (Block& block : filter.blocks) {
+      for (uint32_t& word : block.words) {
+        word = static_cast<uint32_t>(decode(data, offset, sizeof(word)));
+        offset += sizeof(word);
+      }
+    }
+
+    return filter;
+  }
+
+  void add(const T& t) {
+    const uint64_t hash = mix(Hash()(t));
+
+    Block& block = blocks[index(hash)];
+    const Block mask = this->mask(static_cast<uint32_t>(hash));
+
+    for (size_t i = 0; i < WORDS; i++) {
+      block.words[i] |= mask.words[i];
+    }
+  }
+
+  // Returns false if 't' was definitely never added, or true if it
+  // might have been.
+  bool mayContain(const T& t) const {
+    const uint64_t hash = mix(Hash()(t));
+
+    const Block& block = blocks[index(hash)];
+    const Block mask = this->mask(static_cast<uint32_t>(hash));
+
+    // NOTE: We check all of the words (rather than returning early)
+    // so that the loop can be vectorized.
+    uint32_t missing = 0;
+    for (size_t i = 0; i < WORDS; i++) {
+      missing |= ~block.words[i] & mask.words[i];
+    }
+
+    return missing == 0;
+  }
+
+  // Returns the size of the filter in bytes.
+  size_t bytes() const {
+    return blocks.size() * sizeof(Block);
+  }
+
+  // Serializes the filter into a (little endian) byte string that can
+  // be parsed with 'parse'.
+  std::string serialize() const {
+    std::string data = MAGIC;
+    data.reserve(HEADER + bytes());
+
+    encode(&data, blocks.size(), sizeof(uint64_t));
+
+    for (const Block& block : blocks) {
+      for (uint32_t word : block.words) {
+        encode(&data, word, sizeof(word));
+      }
+    }
+
+    return data;
+  }
+
+ private:
+  static constexpr size_t WORDS = 8;
+
+  struct alignas(32) Block {
+    uint32_t words[WORDS] = {};
+  };
+
+  static const std::string MAGIC;
+  static constexpr size_t HEADER = 8 + sizeof(uint64_t);
+
+  BloomFilter() {}
+
+  // Returns the number of blocks needed for 'elements' elements at the
+  // given false positive rate by searching for the largest number of
+  // elements per block that has that rate. The number of elements in
+  // a block is Poisson distributed, which is why a blocked filter
+  // needs more space than a classic one, see "Cache-, Hash- and
+  // Space-Efficient Bloom Filters" by Putze et al.
+  static size_t size(size_t elements, double falsePositiveRate) {
+    CHECK(falsePositiveRate > 0.0 && falsePositiveRate < 1.0)
+      << "Invalid BloomFilter false positive rate " << falsePositiveRate;
+
+    double low = 0.0;
+    double high = 8.0 * sizeof(Block);
+
+    for (int i = 0; i < 64; i++) {
+      const double load = (low + high) / 2;
+      if (rate(load) <= falsePositiveRate) {
+        low = load;
+      } else {
+        high = load;
+      }
+    }
+
+    // NOTE: 'low' is 0 (and 'blocks' infinite) for a rate too small
+    // to be reached by any load we can represent.
+    const double blocks = std::ceil(static_cast<double>(elements) / low);
+
+    CHECK(blocks < static_cast<double>(
+        std::numeric_limits<size_t>::max() / sizeof(Block)))
+      << "BloomFilter for " << elements << " elements with a false"
+      << " positive rate of " << falsePositiveRate << " is too large";
+
+    return static_cast<size_t>(blocks);
+  }
+
+  // Returns the false positive rate with on average 'load' elements per
+  // block: a block with k elements has a bit set in each word with
+  // probability 1 - (31/32)^k.
+  static double rate(double load) {
+    const int count = static_cast<int>(load + 10 * std::sqrt(load) + 10);
+
+    double poisson = std::exp(-load);
+    double result = 0.0;
+
+    for (int k = 0; k <= count; k++) {
+      if (k > 0) {
+        poisson *= load / k;
+      }
+      result += poisson * std::pow(1.0 - std::pow(31.0 / 32.0, k), WORDS);
+    }
+
+    return result;
+  }
+
+  // Finalizer from MurmurHash3 so that the bits we use from the hash
+  // are well distributed even if 'Hash' is the identity.
+  static uint64_t mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  // Maps the upper 32 bits of the hash onto a block without division.
+  size_t index(uint64_t hash) const {
+    return static_cast<size_t>(((hash >> 32) * blocks.size()) >> 32);
+  }
+
+  // Picks one bit in each word using the lower 32 bits of the hash.
+  static Block mask(uint32_t hash) {
+    static constexpr uint32_t SALT[WORDS] = {
+        0x47b6137bU,
+        0x44974d91U,
+        0x8824ad5bU,
+        0xa2b7289dU,
+        0x705495c7U,
+        0x2df1424bU,
+        0x9efc4947U,
+        0x5c6bfb31U};
+
+    Block mask;
+    for (size_t i = 0; i < WORDS; i++) {
+      mask.words[i] = uint32_t(1) << ((hash * SALT[i]) >> 27);
+    }
+    return mask;
+  }
+
+  static void encode(std::string* data, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+      data->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+  }
+
+  static uint64_t decode(
+      const std::string& data,
+      size_t offset,
+      size_t bytes = sizeof(uint64_t)) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+      value |= uint64_t(static_cast<unsigned char>(data[offset + i]))
+        << (8 * i);
+    }
+    return value;
+  }
+
+  std::vector<Block> blocks;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Hash>
+const std::string BloomFilter<T, Hash>::MAGIC = "STOUTBF1";
+
+////////////////////////////////////////////////////////////////////////
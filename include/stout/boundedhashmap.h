@@ -12,9 +12,12 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <utility>
 
+#include "stout/cachestats.h"
 #include "stout/check.h"
+#include "stout/footprint.h"
 #include "stout/hashmap.h"
 #include "stout/option.h"
 
@@ -34,6 +37,26 @@ class BoundedHashMap {
   BoundedHashMap(size_t capacity)
     : capacity_(capacity) {}
 
+  // Starts recording hits and misses of 'get' and 'contains' as well
+  // as insertions and evictions, see 'CacheStats'. Statistics aren't
+  // recorded by default since estimating the hit rate of a larger
+  // capacity requires remembering as many evicted keys as the
+  // capacity of the map.
+  void enableStats() {
+    if (!recorder_) {
+      recorder_.reset(
+          new CacheStatsRecorder<Key, typename map::hasher>(capacity_));
+    }
+  }
+
+  // Returns a snapshot of the statistics if they're being recorded.
+  Option<CacheStats> stats() const {
+    if (recorder_) {
+      return recorder_->stats();
+    }
+    return None();
+  }
+
   // NOTE: We don't provide `operator[]`, unlike LinkedHashMap,
   // because it would be difficult to implement correctly for bounded
   // maps with zero capacity.
@@ -54,19 +77,35 @@ class BoundedHashMap {
       // invalidate iterators that reference other entries.
       if (keys_.size() > capacity_) {
         typename list::iterator firstEntry = entries_.begin();
+        if (recorder_) {
+          recorder_->evict(firstEntry->first);
+        }
         keys_.erase(firstEntry->first);
         entries_.erase(firstEntry);
 
         CHECK(keys_.size() == capacity_);
       }
+
+      // NOTE: Only insertions count as a "use" since they alone
+      // determine the eviction order.
+      if (recorder_) {
+        recorder_->insert(key);
+      }
     } else {
       keys_[key]->second = value;
     }
   }
 
   Option<Value> get(const Key& key) const {
-    if (keys_.contains(key)) {
-      return keys_.at(key)->second;
+    typename map::const_iterator i = keys_.find(key);
+    if (i != keys_.end()) {
+      if (recorder_) {
+        recorder_->hit(key);
+      }
+      return i->second->second;
+    }
+    if (recorder_) {
+      recorder_->miss(key);
     }
     return None();
   }
@@ -80,6 +119,14 @@ class BoundedHashMap {
   }
 
   bool contains(const Key& key) const {
+    if (recorder_) {
+      if (keys_.contains(key)) {
+        recorder_->hit(key);
+        return true;
+      }
+      recorder_->miss(key);
+      return false;
+    }
     return keys_.contains(key);
   }
 
@@ -89,6 +136,10 @@ class BoundedHashMap {
       keys_.erase(key);
       entries_.erase(entry);
 
+      if (recorder_) {
+        recorder_->erase(key);
+      }
+
       return 1;
     }
     return 0;
@@ -125,6 +176,11 @@ class BoundedHashMap {
   }
 
   void clear() {
+    if (recorder_) {
+      foreach (const entry& entry, entries_) {
+        recorder_->erase(entry.first);
+      }
+    }
     entries_.clear();
     keys_.clear();
   }
@@ -146,10 +202,22 @@ class BoundedHashMap {
     return entries_.cend();
   }
 
+  // Estimates the heap used by the entries and the index, see
+  // stout/footprint.h.
+  friend size_t heapFootprint(const BoundedHashMap& map) {
+    return stout::heapFootprint(map.entries_) +
+      stout::heapFootprint(map.keys_);
+  }
+
  private:
   size_t capacity_;
   list entries_; // Key-value pairs ordered by insertion order.
   map keys_; // Map from key to "pointer" to key's location in list.
+
+  // Statistics, if enabled. Recording is not a logical mutation of
+  // the map so it's allowed from 'const' lookups.
+  mutable std::unique_ptr<CacheStatsRecorder<Key, typename map::hasher>>
+    recorder_;
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -14,15 +14,24 @@
 
 #include <glog/logging.h>
 
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 
+#include "cachestats.h"
+#include "duration.h"
+#include "error.h"
+#include "footprint.h"
 #include "none.h"
+#include "notification.h"
 #include "option.h"
+#include "try.h"
 
 ////////////////////////////////////////////////////////////////////////
 
@@ -40,6 +49,9 @@ std::ostream& operator<<(std::ostream& stream, const Cache<Key, Value>& c);
 
 // Provides a least-recently used (LRU) cache of some predefined
 // capacity. A "write" and a "read" both count as uses.
+//
+// All operations are synchronized so a single cache can be shared
+// between threads. See 'GetOrLoad' for coalescing concurrent misses.
 template <typename Key, typename Value>
 class Cache {
  public:
@@ -52,44 +64,148 @@ class Cache {
   explicit Cache(size_t _capacity)
     : capacity(_capacity) {}
 
-  void put(const Key& key, const Value& value) {
-    typename map::iterator i = values.find(key);
-    if (i == values.end()) {
-      insert(key, value);
-    } else {
-      (*i).second.first = value;
-      use(i);
+  // A cache that also remembers failed loads from 'GetOrLoad' for
+  // 'errorTtl' (negative caching). At most 'capacity' failures are
+  // remembered at once, independently of the cached values.
+  Cache(size_t _capacity, const Duration& _errorTtl)
+    : capacity(_capacity),
+      errorTtl(std::chrono::nanoseconds(_errorTtl.ns())) {}
+
+  // Starts recording hits, misses, etc, see 'stats'. The recently
+  // evicted keys that are remembered in order to estimate the hit
+  // rate of larger capacities cost as much memory as the keys in the
+  // cache, hence statistics are not recorded by default.
+  void enableStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!recorder) {
+      recorder.reset(new CacheStatsRecorder<Key>(capacity));
     }
   }
 
-  Option<Value> get(const Key& key) {
-    typename map::iterator i = values.find(key);
-
-    if (i != values.end()) {
-      use(i);
-      return (*i).second.first;
+  // Returns a snapshot of the statistics if they're being recorded.
+  Option<CacheStats> stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (recorder) {
+      return recorder->stats();
     }
-
     return None();
   }
 
+  void put(const Key& key, const Value& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    invalidate(key);
+    _put(key, value);
+  }
+
+  Option<Value> get(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return _get(key);
+  }
+
   Option<Value> erase(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    invalidate(key);
+    forget(key);
+
     typename map::iterator i = values.find(key);
 
     if (i != values.end()) {
       Value value = i->second.first;
       keys.erase(i->second.second);
       values.erase(i);
+      if (recorder) {
+        recorder->erase(key);
+      }
       return value;
     }
 
     return None();
   }
 
+  // Returns the cached value for 'key', or invokes 'loader' (a
+  // callable returning 'Try<Value>') to produce it on a miss.
+  //
+  // Concurrent misses for the same key are coalesced: only the first
+  // caller invokes 'loader' while the rest wait for its result rather
+  // than all hitting the backing store at once. A successful result
+  // is cached like 'put'; an error is returned to every waiter and,
+  // if this cache was constructed with an error TTL, returned to
+  // later callers without invoking 'loader' until the TTL elapses.
+  // If 'loader' throws, waiters get an error and the exception is
+  // rethrown to the caller that invoked it. A 'put' or 'erase' of
+  // 'key' while 'loader' runs takes precedence over its result,
+  // which is then returned but not cached.
+  //
+  // NOTE: 'loader' is invoked without holding any lock so it may
+  // block or use this cache, except for calling 'GetOrLoad' for the
+  // same key which would deadlock.
+  template <typename F>
+  Try<Value> GetOrLoad(const Key& key, F&& loader) {
+    std::shared_ptr<Load> load;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      Option<Value> value = _get(key);
+      if (value.isSome()) {
+        return value.get();
+      }
+
+      typename failure_map::iterator failure = failures.find(key);
+      if (failure != failures.end()) {
+        if (clock::now() < failure->second.expires) {
+          return failure->second.error;
+        }
+        forget(key);
+        if (recorder) {
+          recorder->expire(key);
+        }
+      }
+
+      typename load_map::iterator i = loads.find(key);
+      if (i != loads.end()) {
+        load = i->second;
+      } else {
+        loads.emplace(key, std::make_shared<Load>());
+      }
+    }
+
+    if (load) {
+      // Another caller is already loading this key, share its result.
+      return load->result.Wait().get();
+    }
+
+    Try<Value> result = Error("Loader threw an exception");
+
+    try {
+      result = loader();
+    } catch (...) {
+      // Don't leave the waiters (and later callers) blocked forever.
+      complete(key, result, false);
+      throw;
+    }
+
+    complete(key, result, true);
+
+    return result;
+  }
+
   size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex);
     return keys.size();
   }
 
+  // Estimates the heap used by the cached values and failures, see
+  // stout/footprint.h.
+  friend size_t heapFootprint(const Cache& cache) {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    return stout::heapFootprint(cache.values) +
+      stout::heapFootprint(cache.keys) +
+      stout::heapFootprint(cache.failures) +
+      stout::heapFootprint(cache.failed);
+  }
+
  private:
   // Not copyable, not assignable.
   Cache(const Cache&);
@@ -100,6 +216,124 @@ class Cache {
       std::ostream& stream,
       const Cache<Key, Value>& c);
 
+  typedef std::chrono::steady_clock clock;
+
+  // An in-progress 'GetOrLoad' whose result is shared by all of its
+  // callers, and whether a 'put' or 'erase' of its key happened while
+  // it was in progress, i.e., whether its result is already stale.
+  struct Load {
+    stout::Notification<Option<Try<Value>>> result;
+    bool invalidated = false;
+  };
+
+  typedef std::unordered_map<Key, std::shared_ptr<Load>> load_map;
+
+  // A failed load and when it expires, plus a "pointer" into the
+  // list of failed keys. Since every failure has the same TTL that
+  // list is ordered by expiration as well as by insertion.
+  struct Failure {
+    Error error;
+    clock::time_point expires;
+    typename list::iterator i;
+
+    friend size_t heapFootprint(const Failure& failure) {
+      return stout::heapFootprint(failure.error.message);
+    }
+  };
+
+  typedef std::unordered_map<Key, Failure> failure_map;
+
+  // Finishes the in-progress load of 'key' by notifying its waiters
+  // of 'result' and, if 'store' and it hasn't been invalidated,
+  // caching the value or remembering the failure.
+  void complete(const Key& key, const Try<Value>& result, bool store) {
+    std::shared_ptr<Load> load;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      typename load_map::iterator i = loads.find(key);
+      CHECK(i != loads.end());
+      load = std::move(i->second);
+      loads.erase(i);
+
+      if (store && !load->invalidated) {
+        if (result.isSome()) {
+          _put(key, result.get());
+        } else if (errorTtl > clock::duration::zero() && capacity > 0) {
+          remember(key, Error(result.error()));
+        }
+      }
+    }
+
+    load->result.Notify(result);
+  }
+
+  // Marks any in-progress load of 'key' as stale so its result won't
+  // overwrite a more recent 'put' or 'erase'. Expects 'mutex' to be
+  // held.
+  void invalidate(const Key& key) {
+    typename load_map::iterator i = loads.find(key);
+    if (i != loads.end()) {
+      i->second->invalidated = true;
+    }
+  }
+
+  // Expects 'mutex' to be held.
+  void _put(const Key& key, const Value& value) {
+    forget(key);
+
+    typename map::iterator i = values.find(key);
+    if (i == values.end()) {
+      insert(key, value);
+    } else {
+      (*i).second.first = value;
+      use(i);
+    }
+  }
+
+  // Expects 'mutex' to be held.
+  Option<Value> _get(const Key& key) {
+    typename map::iterator i = values.find(key);
+
+    if (i != values.end()) {
+      if (recorder) {
+        recorder->hit(key);
+      }
+      use(i);
+      return (*i).second.first;
+    }
+
+    if (recorder) {
+      recorder->miss(key);
+    }
+
+    return None();
+  }
+
+  // Remembers a failed load of 'key', evicting the failure closest
+  // to expiring if we're already remembering 'capacity' of them.
+  void remember(const Key& key, const Error& error) {
+    forget(key);
+
+    if (failed.size() == capacity) {
+      forget(failed.front());
+    }
+
+    typename list::iterator i = failed.insert(failed.end(), key);
+
+    failures.emplace(key, Failure{error, clock::now() + errorTtl, i});
+  }
+
+  // Forgets any failed load of 'key'.
+  void forget(const Key& key) {
+    typename failure_map::iterator i = failures.find(key);
+    if (i != failures.end()) {
+      failed.erase(i->second.i);
+      failures.erase(i);
+    }
+  }
+
   // Insert key/value into the cache.
   void insert(const Key& key, const Value& value) {
     if (keys.size() == capacity) {
@@ -111,10 +345,18 @@ class Cache {
 
     // Save key/value and "pointer" into lru list.
     values.insert(std::make_pair(key, std::make_pair(value, i)));
+
+    if (recorder) {
+      recorder->insert(key);
+    }
   }
 
   // Updates the LRU ordering in the cache for the given iterator.
   void use(const typename map::iterator& i) {
+    if (recorder) {
+      recorder->use(i->first);
+    }
+
     // Move the "pointer" to the end of the lru list.
     keys.splice(keys.end(), keys, (*i).second.second);
 
@@ -126,6 +368,9 @@ class Cache {
   void evict() {
     const typename map::iterator i = values.find(keys.front());
     CHECK(i != values.end());
+    if (recorder) {
+      recorder->evict(i->first);
+    }
     values.erase(i);
     keys.pop_front();
   }
@@ -133,17 +378,36 @@ class Cache {
   // Size of the cache.
   const size_t capacity;
 
+  // How long failed loads are remembered, zero if they aren't.
+  const clock::duration errorTtl = clock::duration::zero();
+
+  // Protects all of the state below.
+  mutable std::mutex mutex;
+
   // Cache of values and "pointers" into the least-recently used list.
   map values;
 
   // Keys ordered by least-recently used.
   list keys;
+
+  // Loads currently in progress via 'GetOrLoad'.
+  load_map loads;
+
+  // Statistics, if enabled.
+  std::unique_ptr<CacheStatsRecorder<Key>> recorder;
+
+  // Failed loads still within their TTL.
+  failure_map failures;
+
+  // Keys of failed loads ordered by expiration.
+  list failed;
 };
 
 ////////////////////////////////////////////////////////////////////////
 
 template <typename Key, typename Value>
 std::ostream& operator<<(std::ostream& stream, const Cache<Key, Value>& c) {
+  std::lock_guard<std::mutex> lock(c.mutex);
   typename Cache<Key, Value>::list::const_iterator i1;
   for (i1 = c.keys.begin(); i1 != c.keys.end(); i1++) {
     stream << *i1 << ": ";
@@ -0,0 +1,30 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "stout/cachestats.h"
+#include "stout/jsonify.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// Kept separate from stout/cachestats.h so that the caches don't
+// depend on JSON unless their statistics are actually jsonified.
+inline void json(JSON::ObjectWriter* writer, const CacheStats& stats) {
+  writer->field("hits", stats.hits);
+  writer->field("misses", stats.misses);
+  writer->field("inserts", stats.inserts);
+  writer->field("evictions", stats.evictions);
+  writer->field("expirations", stats.expirations);
+  writer->field("hit_rate", stats.hitRate());
+  writer->field("recency", stats.recency);
+}
@@ -0,0 +1,238 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "stout/hash.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// A point in time snapshot of the statistics of a cache (e.g., 'Cache'
+// or 'BoundedHashMap').
+struct CacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t inserts = 0;
+  uint64_t evictions = 0;
+  uint64_t expirations = 0;
+
+  // Histogram of the "recency" of every hit, and of every miss on a
+  // recently evicted key, i.e., how many accesses the cache had seen
+  // since the key was last used (or inserted, for caches like
+  // 'BoundedHashMap' where a hit doesn't change the eviction order).
+  // A key with recency 'r' is a hit in any cache with a capacity
+  // larger than 'r'. Bucket 0 counts a recency of 0 and bucket 'i'
+  // counts recencies in [2^(i-1), 2^i).
+  std::vector<uint64_t> recency;
+
+  double hitRate() const {
+    const uint64_t lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+  }
+
+  // Estimates the hit rate that the same workload would have had
+  // with a cache of the given capacity. This is conservative since
+  // only whole buckets of the histogram are counted, and it can't
+  // see beyond the recently evicted keys that are still remembered
+  // (by default, as many as the capacity of the cache).
+  double estimateHitRate(size_t capacity) const {
+    const uint64_t lookups = hits + misses;
+    if (lookups == 0) {
+      return 0.0;
+    }
+
+    uint64_t estimate = 0;
+    for (size_t i = 0; i < recency.size(); i++) {
+      // The largest recency counted in bucket 'i'.
+      const uint64_t largest = i == 0 ? 0 : (uint64_t(1) << i) - 1;
+      if (largest >= capacity) {
+        break;
+      }
+      estimate += recency[i];
+    }
+
+    return static_cast<double>(estimate) / lookups;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Records the statistics of a cache. The counters are relaxed atomics
+// so 'stats()' can be called from any thread while the cache is in
+// use, but the cache must serialize the calls that record (which it
+// already does to protect its own state).
+//
+// To estimate the hit rate of larger capacities we remember when each
+// key was last used, and when each of the last 'remembered' evicted
+// keys was last used before being evicted (a "ghost" of the key).
+template <typename Key, typename Hash = stout::Hash<Key>>
+class CacheStatsRecorder {
+ public:
+  explicit CacheStatsRecorder(size_t _remembered)
+    : remembered(_remembered) {}
+
+  CacheStatsRecorder(const CacheStatsRecorder&) = delete;
+  CacheStatsRecorder& operator=(const CacheStatsRecorder&) = delete;
+
+  // Records a lookup that found 'key'.
+  void hit(const Key& key) {
+    increment(hits);
+
+    auto i = ticks.find(key);
+    if (i != ticks.end()) {
+      record(clock - i->second);
+    }
+  }
+
+  // Records a lookup that didn't find 'key'.
+  void miss(const Key& key) {
+    increment(misses);
+
+    auto i = ghosts.find(key);
+    if (i != ghosts.end()) {
+      record(clock - i->second.first);
+      evicted.erase(i->second.second);
+      ghosts.erase(i);
+    }
+  }
+
+  // Records a use of 'key' which resets its recency.
+  void use(const Key& key) {
+    ticks[key] = ++clock;
+  }
+
+  void insert(const Key& key) {
+    increment(inserts);
+    use(key);
+  }
+
+  // Records that 'key' was evicted to make room for another key.
+  void evict(const Key& key) {
+    increment(evictions);
+
+    auto i = ticks.find(key);
+    if (i == ticks.end()) {
+      return;
+    }
+
+    if (remembered > 0) {
+      if (evicted.size() == remembered) {
+        ghosts.erase(evicted.front());
+        evicted.pop_front();
+      }
+
+      auto ghost = ghosts.find(key);
+      if (ghost != ghosts.end()) {
+        evicted.erase(ghost->second.second);
+        ghosts.erase(ghost);
+      }
+
+      ghosts.emplace(
+          key,
+          std::make_pair(i->second, evicted.insert(evicted.end(), key)));
+    }
+
+    ticks.erase(i);
+  }
+
+  // Records that 'key' expired.
+  void expire(const Key& key) {
+    increment(expirations);
+    ticks.erase(key);
+  }
+
+  // Records that 'key' was explicitly erased, which doesn't count as
+  // an eviction.
+  void erase(const Key& key) {
+    ticks.erase(key);
+  }
+
+  CacheStats stats() const {
+    CacheStats stats;
+    stats.hits = hits.load(std::memory_order_relaxed);
+    stats.misses = misses.load(std::memory_order_relaxed);
+    stats.inserts = inserts.load(std::memory_order_relaxed);
+    stats.evictions = evictions.load(std::memory_order_relaxed);
+    stats.expirations = expirations.load(std::memory_order_relaxed);
+
+    // Trim the buckets that have never been used.
+    size_t size = 0;
+    for (size_t i = 0; i < recency.size(); i++) {
+      if (recency[i].load(std::memory_order_relaxed) > 0) {
+        size = i + 1;
+      }
+    }
+
+    stats.recency.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+      stats.recency.push_back(recency[i].load(std::memory_order_relaxed));
+    }
+
+    return stats;
+  }
+
+ private:
+  // Since all of the recording is serialized we don't need an atomic
+  // read-modify-write, just an atomic store so that concurrent reads
+  // in 'stats()' don't race.
+  static void increment(std::atomic<uint64_t>& counter) {
+    counter.store(
+        counter.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  }
+
+  void record(uint64_t distance) {
+    size_t bucket = 0;
+    while (distance != 0) {
+      distance >>= 1;
+      bucket++;
+    }
+    increment(recency[bucket]);
+  }
+
+  const size_t remembered;
+
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  std::atomic<uint64_t> inserts{0};
+  std::atomic<uint64_t> evictions{0};
+  std::atomic<uint64_t> expirations{0};
+
+  // Bucket 'i' counts recencies that are 'i' bits wide.
+  std::array<std::atomic<uint64_t>, 65> recency{};
+
+  // Logical clock that ticks on every use of a key.
+  uint64_t clock = 0;
+
+  // Last use of every key currently in the cache.
+  std::unordered_map<Key, uint64_t, Hash> ticks;
+
+  // Last use of recently evicted keys, plus a "pointer" into the list
+  // of evicted keys ordered from least to most recently evicted.
+  std::unordered_map<
+      Key,
+      std::pair<uint64_t, typename std::list<Key>::iterator>,
+      Hash>
+      ghosts;
+  std::list<Key> evicted;
+};
+
+////////////////////////////////////////////////////////////////////////
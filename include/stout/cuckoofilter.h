@@ -0,0 +1,353 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "stout/error.h"
+#include "stout/try.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// A cuckoo filter is, like a 'BloomFilter', a compact probabilistic
+// set that answers "definitely not present" or "maybe present", but
+// it also supports removing elements, e.g., for a pre-check in front
+// of a set that shrinks as well as grows.
+//
+// Each element is reduced to a 16 bit fingerprint that is stored in
+// one of two candidate buckets of four slots; adding an element to a
+// full bucket relocates ("kicks") existing fingerprints to their
+// alternate bucket. A bucket is a single 64 bit word of four 16 bit
+// slots so a lookup compares all four slots at once and touches at
+// most two words.
+//
+// The false positive rate is at most 2 * 4 / 2^16, i.e., about
+// 0.00012, and uses 2 bytes per element (at a 95% load factor, and
+// up to twice that since the number of buckets is a power of two).
+// A filter only guarantees to fit the number of elements it was
+// created for; beyond that 'add' may fail. Only remove elements that
+// were added, otherwise a different element sharing the fingerprint
+// may be removed instead.
+template <typename T, typename Hash = std::hash<T>>
+class CuckooFilter {
+ public:
+  // Creates a filter sized for 'elements' elements.
+  explicit CuckooFilter(size_t elements)
+    : buckets(bucketCount(elements), 0) {}
+
+  // Parses a filter from the output of 'serialize'.
+  static Try<CuckooFilter> parse(const std::string& data) {
+    if (data.size() < HEADER ||
+        data.compare(0, MAGIC.size(), MAGIC) != 0) {
+      return Error("Not a serialized CuckooFilter");
+    }
+
+    size_t offset = MAGIC.size();
+
+    CuckooFilter filter;
+    filter.count = static_cast<size_t>(decode(data, &offset, 8));
+    filter.victim.fingerprint =
+      static_cast<uint16_t>(decode(data, &offset, 2));
+    filter.victim.index = static_cast<size_t>(decode(data, &offset, 8));
+
+    const uint64_t count = decode(data, &offset, 8);
+
+    if (count == 0 || (count & (count - 1)) != 0 ||
+        (data.size() - HEADER) / sizeof(uint64_t) != count ||
+        (data.size() - HEADER) % sizeof(uint64_t) != 0 ||
+        filter.victim.index >= count) {
+      return Error(
+          "Expecting " + std::to_string(count) + " buckets in serialized"
+          " CuckooFilter of " + std::to_string(data.size()) + " bytes");
+    }
+
+    filter.buckets.resize(count);
+    for (uint64_t& bucket : filter.buckets) {
+      bucket = decode(data, &offset, 8);
+    }
+
+    return filter;
+  }
+
+  // Returns false if the filter is full, in which case 't' is not
+  // added (and the filter is left unchanged).
+  bool add(const T& t) {
+    if (victim.fingerprint != 0) {
+      return false;
+    }
+
+    size_t index;
+    uint16_t fingerprint;
+    locate(t, &index, &fingerprint);
+
+    count++;
+
+    place(index, fingerprint);
+
+    return true;
+  }
+
+  // Returns false if 't' is definitely not in the filter, or true if
+  // it might be.
+  bool mayContain(const T& t) const {
+    size_t index;
+    uint16_t fingerprint;
+    locate(t, &index, &fingerprint);
+
+    const size_t other = alternate(index, fingerprint);
+
+    return find(buckets[index], fingerprint) ||
+      find(buckets[other], fingerprint) ||
+      (victim.fingerprint == fingerprint &&
+       (victim.index == index || victim.index == other));
+  }
+
+  // Removes a previously added 't', returning false if it (or rather
+  // its fingerprint) could not be found.
+  bool remove(const T& t) {
+    size_t index;
+    uint16_t fingerprint;
+    locate(t, &index, &fingerprint);
+
+    const size_t other = alternate(index, fingerprint);
+
+    if (victim.fingerprint == fingerprint &&
+        (victim.index == index || victim.index == other)) {
+      victim.fingerprint = 0;
+      count--;
+      return true;
+    }
+
+    if (erase(index, fingerprint) || erase(other, fingerprint)) {
+      count--;
+
+      // Now that there is room, try to put the victim back.
+      if (victim.fingerprint != 0) {
+        const Victim previous = victim;
+        victim.fingerprint = 0;
+        count--;
+        reinsert(previous.fingerprint, previous.index);
+      }
+
+      return true;
+    }
+
+    return false;
+  }
+
+  // Returns the number of elements in the filter.
+  size_t size() const {
+    return count;
+  }
+
+  bool empty() const {
+    return count == 0;
+  }
+
+  // Returns the size of the filter in bytes.
+  size_t bytes() const {
+    return buckets.size() * sizeof(uint64_t);
+  }
+
+  // Serializes the filter into a (little endian) byte string that can
+  // be parsed with 'parse'.
+  std::string serialize() const {
+    std::string data = MAGIC;
+    data.reserve(HEADER + bytes());
+
+    encode(&data, count, 8);
+    encode(&data, victim.fingerprint, 2);
+    encode(&data, victim.index, 8);
+    encode(&data, buckets.size(), 8);
+
+    for (uint64_t bucket : buckets) {
+      encode(&data, bucket, 8);
+    }
+
+    return data;
+  }
+
+ private:
+  static constexpr size_t SLOTS = 4;
+  static constexpr size_t MAX_KICKS = 500;
+
+  static constexpr uint64_t LOW = 0x0001000100010001ULL;
+  static constexpr uint64_t HIGH = 0x8000800080008000ULL;
+
+  static const std::string MAGIC;
+  static constexpr size_t HEADER = 8 + 8 + 2 + 8 + 8;
+
+  struct Victim {
+    // Zero if there is no victim.
+    uint16_t fingerprint = 0;
+    size_t index = 0;
+  };
+
+  CuckooFilter() {}
+
+  // Returns a power of two number of buckets that fits 'elements' at a
+  // load factor of 95%, which cuckoo filters with four slots per bucket
+  // reliably reach.
+  static size_t bucketCount(size_t elements) {
+    const size_t needed = static_cast<size_t>(
+        std::ceil(static_cast<double>(elements) / (SLOTS * 0.95)));
+    size_t count = 1;
+    while (count < needed) {
+      count <<= 1;
+    }
+    return count;
+  }
+
+  // Finalizer from MurmurHash3 so that the bits we use from the hash
+  // are well distributed even if 'Hash' is the identity.
+  static uint64_t mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  void locate(const T& t, size_t* index, uint16_t* fingerprint) const {
+    const uint64_t hash = mix(Hash()(t));
+
+    *index = static_cast<size_t>(hash) & (buckets.size() - 1);
+
+    // Use the top bits for the fingerprint, skipping zero which marks
+    // an empty slot.
+    *fingerprint = static_cast<uint16_t>(hash >> 48);
+    if (*fingerprint == 0) {
+      *fingerprint = 1;
+    }
+  }
+
+  // The alternate bucket only depends on the current bucket and the
+  // fingerprint, so fingerprints can be relocated without the element.
+  size_t alternate(size_t index, uint16_t fingerprint) const {
+    return (index ^ static_cast<size_t>(fingerprint * 0x5bd1e995ULL)) &
+      (buckets.size() - 1);
+  }
+
+  static uint16_t get(uint64_t bucket, size_t slot) {
+    return static_cast<uint16_t>(bucket >> (16 * slot));
+  }
+
+  static void set(uint64_t* bucket, size_t slot, uint16_t fingerprint) {
+    *bucket &= ~(uint64_t(0xffff) << (16 * slot));
+    *bucket |= uint64_t(fingerprint) << (16 * slot);
+  }
+
+  // Returns whether any of the slots in 'bucket' is zero, comparing all
+  // of them at once, see "Determine if a word has a zero byte" in
+  // https://graphics.stanford.edu/~seander/bithacks.html.
+  static bool zero(uint64_t bucket) {
+    return ((bucket - LOW) & ~bucket & HIGH) != 0;
+  }
+
+  static bool find(uint64_t bucket, uint16_t fingerprint) {
+    return zero(bucket ^ (fingerprint * LOW));
+  }
+
+  bool insert(size_t index, uint16_t fingerprint) {
+    for (size_t slot = 0; slot < SLOTS; slot++) {
+      if (get(buckets[index], slot) == 0) {
+        set(&buckets[index], slot, fingerprint);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool erase(size_t index, uint16_t fingerprint) {
+    for (size_t slot = 0; slot < SLOTS; slot++) {
+      if (get(buckets[index], slot) == fingerprint) {
+        set(&buckets[index], slot, 0);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Stores 'fingerprint' in bucket 'index' or its alternate, or else
+  // relocates fingerprints until one fits. The last fingerprint that
+  // was kicked out is kept as the "victim" so that nothing that was
+  // added before is lost; a filter with a victim is full.
+  void place(size_t index, uint16_t fingerprint) {
+    if (insert(index, fingerprint) ||
+        insert(alternate(index, fingerprint), fingerprint)) {
+      return;
+    }
+
+    for (size_t kicks = 0; kicks < MAX_KICKS; kicks++) {
+      const size_t slot = kicks % SLOTS;
+      const uint16_t kicked = get(buckets[index], slot);
+      set(&buckets[index], slot, fingerprint);
+
+      fingerprint = kicked;
+      index = alternate(index, fingerprint);
+
+      if (insert(index, fingerprint)) {
+        return;
+      }
+    }
+
+    victim.fingerprint = fingerprint;
+    victim.index = index;
+  }
+
+  // Re-adds a fingerprint that is already known to belong in 'index'
+  // (or its alternate bucket). Since the room that was just made may
+  // be in neither of those this relocates fingerprints like 'add'.
+  void reinsert(uint16_t fingerprint, size_t index) {
+    count++;
+    place(index, fingerprint);
+  }
+
+  static void encode(std::string* data, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+      data->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+  }
+
+  static uint64_t decode(
+      const std::string& data,
+      size_t* offset,
+      size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+      value |= uint64_t(static_cast<unsigned char>(data[*offset + i]))
+        << (8 * i);
+    }
+    *offset += bytes;
+    return value;
+  }
+
+  size_t count = 0;
+  Victim victim;
+
+  // Each bucket holds 'SLOTS' 16 bit fingerprints, zero when empty.
+  std::vector<uint64_t> buckets;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Hash>
+const std::string CuckooFilter<T, Hash>::MAGIC = "STOUTCF1";
+
+////////////////////////////////////////////////////////////////////////
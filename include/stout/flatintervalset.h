@@ -0,0 +1,494 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stout/interval.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// An alternative to 'IntervalSet' with the same interface that stores
+// its intervals in a single sorted vector rather than a tree. This is
+// considerably faster, and uses less memory, for the typical sets of
+// tens of intervals (e.g., port ranges) since lookups are a binary
+// search over contiguous memory and operations on whole sets are
+// linear merges into a single allocation. Adding or removing a single
+// interval is linear in the number of intervals though, so prefer
+// 'IntervalSet' for sets with many thousands of intervals that are
+// modified one interval at a time.
+//
+// Like 'IntervalSet', adjacent and overlapping intervals are joined,
+// e.g., adding [1,3) and [3,5) results in the single interval [1,5).
+//
+// NOTE: Only integral types are supported since those are the only
+// types for which a single value can be represented as an interval.
+template <typename T>
+class FlatIntervalSet {
+  static_assert(
+      std::is_integral<T>::value,
+      "FlatIntervalSet only supports integral types");
+
+ public:
+  typedef typename std::vector<Interval<T>>::const_iterator iterator;
+  typedef typename std::vector<Interval<T>>::const_iterator const_iterator;
+
+  FlatIntervalSet() {}
+
+  explicit FlatIntervalSet(const T& value) {
+    add(value, value + 1);
+  }
+
+  explicit FlatIntervalSet(const Interval<T>& interval) {
+    add(interval.lower(), interval.upper());
+  }
+
+  FlatIntervalSet(const Bound<T>& lower, const Bound<T>& upper) {
+    *this += (lower, upper);
+  }
+
+  explicit FlatIntervalSet(const IntervalSet<T>& set) {
+    intervals.reserve(set.intervalCount());
+    for (const Interval<T>& interval : set) {
+      intervals.push_back(interval);
+    }
+  }
+
+  // Checks if an element is in this set.
+  bool contains(const T& value) const {
+    const_iterator i = find(value);
+    return i != intervals.end() && i->lower() <= value;
+  }
+
+  // Checks if an interval is in this set.
+  bool contains(const Interval<T>& interval) const {
+    if (empty(interval)) {
+      return true;
+    }
+
+    const_iterator i = find(interval.lower());
+    return i != intervals.end() &&
+      i->lower() <= interval.lower() &&
+      interval.upper() <= i->upper();
+  }
+
+  // Checks if an interval set is a subset of this set.
+  bool contains(const FlatIntervalSet<T>& set) const {
+    const_iterator i = intervals.begin();
+
+    for (const Interval<T>& interval : set.intervals) {
+      // Skip our intervals that end before this one.
+      while (i != intervals.end() && i->upper() <= interval.lower()) {
+        ++i;
+      }
+
+      // Since intervals are joined, a contained interval must be
+      // contained by a single one of our intervals.
+      if (i == intervals.end() ||
+          i->lower() > interval.lower() ||
+          i->upper() < interval.upper()) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Checks if this set intersects with an interval.
+  bool intersects(const Interval<T>& interval) const {
+    if (empty(interval)) {
+      return false;
+    }
+
+    const_iterator i = find(interval.lower());
+    return i != intervals.end() && i->lower() < interval.upper();
+  }
+
+  // Checks if this set intersects with another interval set.
+  bool intersects(const FlatIntervalSet<T>& set) const {
+    const_iterator i = intervals.begin();
+    const_iterator j = set.intervals.begin();
+
+    while (i != intervals.end() && j != set.intervals.end()) {
+      if (i->upper() <= j->lower()) {
+        ++i;
+      } else if (j->upper() <= i->lower()) {
+        ++j;
+      } else {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Returns the number of intervals in this set.
+  size_t intervalCount() const {
+    return intervals.size();
+  }
+
+  // Returns the number of elements in this set.
+  size_t size() const {
+    size_t size = 0;
+    for (const Interval<T>& interval : intervals) {
+      size += static_cast<size_t>(interval.upper() - interval.lower());
+    }
+    return size;
+  }
+
+  bool empty() const {
+    return intervals.empty();
+  }
+
+  void clear() {
+    intervals.clear();
+  }
+
+  // Support for iteration over the intervals in ascending order.
+  const_iterator begin() const {
+    return intervals.begin();
+  }
+
+  const_iterator end() const {
+    return intervals.end();
+  }
+
+  // Converts this set into an 'IntervalSet'.
+  IntervalSet<T> toIntervalSet() const {
+    IntervalSet<T> set;
+    for (const Interval<T>& interval : intervals) {
+      set += interval;
+    }
+    return set;
+  }
+
+  // Overloaded operators.
+  bool operator==(const FlatIntervalSet<T>& that) const {
+    return intervals == that.intervals;
+  }
+
+  bool operator!=(const FlatIntervalSet<T>& that) const {
+    return !(*this == that);
+  }
+
+  FlatIntervalSet<T>& operator+=(const T& value) {
+    add(value, value + 1);
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator+=(const Interval<T>& interval) {
+    add(interval.lower(), interval.upper());
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator+=(const FlatIntervalSet<T>& set) {
+    if (set.intervals.size() == 1) {
+      return *this += set.intervals.front();
+    }
+
+    std::vector<Interval<T>> result;
+    result.reserve(intervals.size() + set.intervals.size());
+
+    const_iterator i = intervals.begin();
+    const_iterator j = set.intervals.begin();
+
+    // Merge both sorted sequences, joining each interval to the last
+    // one in the result when they overlap or are adjacent.
+    while (i != intervals.end() || j != set.intervals.end()) {
+      const Interval<T>& next =
+        (j == set.intervals.end() ||
+         (i != intervals.end() && i->lower() < j->lower()))
+          ? *i++
+          : *j++;
+
+      if (!result.empty() && next.lower() <= result.back().upper()) {
+        if (next.upper() > result.back().upper()) {
+          result.back() = interval(result.back().lower(), next.upper());
+        }
+      } else {
+        result.push_back(next);
+      }
+    }
+
+    intervals = std::move(result);
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator-=(const T& value) {
+    subtract(value, value + 1);
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator-=(const Interval<T>& interval) {
+    subtract(interval.lower(), interval.upper());
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator-=(const FlatIntervalSet<T>& set) {
+    if (set.intervals.size() == 1) {
+      return *this -= set.intervals.front();
+    }
+
+    std::vector<Interval<T>> result;
+    result.reserve(intervals.size() + set.intervals.size());
+
+    const_iterator j = set.intervals.begin();
+
+    for (const Interval<T>& interval : intervals) {
+      T lower = interval.lower();
+
+      // Skip the intervals to subtract that end before this one.
+      while (j != set.intervals.end() && j->upper() <= lower) {
+        ++j;
+      }
+
+      // Cut out every interval to subtract that starts within this
+      // one; the last one may extend into our next interval so we
+      // don't skip past it.
+      const_iterator k = j;
+      while (k != set.intervals.end() && k->lower() < interval.upper()) {
+        if (lower < k->lower()) {
+          result.push_back(this->interval(lower, k->lower()));
+        }
+        lower = std::max(lower, k->upper());
+        ++k;
+      }
+
+      if (lower < interval.upper()) {
+        result.push_back(this->interval(lower, interval.upper()));
+      }
+    }
+
+    intervals = std::move(result);
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator&=(const T& value) {
+    intersect(value, value + 1);
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator&=(const Interval<T>& interval) {
+    intersect(interval.lower(), interval.upper());
+    return *this;
+  }
+
+  FlatIntervalSet<T>& operator&=(const FlatIntervalSet<T>& set) {
+    std::vector<Interval<T>> result;
+    result.reserve(intervals.size() + set.intervals.size());
+
+    const_iterator i = intervals.begin();
+    const_iterator j = set.intervals.begin();
+
+    while (i != intervals.end() && j != set.intervals.end()) {
+      const T lower = std::max(i->lower(), j->lower());
+      const T upper = std::min(i->upper(), j->upper());
+
+      if (lower < upper) {
+        result.push_back(interval(lower, upper));
+      }
+
+      // Advance whichever interval ends first.
+      if (i->upper() < j->upper()) {
+        ++i;
+      } else {
+        ++j;
+      }
+    }
+
+    intervals = std::move(result);
+    return *this;
+  }
+
+ private:
+  template <typename X>
+  friend std::ostream& operator<<(
+      std::ostream& stream,
+      const FlatIntervalSet<X>& set);
+
+  static Interval<T> interval(const T& lower, const T& upper) {
+    return (Bound<T>::closed(lower), Bound<T>::open(upper));
+  }
+
+  static bool empty(const Interval<T>& interval) {
+    return interval.lower() >= interval.upper();
+  }
+
+  // Returns the first interval that ends after 'value', i.e., the
+  // only interval that could contain 'value'.
+  const_iterator find(const T& value) const {
+    return std::upper_bound(
+        intervals.begin(),
+        intervals.end(),
+        value,
+        [](const T& value, const Interval<T>& interval) {
+          return value < interval.upper();
+        });
+  }
+
+  // Adds [lower, upper) to this set.
+  void add(const T& lower, const T& upper) {
+    if (lower >= upper) {
+      return;
+    }
+
+    // The intervals that overlap or are adjacent to [lower, upper)
+    // are in [first, last), all of which get joined into one.
+    typename std::vector<Interval<T>>::iterator first = std::lower_bound(
+        intervals.begin(),
+        intervals.end(),
+        lower,
+        [](const Interval<T>& interval, const T& lower) {
+          return interval.upper() < lower;
+        });
+
+    typename std::vector<Interval<T>>::iterator last = std::upper_bound(
+        first,
+        intervals.end(),
+        upper,
+        [](const T& upper, const Interval<T>& interval) {
+          return upper < interval.lower();
+        });
+
+    if (first == last) {
+      intervals.insert(first, interval(lower, upper));
+      return;
+    }
+
+    *first = interval(
+        std::min(lower, first->lower()),
+        std::max(upper, (last - 1)->upper()));
+
+    intervals.erase(first + 1, last);
+  }
+
+  // Removes [lower, upper) from this set.
+  void subtract(const T& lower, const T& upper) {
+    if (lower >= upper) {
+      return;
+    }
+
+    // The intervals that overlap [lower, upper) are in [first, last).
+    typename std::vector<Interval<T>>::iterator first = std::upper_bound(
+        intervals.begin(),
+        intervals.end(),
+        lower,
+        [](const T& lower, const Interval<T>& interval) {
+          return lower < interval.upper();
+        });
+
+    typename std::vector<Interval<T>>::iterator last = std::lower_bound(
+        first,
+        intervals.end(),
+        upper,
+        [](const Interval<T>& interval, const T& upper) {
+          return interval.lower() < upper;
+        });
+
+    if (first == last) {
+      return;
+    }
+
+    // At most the first and last overlapping intervals have parts
+    // outside of [lower, upper) that we need to keep.
+    const T left = first->lower();
+    const T right = (last - 1)->upper();
+
+    last = intervals.erase(first, last);
+
+    if (right > upper) {
+      last = intervals.insert(last, interval(upper, right));
+    }
+
+    if (left < lower) {
+      intervals.insert(last, interval(left, lower));
+    }
+  }
+
+  // Removes everything outside of [lower, upper) from this set.
+  void intersect(const T& lower, const T& upper) {
+    if (lower >= upper) {
+      intervals.clear();
+      return;
+    }
+
+    typename std::vector<Interval<T>>::iterator first = std::upper_bound(
+        intervals.begin(),
+        intervals.end(),
+        lower,
+        [](const T& lower, const Interval<T>& interval) {
+          return lower < interval.upper();
+        });
+
+    typename std::vector<Interval<T>>::iterator last = std::lower_bound(
+        first,
+        intervals.end(),
+        upper,
+        [](const Interval<T>& interval, const T& upper) {
+          return interval.lower() < upper;
+        });
+
+    intervals.erase(last, intervals.end());
+    intervals.erase(intervals.begin(), first);
+
+    if (!intervals.empty()) {
+      intervals.front() = interval(
+          std::max(lower, intervals.front().lower()),
+          intervals.front().upper());
+      intervals.back() = interval(
+          intervals.back().lower(),
+          std::min(upper, intervals.back().upper()));
+    }
+  }
+
+  // Sorted, disjoint, non-adjacent and non-empty intervals.
+  std::vector<Interval<T>> intervals;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::ostream& operator<<(
+    std::ostream& stream,
+    const FlatIntervalSet<T>& set) {
+  stream << "{";
+  for (const Interval<T>& interval : set.intervals) {
+    stream << interval;
+  }
+  return stream << "}";
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename X>
+FlatIntervalSet<T> operator+(const FlatIntervalSet<T>& set, const X& x) {
+  FlatIntervalSet<T> result(set);
+  result += x;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename X>
+FlatIntervalSet<T> operator-(const FlatIntervalSet<T>& set, const X& x) {
+  FlatIntervalSet<T> result(set);
+  result -= x;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
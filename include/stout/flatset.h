@@ -0,0 +1,402 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Compare>
+size_t intersectScalar(
+    const T* a,
+    size_t na,
+    const T* b,
+    size_t nb,
+    T* out,
+    const Compare& less,
+    bool skewed = false) {
+  size_t i = 0, j = 0, n = 0;
+
+  // Search for each element of the smaller range in the larger one,
+  // skipping ahead exponentially.
+  if (skewed) {
+    const bool small = na < nb;
+    const T* s = small ? a : b;
+    const T* l = small ? b : a;
+    const size_t ns = small ? na : nb;
+    const size_t nl = small ? nb : na;
+
+    for (; i < ns && j < nl; i++) {
+      size_t step = 1;
+      while (j + step < nl && less(l[j + step], s[i])) {
+        j += step;
+        step *= 2;
+      }
+      j = std::lower_bound(
+          l + j,
+          l + std::min(j + step + 1, nl),
+          s[i],
+          less) - l;
+      if (j < nl && !less(s[i], l[j])) {
+        out[n++] = s[i];
+      }
+    }
+
+    return n;
+  }
+
+  while (i < na && j < nb) {
+    if (less(a[i], b[j])) {
+      i++;
+    } else if (less(b[j], a[i])) {
+      j++;
+    } else {
+      out[n++] = a[i];
+      i++;
+      j++;
+    }
+  }
+
+  return n;
+}
+
+
+#ifdef __SSE2__
+// Intersects 4 elements at a time by comparing each block of 4 from
+// 'a' with all rotations of a block of 4 from 'b' and advancing past
+// whichever block has the smaller maximum.
+template <typename T>
+size_t intersectSSE2(
+    const T* a,
+    size_t na,
+    const T* b,
+    size_t nb,
+    T* out,
+    const std::less<T>& less) {
+  static_assert(sizeof(T) == 4, "Expecting 32 bit elements");
+
+  size_t i = 0, j = 0, n = 0;
+
+  while (i + 4 <= na && j + 4 <= nb) {
+    const __m128i va =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+
+    const __m128i matches = _mm_or_si128(
+        _mm_or_si128(
+            _mm_cmpeq_epi32(va, vb),
+            _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+        _mm_or_si128(
+            _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4e)),
+            _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(matches));
+
+    const T amax = a[i + 3];
+    const T bmax = b[j + 3];
+
+    while (mask != 0) {
+      const int k = __builtin_ctz(mask);
+      out[n++] = a[i + k];
+      mask &= mask - 1;
+    }
+
+    if (!less(bmax, amax)) {
+      i += 4;
+    }
+    if (!less(amax, bmax)) {
+      j += 4;
+    }
+  }
+
+  return n + intersectScalar(a + i, na - i, b + j, nb - j, out + n, less);
+}
+#endif // __SSE2__
+
+
+// Writes the elements of the sorted range 'a' that are also in the
+// sorted range 'b' to 'out' and returns how many there are. The
+// ranges must not contain duplicates. 'out' may be 'a'.
+template <typename T, typename Compare>
+size_t intersect(
+    const T* a,
+    size_t na,
+    const T* b,
+    size_t nb,
+    T* out,
+    const Compare& less) {
+  // When one range is much smaller than the other it's faster to
+  // search for each of its elements in the larger one.
+  const bool skewed = na * 32 < nb || nb * 32 < na;
+
+#ifdef __SSE2__
+  if constexpr (
+      std::is_integral<T>::value &&
+      sizeof(T) == 4 &&
+      std::is_same<Compare, std::less<T>>::value) {
+    if (!skewed) {
+      return intersectSSE2(a, na, b, nb, out, less);
+    }
+  }
+#endif // __SSE2__
+
+  return intersectScalar(a, na, b, nb, out, less, skewed);
+}
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// A set stored as a sorted vector. Compared to 'std::set' it uses much
+// less memory and is faster to iterate, to look up (a binary search of
+// contiguous memory) and to combine with other sets: union,
+// intersection and difference are linear merges into a single
+// allocation rather than an allocation per element. Inserting or
+// erasing a single element is linear in the size of the set though,
+// so prefer 'std::set' for sets that are modified one element at a
+// time. A 'FlatSet' is best built in bulk, e.g., from a 'std::vector'
+// (which is sorted) or a 'std::set':
+//
+//   FlatSet<pid_t> pids = os::pids().get();
+//
+// The intersection of sets of 32 bit integers (e.g., pids) uses SSE2
+// when available.
+template <typename T, typename Compare = std::less<T>>
+class FlatSet {
+ public:
+  typedef typename std::vector<T>::const_iterator iterator;
+  typedef typename std::vector<T>::const_iterator const_iterator;
+
+  FlatSet() {}
+
+  FlatSet(std::initializer_list<T> values)
+    : FlatSet(std::vector<T>(values)) {}
+
+  // Sorts 'values' and removes any duplicates.
+  explicit FlatSet(std::vector<T> values) : values_(std::move(values)) {
+    std::sort(values_.begin(), values_.end(), Compare());
+    values_.erase(
+        std::unique(values_.begin(), values_.end(), equal),
+        values_.end());
+  }
+
+  // An implicit constructor for converting from a 'std::set', which
+  // is already sorted.
+  FlatSet(const std::set<T, Compare>& set)
+    : values_(set.begin(), set.end()) {}
+
+  bool contains(const T& value) const {
+    const_iterator i = find(value);
+    return i != values_.end() && !Compare()(value, *i);
+  }
+
+  // Returns true if 'value' was inserted, false if it was already in
+  // the set.
+  bool insert(const T& value) {
+    const_iterator i = find(value);
+    if (i != values_.end() && !Compare()(value, *i)) {
+      return false;
+    }
+    values_.insert(i, value);
+    return true;
+  }
+
+  // Returns the number of elements erased (0 or 1).
+  size_t erase(const T& value) {
+    const_iterator i = find(value);
+    if (i == values_.end() || Compare()(value, *i)) {
+      return 0;
+    }
+    values_.erase(i);
+    return 1;
+  }
+
+  FlatSet& operator|=(const FlatSet& that) {
+    if (that.empty()) {
+      return *this;
+    }
+
+    std::vector<T> result;
+    result.reserve(values_.size() + that.values_.size());
+    std::set_union(
+        values_.begin(),
+        values_.end(),
+        that.values_.begin(),
+        that.values_.end(),
+        std::back_inserter(result),
+        Compare());
+
+    values_.swap(result);
+    return *this;
+  }
+
+  // Removes the elements of 'that' in place.
+  FlatSet& operator-=(const FlatSet& that) {
+    auto j = that.values_.begin();
+    auto end = std::remove_if(
+        values_.begin(),
+        values_.end(),
+        [&](const T& value) {
+          while (j != that.values_.end() && Compare()(*j, value)) {
+            ++j;
+          }
+          return j != that.values_.end() && !Compare()(value, *j);
+        });
+
+    values_.erase(end, values_.end());
+    return *this;
+  }
+
+  // Keeps only the elements also in 'that', in place.
+  FlatSet& operator&=(const FlatSet& that) {
+    values_.resize(internal::intersect(
+        values_.data(),
+        values_.size(),
+        that.values_.data(),
+        that.values_.size(),
+        values_.data(),
+        Compare()));
+    return *this;
+  }
+
+  bool operator==(const FlatSet& that) const {
+    return values_ == that.values_;
+  }
+
+  bool operator!=(const FlatSet& that) const {
+    return !(*this == that);
+  }
+
+  // Returns the elements in sorted order.
+  const std::vector<T>& values() const {
+    return values_;
+  }
+
+  size_t size() const {
+    return values_.size();
+  }
+
+  bool empty() const {
+    return values_.empty();
+  }
+
+  void clear() {
+    values_.clear();
+  }
+
+  void reserve(size_t size) {
+    values_.reserve(size);
+  }
+
+  const_iterator begin() const {
+    return values_.begin();
+  }
+
+  const_iterator end() const {
+    return values_.end();
+  }
+
+ private:
+  // Returns the first element not less than 'value'.
+  const_iterator find(const T& value) const {
+    return std::lower_bound(values_.begin(), values_.end(), value, Compare());
+  }
+
+  static bool equal(const T& left, const T& right) {
+    return !Compare()(left, right) && !Compare()(right, left);
+  }
+
+  std::vector<T> values_;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Compare>
+FlatSet<T, Compare> operator|(
+    const FlatSet<T, Compare>& left,
+    const FlatSet<T, Compare>& right) {
+  FlatSet<T, Compare> result = left;
+  result |= right;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Compare>
+FlatSet<T, Compare> operator+(const FlatSet<T, Compare>& left, const T& t) {
+  FlatSet<T, Compare> result = left;
+  result.insert(t);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Compare>
+FlatSet<T, Compare> operator&(
+    const FlatSet<T, Compare>& left,
+    const FlatSet<T, Compare>& right) {
+  FlatSet<T, Compare> result = left;
+  result &= right;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Compare>
+FlatSet<T, Compare> operator-(
+    const FlatSet<T, Compare>& left,
+    const FlatSet<T, Compare>& right) {
+  FlatSet<T, Compare> result = left;
+  result -= right;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Compare>
+std::ostream& operator<<(
+    std::ostream& stream,
+    const FlatSet<T, Compare>& set) {
+  stream << "{ ";
+  bool first = true;
+  for (const T& value : set) {
+    if (!first) {
+      stream << ", ";
+    }
+    stream << value;
+    first = false;
+  }
+  stream << " }";
+  return stream;
+}
+
+////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,375 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "stout/bytes.h"
+#include "stout/option.h"
+#include "stout/try.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// Estimates how much memory a value uses, including everything it
+// owns on the heap, e.g., to size caches by memory rather than by
+// number of entries or to catch bloat in tests:
+//
+//   hashmap<std::string, std::vector<int>> map = ...;
+//   Bytes bytes = stout::footprint(map);
+//
+// 'footprint(t)' is 'sizeof(t)' plus 'heapFootprint(t)', the bytes
+// allocated on the heap by 't' (recursively). The estimates are based
+// on the node layouts of the common standard library implementations
+// and ignore allocator overhead.
+//
+// Types that own heap memory, other than the standard containers and
+// stout's collections, report it by overloading 'heapFootprint' in
+// their own namespace (found via argument dependent lookup) and use
+// 'stout::heapFootprint' for their members, e.g.:
+//
+//   namespace mine {
+//
+//   struct Entry {
+//     std::string name;
+//     std::vector<Entry> children;
+//   };
+//
+//   inline size_t heapFootprint(const Entry& entry) {
+//     return stout::heapFootprint(entry.name) +
+//       stout::heapFootprint(entry.children);
+//   }
+//
+//   } // namespace mine
+//
+// Types without an overload are assumed not to own any heap memory.
+
+////////////////////////////////////////////////////////////////////////
+
+namespace stout {
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+// Converts from anything so that the catch-all 'heapFootprint' below
+// is the worst match for any type, including for types derived from
+// the standard containers (such as 'hashmap').
+struct AnyValue {
+  template <typename T>
+  AnyValue(const T&) {}
+};
+
+// Per node overhead of 'std::list'.
+constexpr size_t LIST_NODE = 2 * sizeof(void*);
+
+// Per node overhead of 'std::map' and 'std::set'.
+constexpr size_t TREE_NODE = 4 * sizeof(void*);
+
+// Per node overhead of the unordered containers, assuming the hash is
+// cached in the node.
+constexpr size_t HASH_NODE = sizeof(void*) + sizeof(size_t);
+
+// NOTE: All of the overloads are declared before any of them are
+// defined so that 'HeapFootprint' below can find them.
+
+inline size_t heapFootprint(AnyValue);
+
+template <typename C, typename Traits, typename Allocator>
+size_t heapFootprint(const std::basic_string<C, Traits, Allocator>& string);
+
+template <typename T, typename Allocator>
+size_t heapFootprint(const std::vector<T, Allocator>& vector);
+
+template <typename T, typename Allocator>
+size_t heapFootprint(const std::list<T, Allocator>& list);
+
+template <typename K, typename V, typename Less, typename Allocator>
+size_t heapFootprint(const std::map<K, V, Less, Allocator>& map);
+
+template <typename K, typename V, typename Less, typename Allocator>
+size_t heapFootprint(const std::multimap<K, V, Less, Allocator>& map);
+
+template <typename T, typename Less, typename Allocator>
+size_t heapFootprint(const std::set<T, Less, Allocator>& set);
+
+template <
+    typename K,
+    typename V,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+size_t heapFootprint(
+    const std::unordered_map<K, V, Hash, Equal, Allocator>& map);
+
+template <
+    typename K,
+    typename V,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+size_t heapFootprint(
+    const std::unordered_multimap<K, V, Hash, Equal, Allocator>& map);
+
+template <typename T, typename Hash, typename Equal, typename Allocator>
+size_t heapFootprint(const std::unordered_set<T, Hash, Equal, Allocator>& set);
+
+template <typename T1, typename T2>
+size_t heapFootprint(const std::pair<T1, T2>& pair);
+
+template <typename T, typename Deleter>
+size_t heapFootprint(const std::unique_ptr<T, Deleter>& pointer);
+
+template <typename T>
+size_t heapFootprint(const std::shared_ptr<T>& pointer);
+
+template <typename T>
+size_t heapFootprint(const std::optional<T>& optional);
+
+template <typename T>
+size_t heapFootprint(const Option<T>& option);
+
+template <typename T, typename E>
+size_t heapFootprint(const Try<T, E>& t);
+
+////////////////////////////////////////////////////////////////////////
+
+// Calls the 'heapFootprint' overload for 'T', either one of the above
+// or one found via argument dependent lookup.
+struct HeapFootprint {
+  template <typename T>
+  size_t operator()(const T& t) const {
+    return heapFootprint(t);
+  }
+};
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// Returns the estimated heap used by 't'. This is an object rather
+// than a function so that it finds overloads via argument dependent
+// lookup even when called qualified.
+constexpr internal::HeapFootprint heapFootprint{};
+
+////////////////////////////////////////////////////////////////////////
+
+// Returns the estimated memory used by 't', including its heap.
+template <typename T>
+Bytes footprint(const T& t) {
+  return Bytes(sizeof(T) + heapFootprint(t));
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+inline size_t heapFootprint(AnyValue) {
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename C, typename Traits, typename Allocator>
+size_t heapFootprint(const std::basic_string<C, Traits, Allocator>& string) {
+  // Short strings are stored inline in the object.
+  const char* data = reinterpret_cast<const char*>(string.data());
+  const char* object = reinterpret_cast<const char*>(&string);
+  if (data >= object && data < object + sizeof(string)) {
+    return 0;
+  }
+
+  return (string.capacity() + 1) * sizeof(C);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Allocator>
+size_t heapFootprint(const std::vector<T, Allocator>& vector) {
+  size_t result = vector.capacity() * sizeof(T);
+  for (const T& t : vector) {
+    result += stout::heapFootprint(t);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Allocator>
+size_t heapFootprint(const std::list<T, Allocator>& list) {
+  size_t result = list.size() * (LIST_NODE + sizeof(T));
+  for (const T& t : list) {
+    result += stout::heapFootprint(t);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename K, typename V, typename Less, typename Allocator>
+size_t heapFootprint(const std::map<K, V, Less, Allocator>& map) {
+  typedef typename std::map<K, V, Less, Allocator>::value_type entry;
+
+  size_t result = map.size() * (TREE_NODE + sizeof(entry));
+  for (const entry& entry : map) {
+    result += stout::heapFootprint(entry);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename K, typename V, typename Less, typename Allocator>
+size_t heapFootprint(const std::multimap<K, V, Less, Allocator>& map) {
+  typedef typename std::multimap<K, V, Less, Allocator>::value_type entry;
+
+  size_t result = map.size() * (TREE_NODE + sizeof(entry));
+  for (const entry& entry : map) {
+    result += stout::heapFootprint(entry);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Less, typename Allocator>
+size_t heapFootprint(const std::set<T, Less, Allocator>& set) {
+  size_t result = set.size() * (TREE_NODE + sizeof(T));
+  for (const T& t : set) {
+    result += stout::heapFootprint(t);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename K,
+    typename V,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+size_t heapFootprint(
+    const std::unordered_map<K, V, Hash, Equal, Allocator>& map) {
+  typedef typename std::unordered_map<K, V, Hash, Equal, Allocator>::
+    value_type entry;
+
+  size_t result = map.bucket_count() * sizeof(void*) +
+    map.size() * (HASH_NODE + sizeof(entry));
+  for (const entry& entry : map) {
+    result += stout::heapFootprint(entry);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename K,
+    typename V,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+size_t heapFootprint(
+    const std::unordered_multimap<K, V, Hash, Equal, Allocator>& map) {
+  typedef typename std::unordered_multimap<K, V, Hash, Equal, Allocator>::
+    value_type entry;
+
+  size_t result = map.bucket_count() * sizeof(void*) +
+    map.size() * (HASH_NODE + sizeof(entry));
+  for (const entry& entry : map) {
+    result += stout::heapFootprint(entry);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Hash, typename Equal, typename Allocator>
+size_t heapFootprint(
+    const std::unordered_set<T, Hash, Equal, Allocator>& set) {
+  size_t result = set.bucket_count() * sizeof(void*) +
+    set.size() * (HASH_NODE + sizeof(T));
+  for (const T& t : set) {
+    result += stout::heapFootprint(t);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T1, typename T2>
+size_t heapFootprint(const std::pair<T1, T2>& pair) {
+  return stout::heapFootprint(pair.first) +
+    stout::heapFootprint(pair.second);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Deleter>
+size_t heapFootprint(const std::unique_ptr<T, Deleter>& pointer) {
+  return pointer ? sizeof(T) + stout::heapFootprint(*pointer) : 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// NOTE: The pointee is counted in full by every 'std::shared_ptr' to
+// it, so objects that are shared are counted more than once.
+template <typename T>
+size_t heapFootprint(const std::shared_ptr<T>& pointer) {
+  return pointer ? sizeof(T) + stout::heapFootprint(*pointer) : 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+size_t heapFootprint(const std::optional<T>& optional) {
+  return optional ? stout::heapFootprint(*optional) : 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+size_t heapFootprint(const Option<T>& option) {
+  return option.isSome() ? stout::heapFootprint(option.get()) : 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename E>
+size_t heapFootprint(const Try<T, E>& t) {
+  return t.isSome()
+    ? stout::heapFootprint(t.get())
+    : stout::heapFootprint(t.error());
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace stout
+
+////////////////////////////////////////////////////////////////////////
@@ -15,6 +15,7 @@
 #include <zlib.h>
 
 #include <string>
+#include <string_view>
 
 #include "fmt/format.h"
 #include "stout/abort.h"
@@ -25,7 +26,6 @@
 ////////////////////////////////////////////////////////////////////////
 
 // Compression utilities.
-// TODO(bmahler): Provide streaming compression as well.
 namespace gzip {
 
 ////////////////////////////////////////////////////////////////////////
@@ -175,6 +175,117 @@ class Decompressor {
 
 ////////////////////////////////////////////////////////////////////////
 
+// Provides the ability to incrementally compress a stream of input
+// data, e.g., to compress a response while it's being written rather
+// than after it has been written into memory. Compressed data is
+// returned as it becomes available; 'finish' returns the rest.
+// The compression level is the same as for 'compress' below.
+class Compressor {
+ public:
+  explicit Compressor(int level = Z_DEFAULT_COMPRESSION)
+    : _finished(false) {
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+
+    int code = deflateInit2(
+        &stream,
+        level, // Compression level.
+        Z_DEFLATED, // Compression method.
+        MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+        8, // Default memLevel value.
+        Z_DEFAULT_STRATEGY);
+
+    if (code != Z_OK) {
+      Error error =
+          internal::GzipError("Failed to deflateInit2", stream, code);
+      ABORT(error.message);
+    }
+  }
+
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+  ~Compressor() {
+    // NOTE: 'deflateEnd' returns 'Z_DATA_ERROR' if the stream wasn't
+    // finished, which is fine.
+    int code = deflateEnd(&stream);
+    if (code != Z_OK && code != Z_DATA_ERROR) {
+      ABORT("Failed to deflateEnd");
+    }
+  }
+
+  // Returns the next compressed chunk of data (which may be empty
+  // since zlib buffers its input), or an Error if compression fails.
+  Try<std::string> compress(std::string_view decompressed) {
+    if (_finished) {
+      return Error("Stream is finished");
+    }
+
+    stream.next_in =
+        const_cast<Bytef*>(reinterpret_cast<const Bytef*>(decompressed.data()));
+    stream.avail_in = static_cast<uInt>(decompressed.size());
+
+    return deflate(Z_NO_FLUSH);
+  }
+
+  // Returns the rest of the compressed data, after which no more data
+  // can be compressed.
+  Try<std::string> finish() {
+    if (_finished) {
+      return Error("Stream is finished");
+    }
+
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+
+    Try<std::string> result = deflate(Z_FINISH);
+    _finished = true;
+    return result;
+  }
+
+  // Returns whether the compression stream is finished.
+  bool finished() const {
+    return _finished;
+  }
+
+ private:
+  Try<std::string> deflate(int flush) {
+    // Build up the compressed result.
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result;
+
+    int code;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+
+      code = ::deflate(&stream, flush);
+
+      // NOTE: 'Z_BUF_ERROR' only means that no progress was possible,
+      // e.g., when the previous call filled the buffer exactly.
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        _finished = true;
+        return internal::GzipError("Failed to deflate", stream, code);
+      }
+
+      // Consume output.
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    } while (flush == Z_FINISH ? code != Z_STREAM_END : stream.avail_out == 0);
+
+    return result;
+  }
+
+  z_stream_s stream;
+  bool _finished;
+};
+
+////////////////////////////////////////////////////////////////////////
+
 // Returns a gzip compressed version of the provided string.
 // The compression level should be within the range [-1, 9].
 // See zlib.h:
@@ -0,0 +1,245 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifdef ENABLE_RANDOM_HASH_SEED
+#include <random>
+#endif // ENABLE_RANDOM_HASH_SEED
+
+////////////////////////////////////////////////////////////////////////
+
+// Fast hash functions (based on wyhash) for the keys of the hash based
+// collections, which use 'stout::Hash' by default.
+//
+// By default the hashes are the same in every process, which keeps
+// the iteration order of the collections stable between runs. Build
+// with ENABLE_RANDOM_HASH_SEED defined to instead pick a random seed
+// in every process, which makes it infeasible for an attacker to
+// choose keys that all end up in the same bucket ("hash flooding").
+// Either way a hash must never be persisted or sent to another process.
+
+////////////////////////////////////////////////////////////////////////
+
+namespace stout {
+
+////////////////////////////////////////////////////////////////////////
+
+namespace hash {
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+inline constexpr uint64_t SECRET[4] = {
+  0x2d358dccaa6c78a5ULL,
+  0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL,
+  0x4d5a2da51de1aa47ULL,
+};
+
+// Sets 'a' and 'b' to the low and high halves of their product.
+inline void multiply(uint64_t& a, uint64_t& b) {
+#ifdef __SIZEOF_INT128__
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  a = static_cast<uint64_t>(product);
+  b = static_cast<uint64_t>(product >> 64);
+#else
+  const uint64_t ha = a >> 32, hb = b >> 32;
+  const uint64_t la = static_cast<uint32_t>(a);
+  const uint64_t lb = static_cast<uint32_t>(b);
+  const uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+  const uint64_t t = ll + (hl << 32);
+  const uint64_t low = t + (lh << 32);
+  const uint64_t carry = (t < ll) + (low < t);
+  a = low;
+  b = hh + (hl >> 32) + (lh >> 32) + carry;
+#endif // __SIZEOF_INT128__
+}
+
+
+inline uint64_t mix(uint64_t a, uint64_t b) {
+  multiply(a, b);
+  return a ^ b;
+}
+
+
+inline uint64_t read8(const unsigned char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+
+inline uint64_t read4(const unsigned char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+
+inline uint64_t read3(const unsigned char* p, size_t k) {
+  return (static_cast<uint64_t>(p[0]) << 16) |
+    (static_cast<uint64_t>(p[k >> 1]) << 8) |
+    p[k - 1];
+}
+
+
+#ifdef ENABLE_RANDOM_HASH_SEED
+inline uint64_t random() {
+  std::random_device device;
+  return (static_cast<uint64_t>(device()) << 32) ^ device();
+}
+#endif // ENABLE_RANDOM_HASH_SEED
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// Returns the seed used by the hashes in this process, see above.
+inline uint64_t seed() {
+#ifdef ENABLE_RANDOM_HASH_SEED
+  static const uint64_t random = internal::random();
+  return random;
+#else
+  return 0;
+#endif // ENABLE_RANDOM_HASH_SEED
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// Returns the hash of 'size' bytes at 'data'.
+inline uint64_t bytes(
+    const void* data,
+    size_t size,
+    uint64_t seed = hash::seed()) {
+  using internal::SECRET;
+  using internal::mix;
+  using internal::read3;
+  using internal::read4;
+  using internal::read8;
+
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+
+  seed ^= mix(seed ^ SECRET[0], SECRET[1]);
+
+  uint64_t a = 0;
+  uint64_t b = 0;
+
+  if (size <= 16) {
+    if (size >= 4) {
+      const size_t shift = (size >> 3) << 2;
+      a = (read4(p) << 32) | read4(p + shift);
+      b = (read4(p + size - 4) << 32) | read4(p + size - 4 - shift);
+    } else if (size > 0) {
+      a = read3(p, size);
+    }
+  } else {
+    size_t i = size;
+    if (i > 48) {
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = mix(read8(p) ^ SECRET[1], read8(p + 8) ^ seed);
+        see1 = mix(read8(p + 16) ^ SECRET[2], read8(p + 24) ^ see1);
+        see2 = mix(read8(p + 32) ^ SECRET[3], read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = mix(read8(p) ^ SECRET[1], read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = read8(p + i - 16);
+    b = read8(p + i - 8);
+  }
+
+  a ^= SECRET[1];
+  b ^= seed;
+  internal::multiply(a, b);
+  return mix(a ^ SECRET[0] ^ size, b ^ SECRET[1]);
+}
+
+
+// Returns the hash of 'value'.
+inline uint64_t integer(uint64_t value, uint64_t seed = hash::seed()) {
+  return internal::mix(
+      value ^ internal::SECRET[0],
+      seed ^ internal::SECRET[1]);
+}
+
+} // namespace hash
+
+////////////////////////////////////////////////////////////////////////
+
+// The default hash of the hash based collections: strings are hashed
+// with 'hash::bytes' and all other types with 'std::hash' (some of
+// which, e.g., for 'id::UUID' and 'net::IP', are in turn implemented
+// with 'hash::bytes').
+//
+// NOTE: Integers and enums hash to themselves, like 'std::hash', since
+// the standard unordered containers use a prime number of buckets
+// (so don't need the bits mixed) and sequential keys then end up in
+// sequential buckets, which makes lookups several times faster than
+// with 'hash::integer'. Unless the hashes are seeded, in which case
+// 'hash::integer' is used so the buckets can't be predicted.
+template <typename T, typename Enable = void>
+struct Hash : std::hash<T> {};
+
+
+template <typename T>
+struct Hash<
+    T,
+    typename std::enable_if<
+        std::is_integral<T>::value || std::is_enum<T>::value>::type> {
+  size_t operator()(T t) const {
+#ifdef ENABLE_RANDOM_HASH_SEED
+    return static_cast<size_t>(hash::integer(static_cast<uint64_t>(t)));
+#else
+    return static_cast<size_t>(t);
+#endif // ENABLE_RANDOM_HASH_SEED
+  }
+};
+
+
+template <typename Traits, typename Allocator>
+struct Hash<std::basic_string<char, Traits, Allocator>> {
+  size_t operator()(
+      const std::basic_string<char, Traits, Allocator>& s) const {
+    return static_cast<size_t>(hash::bytes(s.data(), s.size()));
+  }
+};
+
+
+template <>
+struct Hash<std::string_view> {
+  size_t operator()(std::string_view s) const {
+    return static_cast<size_t>(hash::bytes(s.data(), s.size()));
+  }
+};
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace stout
+
+////////////////////////////////////////////////////////////////////////
@@ -15,14 +15,17 @@
 #include <functional>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "foreach.h"
+#include "hash.h"
 #include "hashset.h"
 #include "none.h"
 #include "option.h"
+#include "views.h"
 
 ////////////////////////////////////////////////////////////////////////
 
@@ -32,27 +35,30 @@
 template <
     typename Key,
     typename Value,
-    typename Hash =
-        typename std::conditional<
-            std::is_enum<Key>::value,
-            EnumClassHash,
-            std::hash<Key>>::type,
-    typename Equal = std::equal_to<Key>>
-class hashmap : public std::unordered_map<Key, Value, Hash, Equal> {
+    typename Hash = stout::Hash<Key>,
+    typename Equal = std::equal_to<Key>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class hashmap
+  : public std::unordered_map<Key, Value, Hash, Equal, Allocator> {
  public:
   // An explicit default constructor is needed so
   // 'const hashmap<T> map;' is not an error.
   hashmap() {}
 
+  // Constructs an empty map that allocates its nodes and buckets with
+  // 'allocator', e.g., from an arena, see stout/pmr.h.
+  explicit hashmap(const Allocator& allocator)
+    : std::unordered_map<Key, Value, Hash, Equal, Allocator>(allocator) {}
+
   // An implicit constructor for converting from a std::map.
   //
   // TODO(benh): Allow any arbitrary type that supports 'begin()' and
   // 'end()' passed into the specified 'emplace'?
   hashmap(const std::map<Key, Value>& map) {
-    std::unordered_map<Key, Value, Hash, Equal>::reserve(map.size());
+    std::unordered_map<Key, Value, Hash, Equal, Allocator>::reserve(map.size());
 
     for (auto iterator = map.begin(); iterator != map.end(); ++iterator) {
-      std::unordered_map<Key, Value, Hash, Equal>::emplace(
+      std::unordered_map<Key, Value, Hash, Equal, Allocator>::emplace(
           iterator->first,
           iterator->second);
     }
@@ -65,17 +71,21 @@ class hashmap : public std::unordered_map<Key, Value, Hash, Equal> {
   hashmap(std::map<Key, Value>&& map) {
     // NOTE: We're using 'insert' here with a move iterator in order
     // to avoid copies because we know we have an r-value paramater.
-    std::unordered_map<Key, Value, Hash, Equal>::insert(
+    std::unordered_map<Key, Value, Hash, Equal, Allocator>::insert(
         std::make_move_iterator(map.begin()),
         std::make_move_iterator(map.end()));
   }
 
   // Allow simple construction via initializer list.
-  hashmap(std::initializer_list<std::pair<Key, Value>> list) {
-    std::unordered_map<Key, Value, Hash, Equal>::reserve(list.size());
+  hashmap(
+      std::initializer_list<std::pair<Key, Value>> list,
+      const Allocator& allocator = Allocator())
+    : std::unordered_map<Key, Value, Hash, Equal, Allocator>(allocator) {
+    std::unordered_map<Key, Value, Hash, Equal, Allocator>::reserve(
+        list.size());
 
     for (auto iterator = list.begin(); iterator != list.end(); ++iterator) {
-      std::unordered_map<Key, Value, Hash, Equal>::emplace(
+      std::unordered_map<Key, Value, Hash, Equal, Allocator>::emplace(
           iterator->first,
           iterator->second);
     }
@@ -83,7 +93,7 @@ class hashmap : public std::unordered_map<Key, Value, Hash, Equal> {
 
   // Checks whether this map contains a binding for a key.
   bool contains(const Key& key) const {
-    return std::unordered_map<Key, Value, Hash, Equal>::count(key) > 0;
+    return this->count(key) > 0;
   }
 
   // Checks whether there exists a bound value in this map.
@@ -99,28 +109,44 @@ class hashmap : public std::unordered_map<Key, Value, Hash, Equal> {
   // Inserts a key, value pair into the map replacing an old value
   // if the key is already present.
   void put(const Key& key, Value&& value) {
-    std::unordered_map<Key, Value, Hash, Equal>::erase(key);
-    std::unordered_map<Key, Value, Hash, Equal>::insert(
+    std::unordered_map<Key, Value, Hash, Equal, Allocator>::erase(key);
+    std::unordered_map<Key, Value, Hash, Equal, Allocator>::insert(
         std::pair<Key, Value>(key, std::move(value)));
   }
 
   // Inserts a key, value pair into the map replacing an old value
   // if the key is already present.
   void put(const Key& key, const Value& value) {
-    std::unordered_map<Key, Value, Hash, Equal>::erase(key);
-    std::unordered_map<Key, Value, Hash, Equal>::insert(
+    std::unordered_map<Key, Value, Hash, Equal, Allocator>::erase(key);
+    std::unordered_map<Key, Value, Hash, Equal, Allocator>::insert(
         std::pair<Key, Value>(key, value));
   }
 
   // Returns an Option for the binding to the key.
   Option<Value> get(const Key& key) const {
-    auto it = std::unordered_map<Key, Value, Hash, Equal>::find(key);
-    if (it == std::unordered_map<Key, Value, Hash, Equal>::end()) {
+    auto it = std::unordered_map<Key, Value, Hash, Equal, Allocator>::find(key);
+    if (it == std::unordered_map<Key, Value, Hash, Equal, Allocator>::end()) {
       return None();
     }
     return it->second;
   }
 
+  // Returns a view of the keys in this map that iterates the map in
+  // place, prefer this to 'keys()' unless a copy is needed.
+  auto keys_view() const {
+    return stout::keys_view(this->begin(), this->end());
+  }
+
+  // Returns a view of the values in this map that iterates the map in
+  // place, prefer this to 'values()' unless a copy is needed.
+  auto values_view() const {
+    return stout::values_view(this->begin(), this->end());
+  }
+
+  auto values_view() {
+    return stout::values_view(this->begin(), this->end());
+  }
+
   // Returns the set of keys in this map.
   // TODO(vinod/bmahler): Should return a list instead.
   hashset<Key> keys() const {
@@ -134,7 +160,7 @@ class hashmap : public std::unordered_map<Key, Value, Hash, Equal> {
   // Returns the list of values in this map.
   std::vector<Value> values() const {
     std::vector<Value> result;
-    result.reserve(std::unordered_map<Key, Value, Hash, Equal>::size());
+    result.reserve(this->size());
 
     foreachvalue(const Value& value, *this) {
       result.push_back(value);
@@ -146,8 +172,10 @@ class hashmap : public std::unordered_map<Key, Value, Hash, Equal> {
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename K, typename V>
-std::ostream& operator<<(std::ostream& stream, const hashmap<K, V>& map) {
+template <typename K, typename V, typename H, typename E, typename A>
+std::ostream& operator<<(
+    std::ostream& stream,
+    const hashmap<K, V, H, E, A>& map) {
   return stream << stringify(map);
 }
 
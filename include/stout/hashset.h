@@ -13,11 +13,13 @@
 #pragma once
 
 #include <boost/get_pointer.hpp>
+#include <memory>
 #include <set>
 #include <unordered_set>
 #include <utility>
 
 #include "foreach.h"
+#include "hash.h"
 
 ////////////////////////////////////////////////////////////////////////
 
@@ -45,28 +47,31 @@ struct EnumClassHash {
 // existing functions.
 template <
     typename Elem,
-    typename Hash = typename std::conditional<
-        std::is_enum<Elem>::value,
-        EnumClassHash,
-        std::hash<Elem>>::type,
-    typename Equal = std::equal_to<Elem>>
-class hashset : public std::unordered_set<Elem, Hash, Equal> {
+    typename Hash = stout::Hash<Elem>,
+    typename Equal = std::equal_to<Elem>,
+    typename Allocator = std::allocator<Elem>>
+class hashset : public std::unordered_set<Elem, Hash, Equal, Allocator> {
  public:
-  static const hashset<Elem, Hash, Equal>& EMPTY;
+  static const hashset<Elem, Hash, Equal, Allocator>& EMPTY;
 
   // An explicit default constructor is needed so
   // 'const hashset<T> map;' is not an error.
   hashset() {}
 
+  // Constructs an empty set that allocates its nodes and buckets with
+  // 'allocator', e.g., from an arena, see stout/pmr.h.
+  explicit hashset(const Allocator& allocator)
+    : std::unordered_set<Elem, Hash, Equal, Allocator>(allocator) {}
+
   // An implicit constructor for converting from a std::set.
   //
   // TODO(arojas): Allow any arbitrary type that supports 'begin()'
   // and 'end()' passed into the specified 'emplace'?
   hashset(const std::set<Elem>& set) {
-    std::unordered_set<Elem, Hash, Equal>::reserve(set.size());
+    std::unordered_set<Elem, Hash, Equal, Allocator>::reserve(set.size());
 
     for (auto iterator = set.begin(); iterator != set.end(); ++iterator) {
-      std::unordered_set<Elem, Hash, Equal>::emplace(*iterator);
+      std::unordered_set<Elem, Hash, Equal, Allocator>::emplace(*iterator);
     }
   }
 
@@ -78,25 +83,29 @@ class hashset : public std::unordered_set<Elem, Hash, Equal> {
     // An implementation based on the move constructor of 'hashmap'
     // fails to compile on all major compilers except gcc 5.1 and up.
     // See http://stackoverflow.com/q/31051466/118750?sem=2.
-    std::unordered_set<Elem, Hash, Equal>::reserve(set.size());
+    std::unordered_set<Elem, Hash, Equal, Allocator>::reserve(set.size());
 
     for (auto iterator = set.begin(); iterator != set.end(); ++iterator) {
-      std::unordered_set<Elem, Hash, Equal>::emplace(std::move(*iterator));
+      std::unordered_set<Elem, Hash, Equal, Allocator>::emplace(
+          std::move(*iterator));
     }
   }
 
   // Allow simple construction via initializer list.
-  hashset(std::initializer_list<Elem> list) {
-    std::unordered_set<Elem, Hash, Equal>::reserve(list.size());
+  hashset(
+      std::initializer_list<Elem> list,
+      const Allocator& allocator = Allocator())
+    : std::unordered_set<Elem, Hash, Equal, Allocator>(allocator) {
+    std::unordered_set<Elem, Hash, Equal, Allocator>::reserve(list.size());
 
     for (auto iterator = list.begin(); iterator != list.end(); ++iterator) {
-      std::unordered_set<Elem, Hash, Equal>::emplace(*iterator);
+      std::unordered_set<Elem, Hash, Equal, Allocator>::emplace(*iterator);
     }
   }
 
   // Checks whether this map contains a binding for a key.
   bool contains(const Elem& elem) const {
-    return std::unordered_set<Elem, Hash, Equal>::count(elem) > 0;
+    return std::unordered_set<Elem, Hash, Equal, Allocator>::count(elem) > 0;
   }
 
   // Checks whether there exists a value in this set that returns the
@@ -127,20 +136,21 @@ class hashset : public std::unordered_set<Elem, Hash, Equal> {
 ////////////////////////////////////////////////////////////////////////
 
 // TODO(jmlvanre): Possibly remove this reference as per MESOS-2694.
-template <typename Elem, typename Hash, typename Equal>
-const hashset<Elem, Hash, Equal>& hashset<Elem, Hash, Equal>::EMPTY =
-    *new hashset<Elem, Hash, Equal>();
+template <typename Elem, typename Hash, typename Equal, typename Allocator>
+const hashset<Elem, Hash, Equal, Allocator>&
+hashset<Elem, Hash, Equal, Allocator>::EMPTY =
+  *new hashset<Elem, Hash, Equal, Allocator>();
 
 ////////////////////////////////////////////////////////////////////////
 
 // Union operator.
-template <typename Elem, typename Hash, typename Equal>
-hashset<Elem, Hash, Equal> operator|(
-    const hashset<Elem, Hash, Equal>& left,
-    const hashset<Elem, Hash, Equal>& right) {
+template <typename Elem, typename Hash, typename Equal, typename Allocator>
+hashset<Elem, Hash, Equal, Allocator> operator|(
+    const hashset<Elem, Hash, Equal, Allocator>& left,
+    const hashset<Elem, Hash, Equal, Allocator>& right) {
   // Note, we're not using 'set_union' since it affords us no benefit
   // in efficiency and is more complicated to use given we have sets.
-  hashset<Elem, Hash, Equal> result = left;
+  hashset<Elem, Hash, Equal, Allocator> result = left;
   result |= right;
   return result;
 }
@@ -148,10 +158,10 @@ hashset<Elem, Hash, Equal> operator|(
 ////////////////////////////////////////////////////////////////////////
 
 // Union assignment operator.
-template <typename Elem, typename Hash, typename Equal>
-hashset<Elem, Hash, Equal>& operator|=(
-    hashset<Elem, Hash, Equal>& left,
-    const hashset<Elem, Hash, Equal>& right) {
+template <typename Elem, typename Hash, typename Equal, typename Allocator>
+hashset<Elem, Hash, Equal, Allocator>& operator|=(
+    hashset<Elem, Hash, Equal, Allocator>& left,
+    const hashset<Elem, Hash, Equal, Allocator>& right) {
   left.insert(right.begin(), right.end());
   return left;
 }
@@ -159,11 +169,11 @@ hashset<Elem, Hash, Equal>& operator|=(
 ////////////////////////////////////////////////////////////////////////
 
 // Difference operator.
-template <typename Elem, typename Hash, typename Equal>
-hashset<Elem, Hash, Equal> operator-(
-    const hashset<Elem, Hash, Equal>& left,
-    const hashset<Elem, Hash, Equal>& right) {
-  hashset<Elem, Hash, Equal> result = left;
+template <typename Elem, typename Hash, typename Equal, typename Allocator>
+hashset<Elem, Hash, Equal, Allocator> operator-(
+    const hashset<Elem, Hash, Equal, Allocator>& left,
+    const hashset<Elem, Hash, Equal, Allocator>& right) {
+  hashset<Elem, Hash, Equal, Allocator> result = left;
   result -= right;
   return result;
 }
@@ -171,10 +181,10 @@ hashset<Elem, Hash, Equal> operator-(
 ////////////////////////////////////////////////////////////////////////
 
 // Difference assignment operator.
-template <typename Elem, typename Hash, typename Equal>
-hashset<Elem, Hash, Equal>& operator-=(
-    hashset<Elem, Hash, Equal>& left,
-    const hashset<Elem, Hash, Equal>& right) {
+template <typename Elem, typename Hash, typename Equal, typename Allocator>
+hashset<Elem, Hash, Equal, Allocator>& operator-=(
+    hashset<Elem, Hash, Equal, Allocator>& left,
+    const hashset<Elem, Hash, Equal, Allocator>& right) {
   foreach (const Elem& elem, right) {
     left.erase(elem);
   }
@@ -0,0 +1,221 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "stout/interval.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// An immutable interval tree that maps possibly overlapping intervals
+// to values, e.g., for looking up which of many registered ranges own
+// a point. Unlike 'IntervalSet', which joins overlapping intervals,
+// every interval is kept and can be found via "stabbing" queries (all
+// intervals that contain a point) or overlap queries (all intervals
+// that intersect an interval) in O(log n + k) for k results.
+//
+// The tree is built in bulk and laid out as an implicit balanced
+// binary tree over a vector sorted by lower bound: the root of any
+// subrange is its middle element. Each element is augmented with the
+// largest upper bound in its subtree so that subtrees that end before
+// the query can be skipped. The bounds needed to walk the tree are
+// kept apart from the values so a query only touches a few contiguous
+// cache lines of bounds until it finds matches.
+template <typename T, typename Value>
+class IntervalTree {
+ public:
+  typedef std::pair<Interval<T>, Value> entry;
+  typedef typename std::vector<entry>::const_iterator const_iterator;
+
+  IntervalTree() {}
+
+  // Builds the tree from 'entries' in O(n log n). Empty intervals are
+  // dropped since they can never match a query.
+  explicit IntervalTree(std::vector<entry> _entries)
+    : entries(std::move(_entries)) {
+    entries.erase(
+        std::remove_if(
+            entries.begin(),
+            entries.end(),
+            [](const entry& entry) {
+              return entry.first.lower() >= entry.first.upper();
+            }),
+        entries.end());
+
+    std::stable_sort(
+        entries.begin(),
+        entries.end(),
+        [](const entry& left, const entry& right) {
+          return left.first.lower() < right.first.lower();
+        });
+
+    bounds.reserve(entries.size());
+    for (const entry& entry : entries) {
+      bounds.push_back({entry.first.lower(), entry.first.upper(), {}});
+    }
+
+    if (!bounds.empty()) {
+      augment(0, bounds.size());
+    }
+  }
+
+  // Invokes 'f(interval, value)' for every interval that contains
+  // 'point', in ascending order of lower bound.
+  template <typename F>
+  void foreachContaining(const T& point, F&& f) const {
+    stab(0, bounds.size(), point, f);
+  }
+
+  // Invokes 'f(interval, value)' for every interval that intersects
+  // 'interval', in ascending order of lower bound.
+  template <typename F>
+  void foreachOverlapping(const Interval<T>& interval, F&& f) const {
+    if (interval.lower() < interval.upper()) {
+      overlap(0, bounds.size(), interval.lower(), interval.upper(), f);
+    }
+  }
+
+  // Returns the values of every interval that contains 'point'.
+  std::vector<Value> containing(const T& point) const {
+    std::vector<Value> result;
+    foreachContaining(point, [&](const Interval<T>&, const Value& value) {
+      result.push_back(value);
+    });
+    return result;
+  }
+
+  // Returns the values of every interval that intersects 'interval'.
+  std::vector<Value> overlapping(const Interval<T>& interval) const {
+    std::vector<Value> result;
+    foreachOverlapping(interval, [&](const Interval<T>&, const Value& value) {
+      result.push_back(value);
+    });
+    return result;
+  }
+
+  size_t size() const {
+    return entries.size();
+  }
+
+  bool empty() const {
+    return entries.empty();
+  }
+
+  // Support for iteration over the entries in ascending order of
+  // lower bound.
+  const_iterator begin() const {
+    return entries.begin();
+  }
+
+  const_iterator end() const {
+    return entries.end();
+  }
+
+ private:
+  struct Bounds {
+    T lower;
+    T upper;
+
+    // The largest upper bound in the subtree rooted here.
+    T max;
+  };
+
+  // Computes 'max' for the subtree over [first, last) and returns it.
+  // Expects that [first, last) is not empty.
+  T augment(size_t first, size_t last) {
+    const size_t middle = first + (last - first) / 2;
+
+    T max = bounds[middle].upper;
+
+    if (first < middle) {
+      max = std::max(max, augment(first, middle));
+    }
+
+    if (middle + 1 < last) {
+      max = std::max(max, augment(middle + 1, last));
+    }
+
+    bounds[middle].max = max;
+    return max;
+  }
+
+  template <typename F>
+  void stab(size_t first, size_t last, const T& point, F& f) const {
+    while (first < last) {
+      const size_t middle = first + (last - first) / 2;
+      const Bounds& node = bounds[middle];
+
+      // Nothing in this subtree ends after 'point'.
+      if (node.max <= point) {
+        return;
+      }
+
+      stab(first, middle, point, f);
+
+      // Everything from here on starts after 'point'.
+      if (point < node.lower) {
+        return;
+      }
+
+      if (point < node.upper) {
+        f(entries[middle].first, entries[middle].second);
+      }
+
+      // Continue with the right subtree without recursing.
+      first = middle + 1;
+    }
+  }
+
+  template <typename F>
+  void overlap(
+      size_t first,
+      size_t last,
+      const T& lower,
+      const T& upper,
+      F& f) const {
+    while (first < last) {
+      const size_t middle = first + (last - first) / 2;
+      const Bounds& node = bounds[middle];
+
+      // Nothing in this subtree ends after 'lower'.
+      if (node.max <= lower) {
+        return;
+      }
+
+      overlap(first, middle, lower, upper, f);
+
+      // Everything from here on starts at or after 'upper'.
+      if (!(node.lower < upper)) {
+        return;
+      }
+
+      if (lower < node.upper) {
+        f(entries[middle].first, entries[middle].second);
+      }
+
+      first = middle + 1;
+    }
+  }
+
+  // Sorted by lower bound.
+  std::vector<entry> entries;
+
+  // The bounds of each of 'entries', at the same index.
+  std::vector<Bounds> bounds;
+};
+
+////////////////////////////////////////////////////////////////////////
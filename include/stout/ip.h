@@ -41,7 +41,6 @@
 #include <sys/types.h>
 
 #include <algorithm>
-#include <boost/functional/hash.hpp>
 #include <iostream>
 #include <numeric>
 #include <string>
@@ -52,6 +51,7 @@
 #include "stout/bits.h"
 #include "stout/check.h"
 #include "stout/error.h"
+#include "stout/hash.h"
 #include "stout/none.h"
 #include "stout/numify.h"
 #include "stout/option.h"
@@ -677,19 +677,12 @@ struct hash<net::IP> {
   typedef net::IP argument_type;
 
   result_type operator()(const argument_type& ip) const {
-    size_t seed = 0;
-
     switch (ip.family()) {
       case AF_INET:
-        boost::hash_combine(seed, htonl(ip.in()->s_addr));
-        return seed;
+        return stout::hash::integer(ntohl(ip.in()->s_addr));
       case AF_INET6: {
         in6_addr in6 = ip.in6().get();
-        boost::hash_range(
-            seed,
-            std::begin(in6.s6_addr),
-            std::end(in6.s6_addr));
-        return seed;
+        return stout::hash::bytes(in6.s6_addr, sizeof(in6.s6_addr));
       }
       default:
         UNREACHABLE();
@@ -701,10 +694,8 @@ struct hash<net::IP> {
 
 template <>
 struct hash<net::IPv4> {
-  size_t operator()(const net::IPv4& ip) {
-    size_t seed = 0;
-    boost::hash_combine(seed, htonl(ip.in().s_addr));
-    return seed;
+  size_t operator()(const net::IPv4& ip) const {
+    return stout::hash::integer(ntohl(ip.in().s_addr));
   }
 };
 
@@ -712,11 +703,9 @@ struct hash<net::IPv4> {
 
 template <>
 struct hash<net::IPv6> {
-  size_t operator()(const net::IPv6& ip) {
-    size_t seed = 0;
+  size_t operator()(const net::IPv6& ip) const {
     in6_addr in6 = ip.in6();
-    boost::hash_range(seed, std::begin(in6.s6_addr), std::end(in6.s6_addr));
-    return seed;
+    return stout::hash::bytes(in6.s6_addr, sizeof(in6.s6_addr));
   }
 };
 
@@ -12,33 +12,25 @@
 
 #pragma once
 
-
-// NOTE: This undef is necessary because we cannot reliably re-order the
-// include statements in all cases.  We define this flag globally since
-// PicoJson requires it before importing <inttypes.h>.  However, other
-// libraries may import <inttypes.h> before we import <picojson.h>.
-// Hence, we undefine the flag here to prevent the redefinition error.
-#undef __STDC_FORMAT_MACROS
-// We also need to define `PICOJSON_USE_INT64`, since we're
-// unconditionally using the `picojson::value::get<uint64_t>()` and
-// `picojson::value::is<uint64_t>()` functions below.
-#define PICOJSON_USE_INT64
-#include <picojson.h>
-#define __STDC_FORMAT_MACROS
-
 #include <boost/variant.hpp>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
 #include "stout/check.h"
+#include "stout/footprint.h"
 #include "stout/foreach.h"
 #include "stout/jsonify.h"
+#include "stout/jsonindex.h"
+#include "stout/nothing.h"
 #include "stout/numify.h"
+#include "stout/option.h"
 #include "stout/result.h"
 #include "stout/strings.h"
 #include "stout/try.h"
@@ -91,11 +83,11 @@ struct String {
 
 ////////////////////////////////////////////////////////////////////////
 
-// NOTE: Due to how PicoJson parses unsigned integers, a roundtrip from Number
-// to JSON and back to Number will result in:
+// NOTE: A roundtrip from Number to JSON and back to Number will result in:
 //   - a signed integer, if the value is less than or equal to INT64_MAX;
-//   - or a double, if the value is greater than INT64_MAX.
-// See: https://github.com/kazuho/picojson/blob/rel/v1.3.0/picojson.h#L777-L781
+//   - an unsigned integer, if the value is greater than INT64_MAX;
+//   - or a double, if the value is a double (doubles are written with the
+//     fewest digits that parse back to the same double).
 struct Number {
   Number()
     : value(0) {}
@@ -163,6 +155,37 @@ struct Number {
 
 ////////////////////////////////////////////////////////////////////////
 
+// A path into a JSON object, as taken by 'Object::find', that is
+// parsed once up front so that finding it repeatedly doesn't split the
+// path and parse its array subscripts every time:
+//
+//   static const JSON::Path path =
+//     JSON::Path::parse("nested.array[0]").get();
+//
+//   Result<const JSON::Object*> object = value.find<JSON::Object>(path);
+class Path {
+ public:
+  // Returns an error if an array subscript is malformed (these are
+  // only found by 'Object::find(const std::string&)' once it gets to
+  // them).
+  static Try<Path> parse(const std::string& path);
+
+ private:
+  friend class LazyValue;
+  friend struct Object;
+
+  struct Step {
+    std::string name;
+    Option<size_t> subscript;
+  };
+
+  Path() = default;
+
+  std::vector<Step> steps;
+};
+
+////////////////////////////////////////////////////////////////////////
+
 struct Object {
   Object() = default;
 
@@ -189,6 +212,12 @@ struct Object {
   template <typename T>
   Result<T> find(const std::string& path) const;
 
+  // Like above but with a parsed path, and without copying anything:
+  // returns a pointer to the value found, which is valid for as long
+  // as the object isn't modified.
+  template <typename T>
+  Result<const T*> find(const Path& path) const;
+
   // Returns the JSON value by indexing this object with the key. Unlike
   // find(), the key is not a path into the JSON structure, it is just
   // a JSON object key name.
@@ -497,6 +526,91 @@ Result<T> Object::find(const std::string& path) const {
 
 ////////////////////////////////////////////////////////////////////////
 
+inline Try<Path> Path::parse(const std::string& path) {
+  Path result;
+
+  foreach (const std::string& name, strings::split(path, ".")) {
+    Step step;
+    step.name = name;
+
+    size_t index = name.find('[');
+    if (index != std::string::npos) {
+      if (name.at(name.length() - 1) != ']') {
+        return Error("Malformed array subscript, expecting ']'");
+      }
+
+      std::string s = name.substr(index + 1, name.length() - index - 2);
+
+      Try<int> i = numify<int>(s);
+
+      if (i.isError()) {
+        return Error("Failed to numify array subscript '" + s + "'");
+      } else if (i.get() < 0) {
+        return Error("Array subscript '" + s + "' must be >= 0");
+      }
+
+      step.subscript = i.get();
+      step.name = name.substr(0, index);
+    }
+
+    result.steps.push_back(std::move(step));
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Result<const T*> Object::find(const Path& path) const {
+  const Object* object = this;
+
+  for (size_t i = 0;; i++) {
+    const Path::Step& step = path.steps[i];
+
+    std::map<std::string, Value>::const_iterator entry =
+      object->values.find(step.name);
+
+    if (entry == object->values.end()) {
+      return None();
+    }
+
+    const Value* value = &entry->second;
+
+    if (step.subscript.isSome()) {
+      if (value->is<Array>()) {
+        const std::vector<Value>& values = value->as<Array>().values;
+        if (step.subscript.get() >= values.size()) {
+          return None();
+        }
+        value = &values[step.subscript.get()];
+      } else if (value->is<Null>()) {
+        return None();
+      } else {
+        return Error("Intermediate JSON value not an array");
+      }
+    }
+
+    if (i + 1 == path.steps.size()) {
+      if (value->is<T>()) {
+        return &value->as<T>();
+      } else if (value->is<Null>()) {
+        return None();
+      } else {
+        return Error("Found JSON value of wrong type");
+      }
+    }
+
+    if (!value->is<Object>()) {
+      return Error("Intermediate JSON value not an object");
+    }
+
+    object = &value->as<Object>();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+
 template <typename T>
 Result<T> Object::at(const std::string& key) const {
   if (key.empty()) {
@@ -915,93 +1029,273 @@ constexpr size_t STOUT_JSON_MAX_DEPTH = 200;
 
 ////////////////////////////////////////////////////////////////////////
 
-// Our implementation of picojson's parsing context that allows
-// us to parse directly into our JSON::Value.
-//
-// https://github.com/kazuho/picojson/blob/v1.3.0/picojson.h#L820-L870
-class ParseContext {
+// The second stage of parsing (see stout/jsonindex.h for the first),
+// which walks the positions of the tokens found by the first stage
+// and builds the 'Value' directly. It accepts exactly what picojson
+// does (including its number syntax) but reports errors with return
+// values rather than exceptions.
+class Parser {
  public:
-  ParseContext(Value* _value, size_t _depth = STOUT_JSON_MAX_DEPTH)
-    : value(_value),
-      depth(_depth) {}
+  explicit Parser(std::string_view _input) : input(_input) {}
 
-  ParseContext(const ParseContext&) = delete;
-  ParseContext& operator=(const ParseContext&) = delete;
+  Try<Value> parse() {
+    Try<Nothing> indexed = index(input, &positions);
+    if (indexed.isError()) {
+      return Error(indexed.error());
+    }
 
-  bool set_null() {
-    *value = Null();
-    return true;
+    // Count the elements of each array so that they can be reserved
+    // up front: 'Value' isn't nothrow movable so growing a vector of
+    // them copies them.
+    count(input, positions, &sizes);
+
+    Value value;
+    construct([&](auto&& empty) { value = empty; });
+    if (!parse(&value, STOUT_JSON_MAX_DEPTH)) {
+      return Error(error.isSome() ? error.get() : syntaxError(input, failed));
+    }
+
+    if (next < positions.size()) {
+      const size_t begin = positions[next];
+      const size_t end = input.find_last_not_of(strings::WHITESPACE) + 1;
+      return Error(
+          "Parsed JSON included non-whitespace trailing characters: "
+          + std::string(input.substr(begin, end - begin)));
+    }
+
+    return std::move(value);
   }
-  bool set_bool(bool b) {
-    *value = Boolean(b);
-    return true;
+
+ private:
+  // Returns the character at the next position, or '\0' if there are
+  // no more positions.
+  char peek() const {
+    return next < positions.size() ? input[positions[next]] : '\0';
   }
-  bool set_int64(int64_t i) {
-    *value = Number(i);
-    return true;
+
+  // Calls 'f' with an empty value of the type of the next token, so
+  // that the value can be constructed with that type rather than
+  // assigned (assigning an object, array or string to a 'Value' of
+  // another type constructs it twice).
+  template <typename F>
+  void construct(F&& f) {
+    switch (peek()) {
+      case '{':
+        f(Object());
+        break;
+      case '[':
+        f(Array());
+        break;
+      case '"':
+        f(String());
+        break;
+      default:
+        f(Null());
+        break;
+    }
   }
 
-  bool set_number(double f) {
-    // We take a trip through picojson::value here because it
-    // is where the validation takes place (i.e. it throws):
-    //   https://github.com/kazuho/picojson/issues/94
-    //   https://github.com/kazuho/picojson/blob/v1.3.0/picojson.h#L195-L208
-    picojson::value v(f);
-    *value = Number(v.get<double>());
-    return true;
+  // Returns false after recording where parsing failed.
+  bool fail() {
+    failed = next < positions.size() ? positions[next] : input.size();
+    return false;
   }
 
-  template <typename Iter>
-  bool parse_string(picojson::input<Iter>& in) {
-    *value = String();
-    return picojson::_parse_string(value->as<String>().value, in);
+  bool parse(Value* value, size_t depth) {
+    switch (peek()) {
+      case '{':
+        return parseObject(value, depth);
+      case '[':
+        return parseArray(value, depth);
+      case '"': {
+        if (!value->is<String>()) {
+          *value = String();
+        }
+        return parseString(&value->as<String>().value);
+      }
+      case 't':
+        return parseLiteral("true", value, Boolean(true));
+      case 'f':
+        return parseLiteral("false", value, Boolean(false));
+      case 'n':
+        return parseLiteral("null", value, Null());
+      case '-':
+      case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
+        return parseNumber(value);
+      default:
+        return fail();
+    }
   }
 
-  bool parse_array_start() {
-    if (depth <= 0) {
-      return false;
+  bool parseObject(Value* value, size_t depth) {
+    if (depth == 0) {
+      return fail();
+    }
+
+    if (!value->is<Object>()) {
+      *value = Object();
+    }
+    std::map<std::string, Value>& values = value->as<Object>().values;
+    values.clear();
+
+    // Objects aren't reserved.
+    size++;
+
+    next++;
+    if (peek() == '}') {
+      next++;
+      return true;
+    }
+
+    std::string key;
+    while (true) {
+      if (peek() != '"') {
+        return fail();
+      } else if (!parseString(&key)) {
+        return false;
+      }
+
+      if (peek() != ':') {
+        return fail();
+      }
+      next++;
+
+      // Like picojson, a duplicate key replaces the earlier value.
+      // Hint that the key goes at the end since objects are usually
+      // written by us, i.e., from a 'std::map', with sorted keys.
+      auto iterator = values.end();
+      construct([&](auto&& empty) {
+        iterator = values.emplace_hint(values.end(), std::move(key), empty);
+      });
+      if (!parse(&iterator->second, depth - 1)) {
+        return false;
+      }
+
+      const char c = peek();
+      next++;
+      if (c == '}') {
+        return true;
+      } else if (c != ',') {
+        next--;
+        return fail();
+      }
     }
-    --depth;
-    *value = Array();
-    return true;
   }
 
-  template <typename Iter>
-  bool parse_array_item(picojson::input<Iter>& in, size_t) {
-    Array& array = value->as<Array>();
-    array.values.push_back(Value());
-    ParseContext context(&array.values.back(), depth);
-    return picojson::_parse(context, in);
+  bool parseArray(Value* value, size_t depth) {
+    if (depth == 0) {
+      return fail();
+    }
+
+    if (!value->is<Array>()) {
+      *value = Array();
+    }
+    std::vector<Value>& values = value->as<Array>().values;
+    values.clear();
+    values.reserve(sizes[size++]);
+
+    next++;
+    if (peek() == ']') {
+      next++;
+      return true;
+    }
+
+    while (true) {
+      construct([&](auto&& empty) { values.emplace_back(empty); });
+      if (!parse(&values.back(), depth - 1)) {
+        return false;
+      }
+
+      const char c = peek();
+      next++;
+      if (c == ']') {
+        return true;
+      } else if (c != ',') {
+        next--;
+        return fail();
+      }
+    }
   }
 
-  bool parse_array_stop(size_t) {
-    ++depth;
+  // Parses the string between the quotes at the next two positions.
+  bool parseString(std::string* out) {
+    // The first stage guarantees that quotes come in pairs.
+    const char* begin = input.data() + positions[next] + 1;
+    const char* end = input.data() + positions[next + 1];
+
+    if (memchr(begin, '\\', end - begin) == nullptr) {
+      out->assign(begin, end - begin);
+    } else {
+      out->resize(end - begin);
+      const char* invalid = nullptr;
+      char* last = unescape(begin, end, &(*out)[0], &invalid);
+      if (last == nullptr) {
+        failed = invalid - input.data();
+        return false;
+      }
+      out->resize(last - out->data());
+    }
+
+    next += 2;
     return true;
   }
 
-  bool parse_object_start() {
-    if (depth <= 0) {
-      return false;
+  template <typename T>
+  bool parseLiteral(std::string_view literal, Value* value, const T& t) {
+    const size_t begin = positions[next];
+    if (input.substr(begin, literal.size()) != literal ||
+        !ends(input, begin + literal.size())) {
+      return fail();
     }
-    --depth;
-    *value = Object();
+
+    *value = t;
+    next++;
     return true;
   }
 
-  template <typename Iter>
-  bool parse_object_item(picojson::input<Iter>& in, const std::string& key) {
-    Object& object = value->as<Object>();
-    ParseContext context(&object.values[key], depth);
-    return picojson::_parse(context, in);
-  }
+  bool parseNumber(Value* value) {
+    const ParsedNumber number = internal::parseNumber(input, positions[next]);
+
+    switch (number.type) {
+      case ParsedNumber::INVALID:
+        return fail();
+      case ParsedNumber::OUT_OF_RANGE:
+        error = "Value out of range";
+        return false;
+      case ParsedNumber::INTEGER:
+        *value = Number(number.integer);
+        break;
+      case ParsedNumber::UNSIGNED_INTEGER:
+        *value = Number(number.unsigned_integer);
+        break;
+      case ParsedNumber::FLOATING:
+        *value = Number(number.floating);
+        break;
+    }
 
-  bool parse_object_stop() {
-    ++depth;
+    next++;
     return true;
   }
 
-  Value* value;
-  size_t depth;
+  const std::string_view input;
+
+  // The positions of the tokens, see 'index'.
+  std::vector<uint32_t> positions;
+
+  // The index of the next position to parse.
+  size_t next = 0;
+
+  // The number of elements of each array and object, see 'count'.
+  std::vector<uint32_t> sizes;
+
+  // The index of the size of the next array or object in 'sizes'.
+  size_t size = 0;
+
+  // Where parsing failed, used for the error message unless 'error'
+  // is set.
+  size_t failed = 0;
+  Option<std::string> error;
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -1010,50 +1304,11 @@ class ParseContext {
 
 ////////////////////////////////////////////////////////////////////////
 
+// Parses 's' with a two stage parser: the first stage finds the
+// positions of the tokens 64 bytes at a time (see stout/jsonindex.h)
+// and the second stage builds the value from them.
 inline Try<Value> parse(const std::string& s) {
-  const char* parseBegin = s.c_str();
-  Value value;
-  std::string error;
-
-  // Because PicoJson supports repeated parsing of multiple objects/arrays in a
-  // stream, it will quietly ignore trailing non-whitespace characters. We
-  // would rather throw an error, however, so use `last_char` to check for
-  // this.
-  //
-  // TODO(alexr): Address cases when `s` is empty or consists only of
-  // whitespace characters.
-  const char* lastVisibleChar =
-      parseBegin + s.find_last_not_of(strings::WHITESPACE);
-
-  // Parse the string, returning a pointer to the character immediately
-  // following the last one parsed. Convert exceptions to `Error`s.
-  //
-  // TODO(alexr): Remove `try-catch` wrapper once picojson stops throwing
-  // on parsing, see https://github.com/kazuho/picojson/issues/94
-  const char* parseEnd;
-  try {
-    internal::ParseContext context(&value);
-    parseEnd =
-        picojson::_parse(context, parseBegin, parseBegin + s.size(), &error);
-  } catch (const std::overflow_error&) {
-    return Error("Value out of range");
-  } catch (...) {
-    return Error("Unknown JSON parse error");
-  }
-
-  if (!error.empty()) {
-    return Error(error);
-  } else if (parseEnd != lastVisibleChar + 1) {
-    return Error(
-        "Parsed JSON included non-whitespace trailing characters: "
-        + s.substr(parseEnd - parseBegin, lastVisibleChar + 1 - parseEnd));
-  }
-
-  // TODO(bmahler): Newer compilers (clang-3.9 and gcc-5.1) can
-  // perform a move into the resultant Try with optimization on.
-  // Consider removing the `std::move` when we require these
-  // compilers.
-  return std::move(value);
+  return internal::Parser(s).parse();
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1082,6 +1337,36 @@ inline Try<Value> parse(const std::string& s) {
 
 ////////////////////////////////////////////////////////////////////////
 
+// Estimates the heap used by JSON values, see stout/footprint.h.
+inline size_t heapFootprint(const String& string) {
+  return stout::heapFootprint(string.value);
+}
+
+
+inline size_t heapFootprint(const Object& object) {
+  return stout::heapFootprint(object.values);
+}
+
+
+inline size_t heapFootprint(const Array& array) {
+  return stout::heapFootprint(array.values);
+}
+
+
+inline size_t heapFootprint(const Value& value) {
+  // Objects and arrays are allocated separately by the variant.
+  if (value.is<Object>()) {
+    return sizeof(Object) + stout::heapFootprint(value.as<Object>());
+  } else if (value.is<Array>()) {
+    return sizeof(Array) + stout::heapFootprint(value.as<Array>());
+  } else if (value.is<String>()) {
+    return stout::heapFootprint(value.as<String>());
+  }
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+
 } // namespace JSON
 
 ////////////////////////////////////////////////////////////////////////
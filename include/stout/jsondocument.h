@@ -0,0 +1,841 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stout/arena.h"
+#include "stout/check.h"
+#include "stout/error.h"
+#include "stout/json.h"
+#include "stout/jsonindex.h"
+#include "stout/none.h"
+#include "stout/numify.h"
+#include "stout/option.h"
+#include "stout/result.h"
+#include "stout/strings.h"
+#include "stout/try.h"
+#include "stout/unreachable.h"
+
+namespace JSON {
+
+class ArrayView;
+class Document;
+class ObjectView;
+struct Member;
+
+namespace internal {
+class DocumentParser;
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// A read-only view of a value in a 'Document'. A view is 16 bytes and
+// is cheap to copy: strings, arrays and objects point into the
+// document and are only valid for as long as the document is.
+//
+// Like 'Value', use 'is<T>()' to check the type of the value and
+// 'as<T>()' to get it, where 'T' is one of 'Null', 'Boolean',
+// 'Number', 'String' (which copies the string), 'std::string_view',
+// 'ArrayView', 'ObjectView' or 'ValueView'.
+class ValueView {
+ public:
+  ValueView() : type(NIL), size(0), integer(0) {}
+
+  template <typename T>
+  bool is() const;
+
+  // Returns the value as a 'T', which must be the type of the value.
+  template <typename T>
+  T as() const;
+
+  // Copies the value (and everything it contains) into a 'Value'.
+  Value toValue() const;
+
+ private:
+  friend class Document;
+  friend class internal::DocumentParser;
+
+  enum Type : uint32_t {
+    NIL,
+    BOOLEAN,
+    INTEGER,
+    UNSIGNED_INTEGER,
+    FLOATING,
+    STRING,
+    ARRAY,
+    OBJECT,
+  } type;
+
+  // The length of a string or the number of elements (or members) of
+  // an array (or object).
+  uint32_t size;
+
+  union {
+    bool boolean;
+    int64_t integer;
+    uint64_t unsigned_integer;
+    double floating;
+    const char* string;
+    const ValueView* elements;
+    const Member* members;
+  };
+};
+
+////////////////////////////////////////////////////////////////////////
+
+struct Member {
+  std::string_view key;
+  ValueView value;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// A read-only view of an array in a 'Document'.
+class ArrayView {
+ public:
+  typedef const ValueView* const_iterator;
+
+  ArrayView() : elements(nullptr), size_(0) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const { return elements; }
+  const_iterator end() const { return elements + size_; }
+
+  const ValueView& operator[](size_t index) const {
+    return elements[index];
+  }
+
+ private:
+  friend class ValueView;
+
+  ArrayView(const ValueView* _elements, size_t _size)
+    : elements(_elements), size_(_size) {}
+
+  const ValueView* elements;
+  size_t size_;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// A read-only view of an object in a 'Document'. The members are
+// sorted by key (so iterating an object visits the keys in the same
+// order as iterating an 'Object') and, like 'Object', a duplicate key
+// keeps the last value.
+class ObjectView {
+ public:
+  typedef const Member* const_iterator;
+
+  ObjectView() : members(nullptr), size_(0) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const { return members; }
+  const_iterator end() const { return members + size_; }
+
+  // Returns the value of the member with 'key' (a binary search).
+  Option<ValueView> get(std::string_view key) const;
+
+  // Like 'Object::find' and 'Object::at' (with the same path syntax
+  // and errors) but without copying any values along the way.
+  template <typename T>
+  Result<T> find(std::string_view path) const;
+
+  template <typename T>
+  Result<T> at(std::string_view key) const;
+
+ private:
+  friend class ValueView;
+
+  ObjectView(const Member* _members, size_t _size)
+    : members(_members), size_(_size) {}
+
+  const Member* members;
+  size_t size_;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// A parsed JSON document that owns its text and refers to it rather
+// than copying it: strings are unescaped in place and are views into
+// the text, and arrays and objects are contiguous runs of views that
+// are all allocated from a single arena (their sizes are known up
+// front from the structural index, see stout/jsonindex.h). A document
+// is therefore much cheaper to build and to free than a 'Value', which
+// allocates every string, array and object separately:
+//
+//   Try<JSON::Document> document = JSON::Document::parse(body);
+//   Result<std::string_view> name =
+//     document->root().as<JSON::ObjectView>()
+//       .find<std::string_view>("framework.name");
+//
+// The arena can be shared, e.g., by all of the documents parsed while
+// handling a request, in which case resetting it frees all of their
+// arrays and objects at once. The documents must not be used after
+// the arena is reset or destroyed.
+class Document {
+ public:
+  static Try<Document> parse(std::string json, stout::Arena* arena = nullptr);
+
+  ValueView root() const {
+    return state->root;
+  }
+
+  // Returns the number of bytes of the text and allocated from the
+  // arena for this document.
+  size_t bytes() const {
+    return state->json.capacity() + state->allocated;
+  }
+
+ private:
+  friend class internal::DocumentParser;
+
+  struct State {
+    std::string json;
+    std::unique_ptr<stout::Arena> arena;
+    ValueView root;
+    size_t allocated = 0;
+  };
+
+  Document() : state(new State()) {}
+
+  // The state is allocated separately so that moving a document
+  // doesn't move the text (which a short string would be), which the
+  // views point into.
+  std::unique_ptr<State> state;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+// The second stage of parsing a 'Document', like 'Parser' but building
+// views into the (mutable) text instead of values.
+class DocumentParser {
+ public:
+  DocumentParser(std::string* _json, stout::Arena* _arena)
+    : json(_json), input(*_json), arena(_arena) {}
+
+  Try<ValueView> parse() {
+    Try<Nothing> indexed = index(input, &positions);
+    if (indexed.isError()) {
+      return Error(indexed.error());
+    }
+
+    count(input, positions, &sizes);
+
+    ValueView value;
+    if (!parse(&value, STOUT_JSON_MAX_DEPTH)) {
+      return Error(error.isSome() ? error.get() : syntaxError());
+    }
+
+    if (next < positions.size()) {
+      const size_t begin = positions[next];
+      const size_t end = input.find_last_not_of(strings::WHITESPACE) + 1;
+      return Error(
+          "Parsed JSON included non-whitespace trailing characters: "
+          + std::string(input.substr(begin, end - begin)));
+    }
+
+    return value;
+  }
+
+  // The number of bytes allocated from the arena.
+  size_t allocated = 0;
+
+ private:
+  char peek() const {
+    return next < positions.size() ? input[positions[next]] : '\0';
+  }
+
+  bool fail() {
+    failed = next < positions.size() ? positions[next] : input.size();
+    return false;
+  }
+
+  // Returns the error for a syntax error at 'failed'. Strings can't
+  // contain (unescaped) newlines, so any newlines in the strings that
+  // were unescaped in place before 'failed' weren't in the input.
+  std::string syntaxError() const {
+    size_t added = 0;
+    for (size_t i = 0; i + 1 < positions.size(); i++) {
+      if (positions[i] >= failed) {
+        break;
+      } else if (input[positions[i]] == '"') {
+        const char* begin = input.data() + positions[i] + 1;
+        const char* end =
+          input.data() + std::min<size_t>(positions[i + 1], failed);
+        added += std::count(begin, end, '\n');
+        i++;
+      }
+    }
+
+    return internal::syntaxError(input, failed, added);
+  }
+
+  template <typename T>
+  T* allocate(size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value);
+    allocated += count * sizeof(T);
+    return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  bool parse(ValueView* value, size_t depth) {
+    switch (peek()) {
+      case '{':
+        return parseObject(value, depth);
+      case '[':
+        return parseArray(value, depth);
+      case '"':
+        return parseString(value);
+      case 't':
+        return parseLiteral("true", value, ValueView::BOOLEAN, true);
+      case 'f':
+        return parseLiteral("false", value, ValueView::BOOLEAN, false);
+      case 'n':
+        return parseLiteral("null", value, ValueView::NIL, false);
+      case '-':
+      case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
+        return parseNumber(value);
+      default:
+        return fail();
+    }
+  }
+
+  bool parseObject(ValueView* value, size_t depth) {
+    if (depth == 0) {
+      return fail();
+    }
+
+    // The size counted by the first stage is exact unless the input
+    // is malformed, which is caught below before it's exceeded.
+    const uint32_t capacity = sizes[size++];
+    Member* members = allocate<Member>(capacity);
+
+    value->type = ValueView::OBJECT;
+    value->size = 0;
+    value->members = members;
+
+    next++;
+    if (peek() == '}') {
+      next++;
+      return true;
+    }
+
+    uint32_t count = 0;
+    while (true) {
+      if (count == capacity || peek() != '"') {
+        return fail();
+      }
+
+      Member* member = new (&members[count++]) Member();
+
+      ValueView key;
+      if (!parseString(&key)) {
+        return false;
+      }
+      member->key = std::string_view(key.string, key.size);
+
+      if (peek() != ':') {
+        return fail();
+      }
+      next++;
+
+      if (!parse(&member->value, depth - 1)) {
+        return false;
+      }
+
+      const char c = peek();
+      next++;
+      if (c == '}') {
+        value->size = sort(members, count);
+        return true;
+      } else if (c != ',') {
+        next--;
+        return fail();
+      }
+    }
+  }
+
+  // Sorts the members by key, keeping only the last of any duplicate
+  // keys, and returns how many are left. Objects are usually written
+  // with sorted keys (e.g., by 'jsonify' from a 'std::map') so this is
+  // usually just a check.
+  static uint32_t sort(Member* members, uint32_t count) {
+    auto less = [](const Member& left, const Member& right) {
+      return left.key < right.key;
+    };
+
+    auto unsorted = [](const Member& left, const Member& right) {
+      return left.key >= right.key;
+    };
+
+    if (std::adjacent_find(members, members + count, unsorted) ==
+        members + count) {
+      return count;
+    }
+
+    std::stable_sort(members, members + count, less);
+
+    uint32_t last = 0;
+    for (uint32_t i = 1; i < count; i++) {
+      if (members[i].key != members[last].key) {
+        last++;
+      }
+      members[last] = members[i];
+    }
+
+    return last + 1;
+  }
+
+  bool parseArray(ValueView* value, size_t depth) {
+    if (depth == 0) {
+      return fail();
+    }
+
+    const uint32_t capacity = sizes[size++];
+    ValueView* elements = allocate<ValueView>(capacity);
+
+    value->type = ValueView::ARRAY;
+    value->size = 0;
+    value->elements = elements;
+
+    next++;
+    if (peek() == ']') {
+      next++;
+      return true;
+    }
+
+    while (true) {
+      if (value->size == capacity) {
+        return fail();
+      }
+
+      ValueView* element = new (&elements[value->size++]) ValueView();
+      if (!parse(element, depth - 1)) {
+        return false;
+      }
+
+      const char c = peek();
+      next++;
+      if (c == ']') {
+        return true;
+      } else if (c != ',') {
+        next--;
+        return fail();
+      }
+    }
+  }
+
+  // Unescapes the string in place, which never makes it longer.
+  bool parseString(ValueView* value) {
+    char* begin = &(*json)[0] + positions[next] + 1;
+    const char* end = input.data() + positions[next + 1];
+
+    const char* last = end;
+    if (memchr(begin, '\\', end - begin) != nullptr) {
+      const char* invalid = nullptr;
+      last = unescape(begin, end, begin, &invalid);
+      if (last == nullptr) {
+        failed = invalid - input.data();
+        return false;
+      }
+    }
+
+    value->type = ValueView::STRING;
+    value->size = static_cast<uint32_t>(last - begin);
+    value->string = begin;
+
+    next += 2;
+    return true;
+  }
+
+  bool parseLiteral(
+      std::string_view literal,
+      ValueView* value,
+      ValueView::Type type,
+      bool boolean) {
+    const size_t begin = positions[next];
+    if (input.substr(begin, literal.size()) != literal ||
+        !ends(input, begin + literal.size())) {
+      return fail();
+    }
+
+    value->type = type;
+    value->boolean = boolean;
+    next++;
+    return true;
+  }
+
+  bool parseNumber(ValueView* value) {
+    const ParsedNumber number = internal::parseNumber(input, positions[next]);
+
+    switch (number.type) {
+      case ParsedNumber::INVALID:
+        return fail();
+      case ParsedNumber::OUT_OF_RANGE:
+        error = "Value out of range";
+        return false;
+      case ParsedNumber::INTEGER:
+        value->type = ValueView::INTEGER;
+        value->integer = number.integer;
+        break;
+      case ParsedNumber::UNSIGNED_INTEGER:
+        value->type = ValueView::UNSIGNED_INTEGER;
+        value->unsigned_integer = number.unsigned_integer;
+        break;
+      case ParsedNumber::FLOATING:
+        value->type = ValueView::FLOATING;
+        value->floating = number.floating;
+        break;
+    }
+
+    next++;
+    return true;
+  }
+
+  std::string* json;
+  const std::string_view input;
+  stout::Arena* arena;
+
+  std::vector<uint32_t> positions;
+  size_t next = 0;
+
+  std::vector<uint32_t> sizes;
+  size_t size = 0;
+
+  size_t failed = 0;
+  Option<std::string> error;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+inline Try<Document> Document::parse(std::string json, stout::Arena* arena) {
+  Document document;
+  document.state->json = std::move(json);
+
+  if (arena == nullptr) {
+    document.state->arena.reset(new stout::Arena());
+    arena = document.state->arena.get();
+  }
+
+  internal::DocumentParser parser(&document.state->json, arena);
+
+  Try<ValueView> root = parser.parse();
+  if (root.isError()) {
+    return Error(root.error());
+  }
+
+  document.state->root = root.get();
+  document.state->allocated = parser.allocated;
+
+  return std::move(document);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <>
+inline bool ValueView::is<ValueView>() const {
+  return true;
+}
+
+
+template <>
+inline bool ValueView::is<Null>() const {
+  return type == NIL;
+}
+
+
+template <>
+inline bool ValueView::is<Boolean>() const {
+  return type == BOOLEAN;
+}
+
+
+template <>
+inline bool ValueView::is<Number>() const {
+  return type == INTEGER || type == UNSIGNED_INTEGER || type == FLOATING;
+}
+
+
+template <>
+inline bool ValueView::is<String>() const {
+  return type == STRING;
+}
+
+
+template <>
+inline bool ValueView::is<std::string_view>() const {
+  return type == STRING;
+}
+
+
+template <>
+inline bool ValueView::is<ArrayView>() const {
+  return type == ARRAY;
+}
+
+
+template <>
+inline bool ValueView::is<ObjectView>() const {
+  return type == OBJECT;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <>
+inline ValueView ValueView::as<ValueView>() const {
+  return *this;
+}
+
+
+template <>
+inline Null ValueView::as<Null>() const {
+  CHECK(is<Null>());
+  return Null();
+}
+
+
+template <>
+inline Boolean ValueView::as<Boolean>() const {
+  CHECK(is<Boolean>());
+  return Boolean(boolean);
+}
+
+
+template <>
+inline Number ValueView::as<Number>() const {
+  CHECK(is<Number>());
+  switch (type) {
+    case INTEGER:
+      return Number(integer);
+    case UNSIGNED_INTEGER:
+      return Number(unsigned_integer);
+    default:
+      return Number(floating);
+  }
+}
+
+
+template <>
+inline std::string_view ValueView::as<std::string_view>() const {
+  CHECK(is<std::string_view>());
+  return std::string_view(string, size);
+}
+
+
+template <>
+inline String ValueView::as<String>() const {
+  return String(std::string(as<std::string_view>()));
+}
+
+
+template <>
+inline ArrayView ValueView::as<ArrayView>() const {
+  CHECK(is<ArrayView>());
+  return ArrayView(elements, size);
+}
+
+
+template <>
+inline ObjectView ValueView::as<ObjectView>() const {
+  CHECK(is<ObjectView>());
+  return ObjectView(members, size);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline Value ValueView::toValue() const {
+  switch (type) {
+    case NIL:
+      return Null();
+    case BOOLEAN:
+      return Boolean(boolean);
+    case INTEGER:
+      return Number(integer);
+    case UNSIGNED_INTEGER:
+      return Number(unsigned_integer);
+    case FLOATING:
+      return Number(floating);
+    case STRING:
+      return as<String>();
+    case ARRAY: {
+      Value value = Array();
+      std::vector<Value>& values = value.as<Array>().values;
+      values.reserve(size);
+      for (const ValueView& element : as<ArrayView>()) {
+        values.push_back(element.toValue());
+      }
+      return value;
+    }
+    case OBJECT: {
+      Value value = Object();
+      std::map<std::string, Value>& values = value.as<Object>().values;
+      for (const Member& member : as<ObjectView>()) {
+        values.emplace_hint(
+            values.end(),
+            std::string(member.key),
+            member.value.toValue());
+      }
+      return value;
+    }
+  }
+
+  UNREACHABLE();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline Option<ValueView> ObjectView::get(std::string_view key) const {
+  const Member* member = std::lower_bound(
+      begin(),
+      end(),
+      key,
+      [](const Member& member, std::string_view key) {
+        return member.key < key;
+      });
+
+  if (member == end() || member->key != key) {
+    return None();
+  }
+
+  return member->value;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Result<T> ObjectView::find(std::string_view path) const {
+  ObjectView object = *this;
+
+  while (true) {
+    if (path.empty()) {
+      return None();
+    }
+
+    const size_t dot = path.find('.');
+    std::string_view name = path.substr(0, dot);
+    path = dot == std::string_view::npos
+      ? std::string_view()
+      : path.substr(dot + 1);
+
+    // Determine if we have an array subscript. If so, save it but
+    // remove it from the name for doing the lookup.
+    Option<size_t> subscript = None();
+    const size_t index = name.find('[');
+    if (index != std::string_view::npos) {
+      if (name.back() != ']') {
+        return Error("Malformed array subscript, expecting ']'");
+      }
+
+      const std::string s(name.substr(index + 1, name.size() - index - 2));
+
+      Try<int> i = numify<int>(s);
+      if (i.isError()) {
+        return Error("Failed to numify array subscript '" + s + "'");
+      } else if (i.get() < 0) {
+        return Error("Array subscript '" + s + "' must be >= 0");
+      }
+
+      subscript = i.get();
+      name = name.substr(0, index);
+    }
+
+    Option<ValueView> value = object.get(name);
+    if (value.isNone()) {
+      return None();
+    }
+
+    if (subscript.isSome()) {
+      if (value->is<ArrayView>()) {
+        const ArrayView array = value->as<ArrayView>();
+        if (subscript.get() >= array.size()) {
+          return None();
+        }
+        value = array[subscript.get()];
+      } else if (value->is<Null>()) {
+        return None();
+      } else {
+        return Error("Intermediate JSON value not an array");
+      }
+    }
+
+    if (dot == std::string_view::npos) {
+      if (value->is<T>()) {
+        return value->as<T>();
+      } else if (value->is<Null>()) {
+        return None();
+      } else {
+        return Error("Found JSON value of wrong type");
+      }
+    }
+
+    if (!value->is<ObjectView>()) {
+      return Error("Intermediate JSON value not an object");
+    }
+
+    object = value->as<ObjectView>();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Result<T> ObjectView::at(std::string_view key) const {
+  if (key.empty()) {
+    return None();
+  }
+
+  Option<ValueView> value = get(key);
+  if (value.isNone()) {
+    return None();
+  }
+
+  if (!value->is<T>()) {
+    return Error("Found JSON value of wrong type");
+  }
+
+  return value->as<T>();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// Estimates the heap used by a document, see stout/footprint.h.
+inline size_t heapFootprint(const Document& document) {
+  return document.bytes();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace JSON
@@ -0,0 +1,186 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <boost/preprocessor/variadic/to_seq.hpp>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stout/error.h"
+#include "stout/jsonify.h"
+#include "stout/jsonlazy.h"
+#include "stout/nothing.h"
+#include "stout/result.h"
+#include "stout/stringify.h"
+#include "stout/try.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// Declares the fields of a plain struct that `jsonify` writes and
+// `JSON::decode` reads, in place of a hand-written `json` function and
+// parsing into a `JSON::Value` and calling `find` for each field:
+//
+//   struct Task {
+//     std::string id;
+//     double cpus;
+//     std::vector<std::string> labels;
+//   };
+//
+//   STOUT_JSON_FIELDS(Task, id, cpus, labels)
+//
+//   std::string s = jsonify(task); // {"id":...,"cpus":...,"labels":[...]}
+//
+//   Try<Task> task = JSON::decode<Task>(s);
+//
+// This defines a `json(JSON::ObjectWriter*, const Task&)` function
+// that writes the fields in order, the same as calling `field` for
+// each of them does, except that the keys are quoted when compiling
+// (the names of fields never need to be escaped), and a `decode`
+// function for `JSON::decode`. It must be used in the namespace of the
+// type so that both are found by argument dependent lookup, and the
+// fields must be public.
+//
+// The fields can be of any type `JSON::LazyValue::get` decodes (see
+// stout/jsonlazy.h), of another type with `STOUT_JSON_FIELDS`, or a
+// `std::vector` of those.
+#define STOUT_JSON_FIELDS(Type, ...)                                    \
+  inline void json(::JSON::ObjectWriter* writer, const Type& value) {   \
+    BOOST_PP_SEQ_FOR_EACH(                                              \
+        STOUT_JSON_WRITE_FIELD,                                         \
+        _,                                                              \
+        BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                          \
+  }                                                                     \
+                                                                        \
+  inline ::Try<::Nothing> decode(                                       \
+      const ::JSON::LazyValue& json,                                    \
+      Type* value) {                                                    \
+    ::Try<::Nothing> decoded = ::Nothing();                             \
+    BOOST_PP_SEQ_FOR_EACH(                                              \
+        STOUT_JSON_DECODE_FIELD,                                        \
+        _,                                                              \
+        BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                          \
+    return decoded;                                                     \
+  }
+
+
+#define STOUT_JSON_WRITE_FIELD(r, data, field)                          \
+  writer->escapedField(                                                 \
+      "\"" BOOST_PP_STRINGIZE(field) "\"",                              \
+      value.field);
+
+
+#define STOUT_JSON_DECODE_FIELD(r, data, field)                         \
+  decoded = ::JSON::internal::decodeField(                              \
+      json,                                                             \
+      BOOST_PP_STRINGIZE(field),                                        \
+      &value->field);                                                   \
+  if (decoded.isError()) {                                              \
+    return decoded;                                                     \
+  }
+
+////////////////////////////////////////////////////////////////////////
+
+namespace JSON {
+namespace internal {
+
+// Decodes `json` into `value`, leaving `value` as is if `json` isn't
+// found or is null. The `decode` function of a type with
+// `STOUT_JSON_FIELDS` is preferred to this one by overload resolution.
+template <typename T>
+Try<Nothing> decode(const LazyValue& json, T* value) {
+  Result<T> result = json.get<T>();
+  if (result.isError()) {
+    return Error(result.error());
+  } else if (result.isSome()) {
+    *value = std::move(result.get());
+  }
+  return Nothing();
+}
+
+
+template <typename T>
+Try<Nothing> decode(const LazyValue& json, std::vector<T>* values) {
+  Result<std::vector<LazyValue>> elements = json.values();
+  if (elements.isError()) {
+    return Error(elements.error());
+  } else if (elements.isNone()) {
+    return Nothing();
+  }
+
+  std::vector<T> decoded(elements->size());
+  for (size_t i = 0; i < elements->size(); i++) {
+    Try<Nothing> element = decode(elements->at(i), &decoded[i]);
+    if (element.isError()) {
+      return Error(
+          "Failed to decode element " + stringify(i) + ": " +
+          element.error());
+    }
+  }
+
+  *values = std::move(decoded);
+  return Nothing();
+}
+
+
+// Decodes the member of the object `json` with `key` into `value`, see
+// `STOUT_JSON_FIELDS`.
+template <typename T>
+Try<Nothing> decodeField(
+    const LazyValue& json,
+    std::string_view key,
+    T* value) {
+  Try<Nothing> decoded = decode(json[key], value);
+  if (decoded.isError()) {
+    return Error(
+        "Failed to decode '" + std::string(key) + "': " + decoded.error());
+  }
+  return Nothing();
+}
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// Parses `json` into a `T` with `STOUT_JSON_FIELDS` (or a `std::vector`
+// of them) without parsing it into a `JSON::Value` first: the fields
+// are decoded straight from a `JSON::LazyDocument`. Fields that are
+// missing or null are left as `T` initializes them, and members of the
+// object that aren't fields are ignored.
+template <typename T>
+Try<T> decode(std::string json) {
+  Try<LazyDocument> document = LazyDocument::parse(std::move(json));
+  if (document.isError()) {
+    return Error(document.error());
+  }
+
+  T value{};
+
+  // Unqualified so that the `decode` of `T` is found.
+  using internal::decode;
+
+  Try<Nothing> decoded = decode(document->root(), &value);
+  if (decoded.isError()) {
+    return Error(decoded.error());
+  }
+
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace JSON
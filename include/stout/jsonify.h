@@ -35,16 +35,25 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <charconv>
+#include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <ostream>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <type_traits>
 #include <utility>
 
 #include "stout/check.h"
+#include "stout/error.h"
+#include "stout/nothing.h"
+#include "stout/option.h"
 #include "stout/result_of.h"
 #include "stout/strings.h"
+#include "stout/try.h"
 
 ////////////////////////////////////////////////////////////////////////
 
@@ -89,6 +98,242 @@ namespace JSON {
 
 ////////////////////////////////////////////////////////////////////////
 
+// Where `JSON::write` writes to: a function that is given each chunk of
+// the output in order and can return an error to stop writing.
+typedef std::function<Try<Nothing>(std::string_view)> Sink;
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+#ifdef __cpp_lib_to_chars
+// Writes the fewest digits that parse back to the same `value` (which
+// must be finite) to `buffer`, which must have space for 32 characters,
+// and returns the length written. The digits are laid out the same way
+// rapidjson's `Writer::Double` does, e.g., "1.0", "0.001", "1e30" or
+// "1.5e-7", but they're always the shortest (which rapidjson's Grisu2
+// doesn't guarantee).
+inline size_t formatDouble(double value, char* buffer) {
+  char* out = buffer;
+
+  if (std::signbit(value)) {
+    *out++ = '-';
+    value = -value;
+  }
+
+  if (value == 0) {
+    std::memcpy(out, "0.0", 3);
+    return out + 3 - buffer;
+  }
+
+  // The shortest digits with an exponent, e.g., "1.2345e+02".
+  char scientific[32];
+  const std::to_chars_result result = std::to_chars(
+      scientific,
+      scientific + sizeof(scientific),
+      value,
+      std::chars_format::scientific);
+  CHECK(result.ec == std::errc());
+
+  char digits[32];
+  int length = 0;
+  const char* p = scientific;
+  for (; *p != 'e'; p++) {
+    if (*p != '.') {
+      digits[length++] = *p;
+    }
+  }
+
+  const bool negative = *++p == '-';
+  int exponent = 0;
+  for (p++; p < result.ptr; p++) {
+    exponent = exponent * 10 + (*p - '0');
+  }
+  if (negative) {
+    exponent = -exponent;
+  }
+
+  // The value is 0.digits * 10^kk, i.e., digits * 10^k.
+  const int kk = exponent + 1;
+  const int k = kk - length;
+
+  auto write = [&out](const char* data, int size) {
+    std::memcpy(out, data, size);
+    out += size;
+  };
+
+  auto writeExponent = [&out](int exponent) {
+    *out++ = 'e';
+    if (exponent < 0) {
+      *out++ = '-';
+      exponent = -exponent;
+    }
+    out = std::to_chars(out, out + 4, exponent).ptr;
+  };
+
+  if (0 <= k && kk <= 21) {
+    // 1234e7 -> 12340000000.0
+    write(digits, length);
+    std::memset(out, '0', k);
+    out += k;
+    write(".0", 2);
+  } else if (0 < kk && kk <= 21) {
+    // 1234e-2 -> 12.34
+    write(digits, kk);
+    *out++ = '.';
+    write(digits + kk, length - kk);
+  } else if (-6 < kk && kk <= 0) {
+    // 1234e-6 -> 0.001234
+    write("0.", 2);
+    std::memset(out, '0', -kk);
+    out += -kk;
+    write(digits, length);
+  } else if (length == 1) {
+    // 1e30
+    *out++ = digits[0];
+    writeExponent(kk - 1);
+  } else {
+    // 1234e30 -> 1.234e33
+    *out++ = digits[0];
+    *out++ = '.';
+    write(digits + 1, length - 1);
+    writeExponent(kk - 1);
+  }
+
+  return out - buffer;
+}
+#endif // __cpp_lib_to_chars
+
+////////////////////////////////////////////////////////////////////////
+
+// The default size of the buffer that `JSON::write` flushes to a sink.
+constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+////////////////////////////////////////////////////////////////////////
+
+// The buffer of a `JSON::write` in progress. The `ArrayWriter` and
+// `ObjectWriter` flush it to the sink after an element or field once it
+// is full, so only the last element or field written is ever buffered
+// in full. Anything else written while a `JSON::write` is in progress
+// (e.g., a `jsonify` to a string in a `json` function) has a different
+// rapidjson writer and isn't flushed.
+struct Flusher {
+  Flusher(
+      rapidjson::Writer<rapidjson::StringBuffer>* _writer,
+      rapidjson::StringBuffer* _buffer,
+      const Sink& _sink,
+      size_t _size)
+    : writer(_writer),
+      buffer(_buffer),
+      sink(_sink),
+      size(_size) {}
+
+  // Once the sink returns an error the rest of the output is dropped.
+  void flush() {
+    if (error.isNone() && buffer->GetSize() > 0) {
+      Try<Nothing> result =
+        sink(std::string_view(buffer->GetString(), buffer->GetSize()));
+      if (result.isError()) {
+        error = Error(result.error());
+      }
+    }
+
+    // NOTE: This keeps the capacity of the buffer.
+    buffer->Clear();
+  }
+
+  // The `JSON::write` in progress on this thread, or nullptr.
+  static Flusher*& current() {
+    static thread_local Flusher* flusher = nullptr;
+    return flusher;
+  }
+
+  rapidjson::Writer<rapidjson::StringBuffer>* writer;
+  rapidjson::StringBuffer* buffer;
+  const Sink& sink;
+  const size_t size;
+  Option<Error> error;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Flushes the buffer of the `JSON::write` in progress if `writer` is
+// its writer and the buffer is full.
+inline void flush(rapidjson::Writer<rapidjson::StringBuffer>* writer) {
+  Flusher* flusher = Flusher::current();
+  if (flusher != nullptr &&
+      flusher->writer == writer &&
+      flusher->buffer->GetSize() >= flusher->size) {
+    flusher->flush();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// Writes with `write` to `sink` through a buffer of about `size` bytes
+// (which grows as needed so that small values stay cheap).
+template <typename F>
+Try<Nothing> write(const F& write, const Sink& sink, size_t size) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+  Flusher flusher(&writer, &buffer, sink, size);
+
+  Flusher* previous = Flusher::current();
+  Flusher::current() = &flusher;
+  write(&writer);
+  Flusher::current() = previous;
+
+  flusher.flush();
+
+  if (flusher.error.isSome()) {
+    return flusher.error.get();
+  }
+
+  return Nothing();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// Buffers that grew beyond this many bytes aren't kept for reuse.
+constexpr size_t RETAINED_SIZE = 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////
+
+// The rapidjson buffer and writer that `jsonify` renders strings with,
+// one per thread, so that rendering small to medium sized values
+// reuses their memory rather than allocating and growing a new buffer
+// every time. A `jsonify` to a string while another one is in progress
+// on the same thread (e.g., in a `json` function) uses its own buffer.
+struct Buffer {
+  Buffer() : writer(buffer) {}
+
+  static Buffer& local() {
+    static thread_local Buffer buffer;
+    return buffer;
+  }
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer;
+  bool used = false;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Renders `value` with `writer`, see `jsonify` below.
+template <typename T>
+void render(
+    rapidjson::Writer<rapidjson::StringBuffer>* writer,
+    const T& value);
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
 // The result of `jsonify`. This is a light-weight proxy object that can either
 // be implicitly converted to a `std::string`, or directly inserted into an
 // output stream.
@@ -100,12 +345,33 @@ namespace JSON {
 class Proxy {
  public:
   operator std::string() && {
-    rapidjson::StringBuffer buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    internal::Buffer& local = internal::Buffer::local();
+
+    if (local.used) {
+      rapidjson::StringBuffer buffer;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+      write(&writer);
+
+      return {buffer.GetString(), buffer.GetSize()};
+    }
+
+    local.used = true;
+    local.buffer.Clear();
+    local.writer.Reset(local.buffer);
+
+    write(&local.writer);
+
+    std::string result(local.buffer.GetString(), local.buffer.GetSize());
+
+    if (local.buffer.GetSize() > internal::RETAINED_SIZE) {
+      local.buffer.Clear();
+      local.buffer.ShrinkToFit();
+    }
 
-    write(&writer);
+    local.used = false;
 
-    return {buffer.GetString(), buffer.GetSize()};
+    return result;
   }
 
  private:
@@ -138,8 +404,18 @@ class Proxy {
 
 ////////////////////////////////////////////////////////////////////////
 
+// Writes to the stream a buffer at a time rather than rendering all of
+// the JSON into a string first.
 inline std::ostream& operator<<(std::ostream& stream, Proxy&& that) {
-  return stream << std::string(std::move(that));
+  internal::write(
+      that.write,
+      [&stream](std::string_view data) -> Try<Nothing> {
+        stream.write(data.data(), data.size());
+        return Nothing();
+      },
+      internal::FLUSH_SIZE);
+
+  return stream;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -190,7 +466,18 @@ class NumberWriter {
     switch (type_) {
       case INT: CHECK(writer_->Int64(int_)); break;
       case UINT: CHECK(writer_->Uint64(uint_)); break;
-      case DOUBLE: CHECK(writer_->Double(double_)); break;
+      case DOUBLE: {
+#ifdef __cpp_lib_to_chars
+        if (std::isfinite(double_)) {
+          char buffer[32];
+          const size_t length = internal::formatDouble(double_, buffer);
+          CHECK(writer_->RawValue(buffer, length, rapidjson::kNumberType));
+          break;
+        }
+#endif // __cpp_lib_to_chars
+        CHECK(writer_->Double(double_));
+        break;
+      }
     }
   }
 
@@ -337,7 +624,8 @@ class ArrayWriter {
 
   template <typename T>
   void element(const T& value) {
-    jsonify(value).write(writer_);
+    internal::render(writer_, value);
+    internal::flush(writer_);
   }
 
  private:
@@ -374,7 +662,20 @@ class ObjectWriter {
     // yet have the std::string overload for `Key`, avoid calling
     // `c_str()` and `size()` when we upgrade beyond 1.1.0.
     CHECK(writer_->Key(key.c_str(), key.size()));
-    jsonify(value).write(writer_);
+    internal::render(writer_, value);
+    internal::flush(writer_);
+  }
+
+  // Like `field` but for a key that is already quoted and escaped,
+  // e.g., "\"key\"", which is written as is (see `STOUT_JSON_FIELDS`
+  // in stout/jsonfields.h).
+  template <typename T>
+  void escapedField(std::string_view key, const T& value) {
+    // rapidjson writes a key like any other string value, so a raw
+    // string value in its place gets the same separators.
+    CHECK(writer_->RawValue(key.data(), key.size(), rapidjson::kStringType));
+    internal::render(writer_, value);
+    internal::flush(writer_);
   }
 
  private:
@@ -716,20 +1017,18 @@ namespace internal {
 
 ////////////////////////////////////////////////////////////////////////
 
-// NOTE: The following overloads of `internal::jsonify` return a
-// `std::function` rather than a `JSON::Proxy` since `JSON::Proxy`'s copy/move
-// constructors are declared `private`. We could also declare
-// `internal::jsonify` as friend of `JSON::Proxy` but chose to minimize
-// friendship and construct a `std::function` instead.
+// NOTE: The following overloads of `internal::render` are called
+// directly by the `ArrayWriter` and `ObjectWriter` for each element and
+// field (rather than through the type erased `JSON::Proxy::write`), so
+// that writing nested values doesn't need a `std::function` per value.
 
 // Given an `F` which is a "write" function, we simply use it directly.
 template <typename F, typename = typename result_of<F(WriterProxy)>::type>
-std::function<void(rapidjson::Writer<rapidjson::StringBuffer>*)> jsonify(
+void render(
+    rapidjson::Writer<rapidjson::StringBuffer>* writer,
     const F& write,
     Prefer) {
-  return [&write](rapidjson::Writer<rapidjson::StringBuffer>* writer) {
-    write(WriterProxy(writer));
-  };
+  write(WriterProxy(writer));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -740,12 +1039,20 @@ std::function<void(rapidjson::Writer<rapidjson::StringBuffer>*)> jsonify(
 // namespace as well, since `WriterProxy` is intentionally defined in the
 // `JSON` namespace.
 template <typename T>
-std::function<void(rapidjson::Writer<rapidjson::StringBuffer>*)> jsonify(
+void render(
+    rapidjson::Writer<rapidjson::StringBuffer>* writer,
     const T& value,
     LessPrefer) {
-  return [&value](rapidjson::Writer<rapidjson::StringBuffer>* writer) {
-    json(WriterProxy(writer), value);
-  };
+  json(WriterProxy(writer), value);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void render(
+    rapidjson::Writer<rapidjson::StringBuffer>* writer,
+    const T& value) {
+  internal::render(writer, value, Prefer());
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -760,7 +1067,47 @@ std::function<void(rapidjson::Writer<rapidjson::StringBuffer>*)> jsonify(
 
 template <typename T>
 JSON::Proxy jsonify(const T& t) {
-  return JSON::internal::jsonify(t, JSON::internal::Prefer());
+  return JSON::Proxy([&t](rapidjson::Writer<rapidjson::StringBuffer>* writer) {
+    JSON::internal::render(writer, t);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace JSON {
+
+////////////////////////////////////////////////////////////////////////
+
+// Writes `jsonify(value)` to `sink` through a buffer that is flushed to
+// the sink whenever it holds at least `size` bytes (checked after each
+// array element and object field), rather than rendering all of the
+// JSON into memory first. For example, to write a large response in
+// chunks with bounded memory:
+//
+//   Try<Nothing> write = JSON::write(
+//       [&](std::string_view data) -> Try<Nothing> {
+//         ...
+//       },
+//       response);
+//
+// If the sink returns an error it isn't called again and the error is
+// returned (after the rest of `value` has been visited). See
+// `stout/jsonsink.h` for writing to a file descriptor and compressing.
+template <typename T>
+Try<Nothing> write(
+    const Sink& sink,
+    const T& value,
+    size_t size = internal::FLUSH_SIZE) {
+  return internal::write(
+      [&value](rapidjson::Writer<rapidjson::StringBuffer>* writer) {
+        internal::render(writer, value);
+      },
+      sink,
+      size);
 }
 
 ////////////////////////////////////////////////////////////////////////
+
+} // namespace JSON
+
+////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,591 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cinttypes>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "stout/bits.h"
+#include "stout/error.h"
+#include "stout/nothing.h"
+#include "stout/try.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// The first stage of parsing JSON (the approach of simdjson, see
+// https://arxiv.org/abs/1902.08318): find the position of every
+// structural character ('{', '}', '[', ']', ':' and ','), of every
+// (unescaped) quote and of the start of every other token (numbers,
+// 'true', 'false' and 'null'), skipping whitespace and the contents
+// of strings. This is done 64 bytes at a time with bitmasks (computed
+// with SSE2 when available) rather than a byte at a time, so the
+// second stage only needs to look at the tokens.
+//
+// Also the parts of the second stage that don't depend on what is
+// being built: counting the elements of arrays and objects, parsing
+// numbers and unescaping strings.
+
+namespace JSON {
+namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+// Bitmasks of the characters of interest in a block of 64 bytes.
+struct Block {
+  uint64_t backslash = 0;
+  uint64_t quote = 0;
+  uint64_t structural = 0;
+  uint64_t whitespace = 0;
+  uint64_t control = 0;
+};
+
+
+#ifdef __SSE2__
+inline Block classify(const char* data) {
+  Block block;
+
+  for (int i = 0; i < 4; i++) {
+    const __m128i v =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i));
+
+    auto mask = [](__m128i matches) {
+      return uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(matches)));
+    };
+
+    auto equals = [&](char c) {
+      return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+    };
+
+    // '[' and '{' (and ']' and '}') differ only in 0x20.
+    const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+
+    const __m128i structural = _mm_or_si128(
+        _mm_or_si128(
+            _mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+            _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+        _mm_or_si128(equals(':'), equals(',')));
+
+    const __m128i whitespace = _mm_or_si128(
+        _mm_or_si128(equals(' '), equals('\t')),
+        _mm_or_si128(equals('\n'), equals('\r')));
+
+    // Bytes less than 0x20.
+    const __m128i control = _mm_cmpeq_epi8(
+        _mm_max_epu8(v, _mm_set1_epi8(0x1f)),
+        _mm_set1_epi8(0x1f));
+
+    block.backslash |= mask(equals('\\')) << (16 * i);
+    block.quote |= mask(equals('"')) << (16 * i);
+    block.structural |= mask(structural) << (16 * i);
+    block.whitespace |= mask(whitespace) << (16 * i);
+    block.control |= mask(control) << (16 * i);
+  }
+
+  return block;
+}
+#else
+inline Block classify(const char* data) {
+  Block block;
+
+  for (int i = 0; i < 64; i++) {
+    const uint64_t bit = uint64_t(1) << i;
+    switch (data[i]) {
+      case '\\':
+        block.backslash |= bit;
+        break;
+      case '"':
+        block.quote |= bit;
+        break;
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+        block.structural |= bit;
+        break;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        block.whitespace |= bit;
+        break;
+    }
+    if (static_cast<unsigned char>(data[i]) < 0x20) {
+      block.control |= bit;
+    }
+  }
+
+  return block;
+}
+#endif // __SSE2__
+
+
+// Returns a mask with each bit set to the XOR of all of the bits of
+// 'mask' up to and including it, i.e., given the positions of the
+// quotes, the positions that are within strings.
+inline uint64_t prefixXor(uint64_t mask) {
+  mask ^= mask << 1;
+  mask ^= mask << 2;
+  mask ^= mask << 4;
+  mask ^= mask << 8;
+  mask ^= mask << 16;
+  mask ^= mask << 32;
+  return mask;
+}
+
+
+// Returns a message in the same format as picojson for a syntax error
+// at 'position' in 'input'. 'added' is the number of newlines before
+// 'position' that weren't in the original input (strings unescaped in
+// place can contain newlines that were escaped).
+inline std::string syntaxError(
+    std::string_view input,
+    size_t position,
+    size_t added = 0) {
+  position = std::min(position, input.size());
+
+  const size_t line =
+    1 + std::count(input.begin(), input.begin() + position, '\n') - added;
+
+  std::string message =
+    "syntax error at line " + std::to_string(line) + " near: ";
+
+  for (size_t i = position; i < input.size() && input[i] != '\n'; i++) {
+    if (static_cast<unsigned char>(input[i]) >= ' ') {
+      message.push_back(input[i]);
+    }
+  }
+
+  return message;
+}
+
+
+// Fills in 'positions' with the positions of the structural
+// characters, quotes and starts of other tokens in 'input', in
+// increasing order. Returns an error if a string isn't terminated or
+// contains a control character, since these can't be parsed.
+inline Try<Nothing> index(
+    std::string_view input,
+    std::vector<uint32_t>* positions) {
+  if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+    return Error(
+        "JSON of " + std::to_string(input.size()) + " bytes is too big");
+  }
+
+  positions->clear();
+
+  size_t count = 0;
+
+  // State carried between blocks.
+  uint64_t escapedCarry = 0; // Whether the first byte is escaped.
+  uint64_t inStringCarry = 0; // All ones if in a string.
+  uint64_t otherCarry = 0; // Whether the last byte was part of a token.
+
+  for (size_t offset = 0; offset < input.size(); offset += 64) {
+    // Pad the last block with whitespace.
+    char padded[64];
+    const char* data = input.data() + offset;
+    if (input.size() - offset < 64) {
+      memset(padded, ' ', sizeof(padded));
+      memcpy(padded, data, input.size() - offset);
+      data = padded;
+    }
+
+    const Block block = classify(data);
+
+    // Find the escaped characters, i.e., those following an odd
+    // number of backslashes. Backslashes are rare (outside of
+    // strings with lots of quotes or non-ASCII) so we loop over them.
+    uint64_t escaped = escapedCarry;
+    escapedCarry = 0;
+    for (uint64_t backslash = block.backslash & ~escaped;
+         backslash != 0;
+         backslash &= backslash - 1) {
+      const uint64_t bit = backslash & (~backslash + 1);
+      if (escaped & bit) {
+        continue;
+      }
+      if (bit == uint64_t(1) << 63) {
+        escapedCarry = 1;
+      } else {
+        escaped |= bit << 1;
+      }
+    }
+
+    const uint64_t quote = block.quote & ~escaped;
+
+    // Includes the opening but not the closing quote of each string.
+    const uint64_t inString = prefixXor(quote) ^ inStringCarry;
+    inStringCarry = uint64_t(int64_t(inString) >> 63);
+
+    if (block.control & inString) {
+      return Error(syntaxError(
+          input,
+          offset + bits::countTrailingZeros(block.control & inString)));
+    }
+
+    const uint64_t structural = block.structural & ~inString;
+
+    const uint64_t other =
+      ~(block.structural | block.whitespace | quote | inString);
+
+    const uint64_t start = other & ~((other << 1) | otherCarry);
+    otherCarry = other >> 63;
+
+    uint64_t mask = structural | quote | start;
+
+    if (positions->size() < count + 64) {
+      positions->resize(std::max(2 * positions->size(), count + 64));
+    }
+
+    uint32_t* out = positions->data() + count;
+    while (mask != 0) {
+      *out++ = static_cast<uint32_t>(
+          offset + bits::countTrailingZeros(mask));
+      mask &= mask - 1;
+    }
+    count = out - positions->data();
+  }
+
+  positions->resize(count);
+
+  if (inStringCarry != 0) {
+    return Error(syntaxError(input, input.size()));
+  }
+
+  return Nothing();
+}
+
+
+// Fills in 'sizes' with the number of elements of each array and
+// members of each object in 'input' (given the 'positions' of its
+// tokens, see 'index'), in the order that they're opened, which is
+// the order that they're parsed in. This lets parsers allocate them
+// up front. Mismatched brackets are left for parsing to report.
+inline void count(
+    std::string_view input,
+    const std::vector<uint32_t>& positions,
+    std::vector<uint32_t>* sizes) {
+  sizes->clear();
+
+  std::vector<size_t> stack; // Indexes into 'sizes'.
+  for (size_t i = 0; i < positions.size(); i++) {
+    switch (input[positions[i]]) {
+      case '[':
+      case '{':
+        stack.push_back(sizes->size());
+        sizes->push_back(
+            i + 1 < positions.size() &&
+            input[positions[i + 1]] != ']' &&
+            input[positions[i + 1]] != '}');
+        break;
+      case ']':
+      case '}':
+        if (!stack.empty()) {
+          stack.pop_back();
+        }
+        break;
+      case ',':
+        if (!stack.empty()) {
+          (*sizes)[stack.back()]++;
+        }
+        break;
+    }
+  }
+}
+
+
+// Returns true if a token (a number or 'true', 'false' or 'null')
+// that stops at 'end' isn't followed by more characters of a token.
+inline bool ends(std::string_view input, size_t end) {
+  if (end == input.size()) {
+    return true;
+  }
+
+  switch (input[end]) {
+    case ' ': case '\t': case '\n': case '\r':
+    case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+// A number parsed by 'parseNumber'.
+struct ParsedNumber {
+  enum Type {
+    INVALID,
+    OUT_OF_RANGE,
+    INTEGER,
+    UNSIGNED_INTEGER,
+    FLOATING,
+  } type = INVALID;
+
+  int64_t integer = 0;
+  uint64_t unsigned_integer = 0;
+  double floating = 0;
+
+  // The position after the number.
+  size_t end = 0;
+};
+
+
+// Parses the number starting at 'begin'. Like picojson, a number is
+// any sequence of digits, '+', '-', '.', 'e' and 'E' that 'strtoimax'
+// (as an integer) or 'strtod' accept, except that integers greater
+// than INT64_MAX that fit in 64 bits are kept exactly as unsigned
+// integers rather than rounded to doubles. Plain integers are parsed
+// directly, and doubles with 'std::from_chars' where available (which
+// is exact and much faster than 'strtod', and doesn't need a copy of
+// the number to null terminate it).
+inline ParsedNumber parseNumber(std::string_view input, size_t begin) {
+  ParsedNumber number;
+
+  size_t end = begin;
+  bool integer = true;
+  while (end < input.size()) {
+    const char c = input[end];
+    if (c == '.' || c == 'e' || c == 'E') {
+      integer = false;
+    } else if (!(('0' <= c && c <= '9') || c == '+' || c == '-')) {
+      break;
+    }
+    end++;
+  }
+
+  number.end = end;
+
+  if (end == begin || !ends(input, end)) {
+    return number;
+  }
+
+  if (integer) {
+    const bool negative = input[begin] == '-';
+
+    uint64_t result = 0;
+    bool overflow = false;
+    size_t i = begin + negative;
+    for (; i < end && '0' <= input[i] && input[i] <= '9'; i++) {
+      const unsigned digit = input[i] - '0';
+      if (result > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        overflow = true;
+      }
+      result = result * 10 + digit;
+    }
+
+    constexpr uint64_t INT64_LIMIT = std::numeric_limits<int64_t>::max();
+
+    if (i == end && i > begin + negative) {
+      if (overflow) {
+        // Parsed as a double below.
+      } else if (!negative && result <= INT64_LIMIT) {
+        number.type = ParsedNumber::INTEGER;
+        number.integer = static_cast<int64_t>(result);
+        return number;
+      } else if (!negative) {
+        number.type = ParsedNumber::UNSIGNED_INTEGER;
+        number.unsigned_integer = result;
+        return number;
+      } else if (result <= INT64_LIMIT + 1) {
+        number.type = ParsedNumber::INTEGER;
+        number.integer = -static_cast<int64_t>(result - 1) - 1;
+        return number;
+      }
+    } else {
+      // Not just digits (e.g., "+1" or "1-2"), which 'strtoimax' may
+      // still accept.
+      const std::string copy(input.substr(begin, end - begin));
+      char* parsed;
+
+      errno = 0;
+      const intmax_t result = strtoimax(copy.c_str(), &parsed, 10);
+      if (errno == 0 && parsed == copy.c_str() + copy.size()) {
+        number.type = ParsedNumber::INTEGER;
+        number.integer = static_cast<int64_t>(result);
+        return number;
+      }
+    }
+  }
+
+#ifdef __cpp_lib_to_chars
+  // NOTE: Unlike 'strtod', 'std::from_chars' doesn't accept a leading
+  // '+' and doesn't return a value when it's out of range, so those
+  // fall back to 'strtod' below for the same result as picojson.
+  const char* last = input.data() + end;
+  const std::from_chars_result converted =
+    std::from_chars(input.data() + begin, last, number.floating);
+  if (converted.ec == std::errc() && converted.ptr == last) {
+    number.type = ParsedNumber::FLOATING;
+    return number;
+  }
+#endif // __cpp_lib_to_chars
+
+  // Copy the number so that it's null terminated.
+  const std::string copy(input.substr(begin, end - begin));
+  char* parsed;
+
+  const double result = strtod(copy.c_str(), &parsed);
+  if (parsed != copy.c_str() + copy.size()) {
+    return number;
+  }
+
+  if (std::isnan(result) || std::isinf(result)) {
+    number.type = ParsedNumber::OUT_OF_RANGE;
+    return number;
+  }
+
+  number.type = ParsedNumber::FLOATING;
+  number.floating = result;
+  return number;
+}
+
+
+// Returns the value of the 4 hex digits at 'data', or -1.
+inline int parseQuadhex(const char* data, const char* end) {
+  if (end - data < 4) {
+    return -1;
+  }
+
+  int result = 0;
+  for (int i = 0; i < 4; i++) {
+    const char c = data[i];
+    int digit;
+    if ('0' <= c && c <= '9') {
+      digit = c - '0';
+    } else if ('a' <= c && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if ('A' <= c && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return -1;
+    }
+    result = result * 16 + digit;
+  }
+
+  return result;
+}
+
+
+// Writes the unescaped contents of a string (without its quotes) from
+// 'begin' to 'end' to 'out', which may be 'begin' since the result is
+// never longer, and returns the end of what was written. Returns
+// nullptr and sets 'failed' to the position of an invalid escape.
+inline char* unescape(
+    const char* begin,
+    const char* end,
+    char* out,
+    const char** failed) {
+  const char* i = begin;
+  while (i < end) {
+    const char* escape =
+      static_cast<const char*>(memchr(i, '\\', end - i));
+    if (escape == nullptr) {
+      escape = end;
+    }
+
+    memmove(out, i, escape - i);
+    out += escape - i;
+    i = escape;
+
+    if (i == end) {
+      break;
+    }
+
+    // The first stage guarantees that a backslash is followed by
+    // another character within the string.
+    i += 2;
+
+    switch (i[-1]) {
+      case '"': *out++ = '"'; break;
+      case '\\': *out++ = '\\'; break;
+      case '/': *out++ = '/'; break;
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case 'u': {
+        int codepoint = parseQuadhex(i, end);
+        if (codepoint == -1) {
+          *failed = i;
+          return nullptr;
+        }
+        i += 4;
+
+        // A surrogate pair.
+        if (0xd800 <= codepoint && codepoint <= 0xdfff) {
+          if (0xdc00 <= codepoint ||
+              end - i < 2 || i[0] != '\\' || i[1] != 'u') {
+            *failed = i;
+            return nullptr;
+          }
+          const int second = parseQuadhex(i + 2, end);
+          if (!(0xdc00 <= second && second <= 0xdfff)) {
+            *failed = i;
+            return nullptr;
+          }
+          i += 6;
+          codepoint =
+            0x10000 + (((codepoint - 0xd800) << 10) | (second - 0xdc00));
+        }
+
+        if (codepoint < 0x80) {
+          *out++ = static_cast<char>(codepoint);
+        } else if (codepoint < 0x800) {
+          *out++ = static_cast<char>(0xc0 | (codepoint >> 6));
+          *out++ = static_cast<char>(0x80 | (codepoint & 0x3f));
+        } else if (codepoint < 0x10000) {
+          *out++ = static_cast<char>(0xe0 | (codepoint >> 12));
+          *out++ = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+          *out++ = static_cast<char>(0x80 | (codepoint & 0x3f));
+        } else {
+          *out++ = static_cast<char>(0xf0 | (codepoint >> 18));
+          *out++ = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f));
+          *out++ = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+          *out++ = static_cast<char>(0x80 | (codepoint & 0x3f));
+        }
+        break;
+      }
+      default:
+        *failed = i - 1;
+        return nullptr;
+    }
+  }
+
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace internal {
+} // namespace JSON {
+
+////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,606 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stout/error.h"
+#include "stout/json.h"
+#include "stout/jsonindex.h"
+#include "stout/none.h"
+#include "stout/nothing.h"
+#include "stout/result.h"
+#include "stout/strings.h"
+#include "stout/try.h"
+#include "stout/unreachable.h"
+
+namespace JSON {
+
+class LazyDocument;
+
+////////////////////////////////////////////////////////////////////////
+
+// A value in a 'LazyDocument' that is only decoded when asked for:
+//
+//   Result<int64_t> mem = document["resources"]["mem"].get<int64_t>();
+//
+// Looking up a key or an index returns another 'LazyValue' which, like
+// 'Object::find', is 'None' if there is no such key or index (or the
+// value is null) and an error if the value isn't an object or an
+// array, so lookups can be chained and checked once at the end with
+// 'get'. Looking up skips over the values before the one looked for
+// without looking at their contents. The document must outlive its
+// values.
+class LazyValue {
+ public:
+  // Returns the member of an object with 'key' (the last one if the
+  // key is duplicated, like 'parse').
+  LazyValue operator[](std::string_view key) const;
+
+  // Returns the element of an array at 'index'.
+  LazyValue operator[](size_t index) const;
+
+  // Returns the value at 'path', with the same results as
+  // 'Object::find'.
+  LazyValue operator[](const Path& path) const;
+
+  // Returns the elements of an array (or the values of an object).
+  Result<std::vector<LazyValue>> values() const;
+
+  // Decodes the value as a 'T': 'Null', 'Boolean' or 'bool', 'Number'
+  // or an arithmetic type, 'String' or 'std::string', or 'Object',
+  // 'Array' or 'Value' (which parse the value and all it contains).
+  // Returns 'None' if the value isn't found or is null (unless 'T' is
+  // 'Null' or 'Value'), and an error if it's of the wrong type or
+  // can't be decoded.
+  template <typename T>
+  Result<T> get() const;
+
+ private:
+  friend class LazyDocument;
+
+  struct State;
+
+  LazyValue(const State* _state, Result<uint32_t> _index)
+    : state(_state), index(std::move(_index)) {}
+
+  // Returns the position of the first token after the value at 'i'.
+  uint32_t skip(uint32_t i) const;
+
+  // Returns the unescaped string at 'i'.
+  Try<std::string> decode(uint32_t i) const;
+
+  char at(uint32_t i) const;
+
+  const State* state;
+
+  // The index of the first token of the value in the positions of the
+  // tokens, see 'JSON::internal::index'.
+  Result<uint32_t> index;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+struct LazyValue::State {
+  std::string json;
+
+  // The positions of the tokens, see 'JSON::internal::index'.
+  std::vector<uint32_t> positions;
+
+  // For the token that starts each array or object, the index of the
+  // token that ends it.
+  std::vector<uint32_t> ends;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// JSON that is parsed on demand (like simdjson's "On-Demand" API):
+// parsing only finds the tokens (see stout/jsonindex.h) and checks the
+// structure, i.e., that brackets match and are separated by commas
+// and colons, remembering where each array and object ends. Values
+// are then only decoded when they are looked up, which is much faster
+// than 'JSON::parse' when only a few values of a large document are
+// needed.
+//
+// NOTE: Because strings and numbers aren't decoded until they are
+// needed, an invalid escape or number is only reported by 'get'.
+class LazyDocument {
+ public:
+  static Try<LazyDocument> parse(std::string json);
+
+  LazyValue root() const {
+    return LazyValue(state.get(), 0u);
+  }
+
+  LazyValue operator[](std::string_view key) const {
+    return root()[key];
+  }
+
+  LazyValue operator[](size_t index) const {
+    return root()[index];
+  }
+
+  LazyValue operator[](const Path& path) const {
+    return root()[path];
+  }
+
+ private:
+  LazyDocument() : state(new LazyValue::State()) {}
+
+  // Checks the structure of the document and fills in 'ends'.
+  Try<Nothing> validate();
+
+  // Separate so that the values refer to the same state when the
+  // document is moved.
+  std::unique_ptr<LazyValue::State> state;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+inline Try<LazyDocument> LazyDocument::parse(std::string json) {
+  LazyDocument document;
+  document.state->json = std::move(json);
+
+  Try<Nothing> indexed =
+    internal::index(document.state->json, &document.state->positions);
+  if (indexed.isError()) {
+    return Error(indexed.error());
+  }
+
+  Try<Nothing> validated = document.validate();
+  if (validated.isError()) {
+    return Error(validated.error());
+  }
+
+  return std::move(document);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline Try<Nothing> LazyDocument::validate() {
+  const std::string_view input = state->json;
+  const std::vector<uint32_t>& positions = state->positions;
+
+  state->ends.assign(positions.size(), 0);
+
+  enum {
+    VALUE,
+    FIRST_ELEMENT,
+    FIRST_KEY,
+    KEY,
+    COLON,
+    NEXT,
+    END,
+  } expect = VALUE;
+
+  std::vector<uint32_t> stack;
+
+  for (uint32_t i = 0; i < positions.size(); i++) {
+    const size_t position = positions[i];
+    const char c = input[position];
+
+    if (expect == END) {
+      const size_t end = input.find_last_not_of(strings::WHITESPACE) + 1;
+      return Error(
+          "Parsed JSON included non-whitespace trailing characters: "
+          + std::string(input.substr(position, end - position)));
+    }
+
+    bool completed = false;
+
+    switch (expect) {
+      case VALUE:
+      case FIRST_ELEMENT:
+        if (c == ']' && expect == FIRST_ELEMENT) {
+          state->ends[stack.back()] = i;
+          stack.pop_back();
+          completed = true;
+          break;
+        }
+
+        switch (c) {
+          case '{':
+          case '[':
+            if (stack.size() == internal::STOUT_JSON_MAX_DEPTH) {
+              return Error(internal::syntaxError(input, position));
+            }
+            stack.push_back(i);
+            expect = c == '{' ? FIRST_KEY : FIRST_ELEMENT;
+            break;
+          case '"':
+            i++; // The closing quote.
+            completed = true;
+            break;
+          case 't':
+          case 'f':
+          case 'n': {
+            const std::string_view literal =
+              c == 't' ? "true" : c == 'f' ? "false" : "null";
+            if (input.substr(position, literal.size()) != literal ||
+                !internal::ends(input, position + literal.size())) {
+              return Error(internal::syntaxError(input, position));
+            }
+            completed = true;
+            break;
+          }
+          case '-':
+          case '0': case '1': case '2': case '3': case '4':
+          case '5': case '6': case '7': case '8': case '9': {
+            // Only the characters of numbers are checked here, they
+            // are parsed by 'get'.
+            size_t end = position;
+            while (end < input.size() &&
+                   (('0' <= input[end] && input[end] <= '9') ||
+                    input[end] == '-' || input[end] == '+' ||
+                    input[end] == '.' || input[end] == 'e' ||
+                    input[end] == 'E')) {
+              end++;
+            }
+            if (!internal::ends(input, end)) {
+              return Error(internal::syntaxError(input, end));
+            }
+            completed = true;
+            break;
+          }
+          default:
+            return Error(internal::syntaxError(input, position));
+        }
+        break;
+      case FIRST_KEY:
+      case KEY:
+        if (c == '}' && expect == FIRST_KEY) {
+          state->ends[stack.back()] = i;
+          stack.pop_back();
+          completed = true;
+        } else if (c == '"') {
+          i++; // The closing quote.
+          expect = COLON;
+        } else {
+          return Error(internal::syntaxError(input, position));
+        }
+        break;
+      case COLON:
+        if (c != ':') {
+          return Error(internal::syntaxError(input, position));
+        }
+        expect = VALUE;
+        break;
+      case NEXT: {
+        const char open = input[positions[stack.back()]];
+        if (c == ',') {
+          expect = open == '{' ? KEY : VALUE;
+        } else if ((c == '}' && open == '{') || (c == ']' && open == '[')) {
+          state->ends[stack.back()] = i;
+          stack.pop_back();
+          completed = true;
+        } else {
+          return Error(internal::syntaxError(input, position));
+        }
+        break;
+      }
+      case END:
+        break;
+    }
+
+    if (completed) {
+      expect = stack.empty() ? END : NEXT;
+    }
+  }
+
+  if (expect != END) {
+    return Error(internal::syntaxError(input, input.size()));
+  }
+
+  return Nothing();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline char LazyValue::at(uint32_t i) const {
+  return state->json[state->positions[i]];
+}
+
+
+inline uint32_t LazyValue::skip(uint32_t i) const {
+  switch (at(i)) {
+    case '{':
+    case '[':
+      return state->ends[i] + 1;
+    case '"':
+      return i + 2;
+    default:
+      return i + 1;
+  }
+}
+
+
+inline Try<std::string> LazyValue::decode(uint32_t i) const {
+  const char* begin = state->json.data() + state->positions[i] + 1;
+  const char* end = state->json.data() + state->positions[i + 1];
+
+  if (memchr(begin, '\\', end - begin) == nullptr) {
+    return std::string(begin, end);
+  }
+
+  std::string result(begin, end);
+  const char* invalid = nullptr;
+  const char* last =
+    internal::unescape(begin, end, &result[0], &invalid);
+
+  if (last == nullptr) {
+    return Error(internal::syntaxError(
+        state->json,
+        invalid - state->json.data()));
+  }
+
+  result.resize(last - result.data());
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline LazyValue LazyValue::operator[](std::string_view key) const {
+  if (!index.isSome()) {
+    return *this;
+  }
+
+  uint32_t i = index.get();
+  if (at(i) == 'n') {
+    return LazyValue(state, None());
+  } else if (at(i) != '{') {
+    return LazyValue(state, Error("Intermediate JSON value not an object"));
+  }
+
+  Result<uint32_t> found = None();
+
+  i++;
+  while (at(i) != '}') {
+    const std::string_view raw(
+        state->json.data() + state->positions[i] + 1,
+        state->positions[i + 1] - state->positions[i] - 1);
+
+    // Only keys with escapes need to be decoded to be compared, and
+    // those must only be compared decoded, e.g., the raw key 'a\n' is
+    // an 'a' and a newline rather than a backslash and an 'n'.
+    bool matches;
+    if (raw.find('\\') == std::string_view::npos) {
+      matches = raw == key;
+    } else {
+      Try<std::string> decoded = decode(i);
+      if (decoded.isError()) {
+        return LazyValue(state, Error(decoded.error()));
+      }
+      matches = decoded.get() == key;
+    }
+
+    // Skip the key, the colon and the value.
+    const uint32_t value = i + 3;
+    if (matches) {
+      found = value;
+    }
+
+    i = skip(value);
+    if (at(i) == ',') {
+      i++;
+    }
+  }
+
+  return LazyValue(state, found);
+}
+
+
+inline LazyValue LazyValue::operator[](size_t n) const {
+  if (!index.isSome()) {
+    return *this;
+  }
+
+  uint32_t i = index.get();
+  if (at(i) == 'n') {
+    return LazyValue(state, None());
+  } else if (at(i) != '[') {
+    return LazyValue(state, Error("Intermediate JSON value not an array"));
+  }
+
+  i++;
+  for (size_t element = 0; at(i) != ']'; element++) {
+    if (element == n) {
+      return LazyValue(state, i);
+    }
+
+    i = skip(i);
+    if (at(i) == ',') {
+      i++;
+    }
+  }
+
+  return LazyValue(state, None());
+}
+
+
+inline LazyValue LazyValue::operator[](const Path& path) const {
+  LazyValue value = *this;
+
+  for (size_t i = 0; i < path.steps.size(); i++) {
+    const Path::Step& step = path.steps[i];
+
+    // Like 'Object::find', the last value is found even if it isn't an
+    // object (or an array).
+    if (i > 0 && value.index.isSome() && at(value.index.get()) != '{') {
+      return LazyValue(state, Error("Intermediate JSON value not an object"));
+    }
+
+    value = value[step.name];
+
+    if (step.subscript.isSome() && value.index.isSome()) {
+      value = value[step.subscript.get()];
+    }
+  }
+
+  return value;
+}
+
+
+inline Result<std::vector<LazyValue>> LazyValue::values() const {
+  if (index.isError()) {
+    return Error(index.error());
+  } else if (index.isNone()) {
+    return None();
+  }
+
+  uint32_t i = index.get();
+  const char open = at(i);
+  if (open == 'n') {
+    return None();
+  } else if (open != '[' && open != '{') {
+    return Error("Found JSON value of wrong type");
+  }
+
+  const char close = open == '[' ? ']' : '}';
+
+  std::vector<LazyValue> values;
+
+  i++;
+  while (at(i) != close) {
+    if (open == '{') {
+      i += 3; // The key and the colon.
+    }
+
+    values.push_back(LazyValue(state, i));
+
+    i = skip(i);
+    if (at(i) == ',') {
+      i++;
+    }
+  }
+
+  return values;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+Result<T> LazyValue::get() const {
+  if (index.isError()) {
+    return Error(index.error());
+  } else if (index.isNone()) {
+    return None();
+  }
+
+  const uint32_t i = index.get();
+  const size_t position = state->positions[i];
+  const char c = at(i);
+
+  if constexpr (std::is_same<T, Value>::value) {
+    // Handled below.
+  } else if (c == 'n') {
+    if constexpr (std::is_same<T, Null>::value) {
+      return Null();
+    } else {
+      return None();
+    }
+  }
+
+  if constexpr (
+      std::is_same<T, Value>::value ||
+      std::is_same<T, Object>::value ||
+      std::is_same<T, Array>::value) {
+    // Parse the text of the value, see 'skip'.
+    const uint32_t next = skip(i);
+    const size_t end = next < state->positions.size()
+      ? state->positions[next]
+      : state->json.size();
+
+    Try<Value> value = JSON::parse(
+        state->json.substr(position, end - position));
+
+    if (value.isError()) {
+      return Error(value.error());
+    } else if (!value->is<T>()) {
+      return Error("Found JSON value of wrong type");
+    }
+
+    return std::move(value->as<T>());
+  } else if constexpr (
+      std::is_same<T, Boolean>::value ||
+      std::is_same<T, bool>::value) {
+    if (c != 't' && c != 'f') {
+      return Error("Found JSON value of wrong type");
+    }
+    return T(c == 't');
+  } else if constexpr (
+      std::is_same<T, String>::value ||
+      std::is_same<T, std::string>::value) {
+    if (c != '"') {
+      return Error("Found JSON value of wrong type");
+    }
+
+    Try<std::string> s = decode(i);
+    if (s.isError()) {
+      return Error(s.error());
+    }
+    return T(std::move(s.get()));
+  } else if constexpr (
+      std::is_same<T, Number>::value ||
+      std::is_arithmetic<T>::value) {
+    if (c != '-' && (c < '0' || c > '9')) {
+      return Error("Found JSON value of wrong type");
+    }
+
+    const internal::ParsedNumber number =
+      internal::parseNumber(state->json, position);
+
+    switch (number.type) {
+      case internal::ParsedNumber::INVALID:
+        return Error(internal::syntaxError(state->json, position));
+      case internal::ParsedNumber::OUT_OF_RANGE:
+        return Error("Value out of range");
+      case internal::ParsedNumber::INTEGER:
+        if constexpr (std::is_same<T, Number>::value) {
+          return Number(number.integer);
+        } else {
+          return Number(number.integer).as<T>();
+        }
+      case internal::ParsedNumber::UNSIGNED_INTEGER:
+        if constexpr (std::is_same<T, Number>::value) {
+          return Number(number.unsigned_integer);
+        } else {
+          return Number(number.unsigned_integer).as<T>();
+        }
+      case internal::ParsedNumber::FLOATING:
+        if constexpr (std::is_same<T, Number>::value) {
+          return Number(number.floating);
+        } else {
+          return Number(number.floating).as<T>();
+        }
+    }
+
+    UNREACHABLE();
+  } else {
+    static_assert(
+        std::is_same<T, Null>::value,
+        "Expecting a JSON type, an arithmetic type or std::string");
+    return Error("Found JSON value of wrong type");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace JSON
@@ -0,0 +1,275 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stout/error.h"
+#include "stout/footprint.h"
+#include "stout/hash.h"
+#include "stout/json.h"
+#include "stout/jsonify.h"
+#include "stout/none.h"
+#include "stout/result.h"
+
+namespace JSON {
+
+////////////////////////////////////////////////////////////////////////
+
+// A JSON object that keeps its members in the order they were first
+// inserted (so it's written in that order too, rather than sorted like
+// an 'Object') in a single vector, rather than a tree node per member.
+// Members of small objects are found by comparing each key, and of
+// larger objects with an open addressed hash index, in constant time
+// either way rather than the O(log n) string comparisons of 'Object'.
+// Erasing a member is linear in the size of the object though.
+//
+//   JSON::OrderedObject object;
+//   object["name"] = "stout";
+//   object["version"] = 1;
+//
+//   for (const auto& [key, value] : object.values()) { ... }
+//
+// Use 'toObject()' to store one in a 'Value'.
+class OrderedObject {
+ public:
+  typedef std::pair<std::string, Value> Member;
+
+  OrderedObject() = default;
+
+  OrderedObject(std::initializer_list<Member> members) {
+    reserve(members.size());
+    for (const Member& member : members) {
+      (*this)[member.first] = member.second;
+    }
+  }
+
+  // Keeps the (sorted) order of 'object'.
+  explicit OrderedObject(const Object& object) {
+    reserve(object.values.size());
+    for (const auto& [key, value] : object.values) {
+      members.emplace_back(key, value);
+    }
+    rebuild();
+  }
+
+  // Returns the value of 'key', inserting a null value at the end if
+  // there isn't one.
+  Value& operator[](std::string_view key) {
+    const size_t i = find(key);
+    if (i != NOT_FOUND) {
+      return members[i].second;
+    }
+
+    members.emplace_back(std::string(key), Value());
+    if (index.empty()) {
+      if (members.size() > SMALL) {
+        rebuild();
+      }
+    } else {
+      if (members.size() * 2 > index.size()) {
+        rebuild();
+      } else {
+        insert(members.size() - 1);
+      }
+    }
+
+    return members.back().second;
+  }
+
+  // Returns the value of 'key' or nullptr.
+  const Value* get(std::string_view key) const {
+    const size_t i = find(key);
+    return i == NOT_FOUND ? nullptr : &members[i].second;
+  }
+
+  Value* get(std::string_view key) {
+    const size_t i = find(key);
+    return i == NOT_FOUND ? nullptr : &members[i].second;
+  }
+
+  bool contains(std::string_view key) const {
+    return find(key) != NOT_FOUND;
+  }
+
+  // Like 'Object::at'.
+  template <typename T>
+  Result<T> at(std::string_view key) const {
+    const Value* value = get(key);
+    if (value == nullptr) {
+      return None();
+    } else if (!value->is<T>()) {
+      return Error("Found JSON value of wrong type");
+    }
+    return value->as<T>();
+  }
+
+  // Returns the number of members erased (0 or 1).
+  size_t erase(std::string_view key) {
+    const size_t i = find(key);
+    if (i == NOT_FOUND) {
+      return 0;
+    }
+
+    members.erase(members.begin() + i);
+    rebuild();
+    return 1;
+  }
+
+  // Returns the members in the order they were inserted.
+  const std::vector<Member>& values() const {
+    return members;
+  }
+
+  size_t size() const {
+    return members.size();
+  }
+
+  bool empty() const {
+    return members.empty();
+  }
+
+  void clear() {
+    members.clear();
+    index.clear();
+  }
+
+  void reserve(size_t size) {
+    members.reserve(size);
+  }
+
+  // Returns an 'Object' with the same members (in sorted order).
+  Object toObject() const {
+    Object object;
+    for (const Member& member : members) {
+      object.values.emplace(member.first, member.second);
+    }
+    return object;
+  }
+
+  // Objects are equal if they have the same members, in any order.
+  bool operator==(const OrderedObject& that) const {
+    if (size() != that.size()) {
+      return false;
+    }
+
+    for (const Member& member : members) {
+      const Value* value = that.get(member.first);
+      if (value == nullptr || !(*value == member.second)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool operator!=(const OrderedObject& that) const {
+    return !(*this == that);
+  }
+
+ private:
+  friend size_t heapFootprint(const OrderedObject& object) {
+    return stout::heapFootprint(object.members) +
+      stout::heapFootprint(object.index);
+  }
+
+  // Objects of up to this many members don't have an index.
+  static constexpr size_t SMALL = 8;
+
+  static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+  static size_t hash(std::string_view key) {
+    return stout::Hash<std::string_view>()(key);
+  }
+
+  size_t find(std::string_view key) const {
+    if (index.empty()) {
+      for (size_t i = 0; i < members.size(); i++) {
+        if (members[i].first == key) {
+          return i;
+        }
+      }
+      return NOT_FOUND;
+    }
+
+    const size_t mask = index.size() - 1;
+    for (size_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+      const uint32_t i = index[slot];
+      if (i == 0) {
+        return NOT_FOUND;
+      } else if (members[i - 1].first == key) {
+        return i - 1;
+      }
+    }
+  }
+
+  // Adds the member at 'i' to the index, which has space for it.
+  void insert(size_t i) {
+    const size_t mask = index.size() - 1;
+    size_t slot = hash(members[i].first) & mask;
+    while (index[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    index[slot] = static_cast<uint32_t>(i + 1);
+  }
+
+  // Rebuilds the index (if the object is big enough to need one) with
+  // a load factor of at most 1/2. Slots hold the index of a member
+  // plus one, or 0 if they're empty.
+  void rebuild() {
+    index.clear();
+    if (members.size() <= SMALL) {
+      return;
+    }
+
+    size_t capacity = 16;
+    while (capacity < members.size() * 4) {
+      capacity *= 2;
+    }
+
+    index.resize(capacity, 0);
+    for (size_t i = 0; i < members.size(); i++) {
+      insert(i);
+    }
+  }
+
+  std::vector<Member> members;
+  std::vector<uint32_t> index;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+inline void json(ObjectWriter* writer, const OrderedObject& object) {
+  for (const OrderedObject::Member& member : object.values()) {
+    writer->field(member.first, member.second);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline std::ostream& operator<<(
+    std::ostream& stream,
+    const OrderedObject& object) {
+  return stream << jsonify(object);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace JSON
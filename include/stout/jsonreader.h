@@ -0,0 +1,553 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stout/error.h"
+#include "stout/json.h"
+#include "stout/jsonindex.h"
+#include "stout/nothing.h"
+#include "stout/option.h"
+#include "stout/result.h"
+#include "stout/try.h"
+
+#include "stout/os/int_fd.h"
+#include "stout/os/read.h"
+
+namespace JSON {
+
+////////////////////////////////////////////////////////////////////////
+
+// What a handler wants a 'Reader' to do after an event.
+enum class Action {
+  CONTINUE,
+
+  // Skip the object or array that was just started (there is no event
+  // for its end), or the value of the key that was just read. Skipped
+  // values are still checked to be well formed but their strings and
+  // numbers aren't kept. The same as 'CONTINUE' for other events.
+  SKIP,
+
+  // Stop reading: the rest of the input is ignored.
+  STOP,
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// A handler of the events of a 'Reader' that ignores all of them, to
+// inherit from and hide only the events of interest. The strings
+// passed to the handler are only valid until the event returns.
+struct Handler {
+  Action startObject() { return Action::CONTINUE; }
+  Action endObject() { return Action::CONTINUE; }
+  Action startArray() { return Action::CONTINUE; }
+  Action endArray() { return Action::CONTINUE; }
+  Action key(std::string_view) { return Action::CONTINUE; }
+  Action string(std::string_view) { return Action::CONTINUE; }
+  Action number(const Number&) { return Action::CONTINUE; }
+  Action boolean(bool) { return Action::CONTINUE; }
+  Action null() { return Action::CONTINUE; }
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// An event driven ("SAX") JSON reader that is given its input a chunk
+// at a time and calls a 'Handler' for each value it reads rather than
+// building them, so it can read documents that don't fit in memory
+// (e.g., large dumps) using memory proportional only to the nesting
+// depth and the longest string or number. For example, to count the
+// tasks in a compressed dump:
+//
+//   struct Tasks : JSON::Handler {
+//     JSON::Action key(std::string_view key) {
+//       if (key == "tasks") ...
+//     }
+//   } tasks;
+//
+//   JSON::Reader<Tasks> reader(&tasks);
+//   gzip::Decompressor decompressor;
+//   while (...) {
+//     Try<std::string> data = decompressor.decompress(compressed);
+//     ...
+//     Try<Nothing> read = reader.feed(data.get());
+//     ...
+//   }
+//   Try<Nothing> read = reader.finish();
+//
+// See also 'JSON::read' below for reading a file descriptor. Accepts
+// the same JSON as 'JSON::parse', with the same nesting limit.
+template <typename H>
+class Reader {
+ public:
+  explicit Reader(H* _handler) : handler(_handler) {}
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // Reads another chunk of the input, calling the handler for each
+  // event. Returns an error if the input isn't valid JSON, after which
+  // the reader returns the same error for all subsequent calls.
+  Try<Nothing> feed(std::string_view data) {
+    size_t i = 0;
+    while (i < data.size() && state != FAILED && state != STOPPED) {
+      const char c = data[i];
+
+      switch (state) {
+        case STRING:
+          i = readString(data, i);
+          continue;
+        case NUMBER:
+        case LITERAL:
+          if (state == NUMBER ? isNumber(c) : ('a' <= c && c <= 'z')) {
+            token.push_back(c);
+            i++;
+          } else {
+            endToken(data, i);
+          }
+          continue;
+        default:
+          break;
+      }
+
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        line += c == '\n';
+        i++;
+        continue;
+      }
+
+      switch (state) {
+        case VALUE:
+        case FIRST_ELEMENT:
+          if (c == ']' && state == FIRST_ELEMENT) {
+            end(c);
+          } else {
+            startValue(data, i);
+          }
+          break;
+        case FIRST_KEY:
+        case KEY:
+          if (c == '}' && state == FIRST_KEY) {
+            end(c);
+          } else if (c == '"') {
+            startString(true, skipping > 0);
+          } else {
+            fail(data, i);
+          }
+          break;
+        case COLON:
+          if (c == ':') {
+            state = VALUE;
+          } else {
+            fail(data, i);
+          }
+          break;
+        case NEXT:
+          if (c == ',') {
+            state = stack.back() == '{' ? KEY : VALUE;
+          } else if ((c == '}' && stack.back() == '{') ||
+                     (c == ']' && stack.back() == '[')) {
+            end(c);
+          } else {
+            fail(data, i);
+          }
+          break;
+        default:
+          fail(data, i);
+          break;
+      }
+
+      i++;
+    }
+
+    if (state == FAILED) {
+      return failure.get();
+    }
+
+    return Nothing();
+  }
+
+  // Signals the end of the input. Returns an error if the input didn't
+  // contain a complete value (unless the handler stopped reading).
+  Try<Nothing> finish() {
+    if (state == NUMBER || state == LITERAL) {
+      endToken(std::string_view(), 0);
+    }
+
+    if (state == FAILED) {
+      return failure.get();
+    } else if (state != END && state != STOPPED) {
+      fail(std::string_view(), 0);
+      return failure.get();
+    }
+
+    return Nothing();
+  }
+
+  // Returns true if the handler stopped reading.
+  bool stopped() const {
+    return state == STOPPED;
+  }
+
+ private:
+  static bool isNumber(char c) {
+    return ('0' <= c && c <= '9') ||
+      c == '+' || c == '-' || c == '.' || c == 'e' || c == 'E';
+  }
+
+  // Records an error in the same format as 'JSON::parse' at position
+  // 'i' of the chunk 'data'.
+  void fail(std::string_view data, size_t i) {
+    std::string message =
+      "syntax error at line " + std::to_string(line) + " near: ";
+
+    for (; i < data.size() && data[i] != '\n'; i++) {
+      if (static_cast<unsigned char>(data[i]) >= ' ') {
+        message.push_back(data[i]);
+      }
+    }
+
+    failure = Error(message);
+    state = FAILED;
+  }
+
+  // Returns false if the handler stopped reading.
+  bool act(Action action) {
+    if (action == Action::STOP) {
+      state = STOPPED;
+      return false;
+    }
+    return true;
+  }
+
+  // Called after a value has been read.
+  void complete() {
+    state = stack.empty() ? END : NEXT;
+  }
+
+  void startValue(std::string_view data, size_t i) {
+    const char c = data[i];
+
+    const bool skip = skipping > 0 || skipNext;
+    skipNext = false;
+
+    switch (c) {
+      case '{':
+      case '[': {
+        if (stack.size() == internal::STOUT_JSON_MAX_DEPTH) {
+          fail(data, i);
+          return;
+        }
+
+        stack.push_back(c);
+        state = c == '{' ? FIRST_KEY : FIRST_ELEMENT;
+
+        if (!skip) {
+          const Action action =
+            c == '{' ? handler->startObject() : handler->startArray();
+          if (!act(action)) {
+            return;
+          } else if (action == Action::SKIP) {
+            skipping = stack.size();
+          }
+        } else if (skipping == 0) {
+          skipping = stack.size();
+        }
+        return;
+      }
+      case '"':
+        startString(false, skip);
+        return;
+      case '-':
+      case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
+        state = NUMBER;
+        break;
+      case 't':
+      case 'f':
+      case 'n':
+        state = LITERAL;
+        break;
+      default:
+        fail(data, i);
+        return;
+    }
+
+    silent = skip;
+    token.assign(1, c);
+  }
+
+  void end(char c) {
+    stack.pop_back();
+
+    // The end of a skipped object or array doesn't have an event.
+    if (skipping > 0) {
+      if (skipping > stack.size()) {
+        skipping = 0;
+      }
+    } else if (!act(c == '}' ? handler->endObject() : handler->endArray())) {
+      return;
+    }
+
+    complete();
+  }
+
+  void startString(bool key, bool skip) {
+    state = STRING;
+    inKey = key;
+    silent = skip;
+    escaped = false;
+    escapes = false;
+    escapeNext = false;
+    hexDigits = 0;
+    placeholder = false;
+    token.clear();
+  }
+
+  // Reads the string from position 'i' of 'data' until its end or the
+  // end of the chunk and returns the position after what was read.
+  size_t readString(std::string_view data, size_t i) {
+    const size_t begin = i;
+    for (; i < data.size(); i++) {
+      const unsigned char c = data[i];
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = escapes = true;
+      } else if (c == '"') {
+        break;
+      } else if (c < ' ') {
+        fail(data, i);
+        return i;
+      }
+
+      if (silent) {
+        keepEscapes(c);
+
+        // Check what has been kept so far rather than keep it all,
+        // which is only safe between escapes.
+        if (placeholder && token.size() >= MAX_KEPT_ESCAPES) {
+          if (!unescapeToken()) {
+            fail(data, i);
+            return i;
+          }
+          token.clear();
+        }
+      }
+    }
+
+    if (!silent) {
+      token.append(data.data() + begin, i - begin);
+    }
+
+    if (i == data.size()) {
+      return i;
+    }
+
+    endString(data, i);
+    return i + 1;
+  }
+
+  // Keeps just enough of a string that is silent (i.e., skipped) to
+  // check its escapes: the escapes themselves, with each run of other
+  // characters replaced by a single 'x' so that escapes which must be
+  // adjacent (the halves of a surrogate pair) only are if they were.
+  void keepEscapes(char c) {
+    if (escapeNext) {
+      token.push_back(c);
+      escapeNext = false;
+      hexDigits = c == 'u' ? 4 : 0;
+    } else if (hexDigits > 0) {
+      token.push_back(c);
+      hexDigits--;
+    } else if (c == '\\') {
+      token.push_back(c);
+      escapeNext = true;
+      placeholder = false;
+    } else if (!placeholder) {
+      token.push_back('x');
+      placeholder = true;
+    }
+  }
+
+  // Unescapes 'token' in place, returning false if it has an invalid
+  // escape.
+  bool unescapeToken() {
+    const char* invalid = nullptr;
+    const char* last = internal::unescape(
+        token.data(),
+        token.data() + token.size(),
+        &token[0],
+        &invalid);
+
+    if (last == nullptr) {
+      return false;
+    }
+
+    token.resize(last - token.data());
+    return true;
+  }
+
+  void endString(std::string_view data, size_t i) {
+    if (escapes && !unescapeToken()) {
+      fail(data, i);
+      return;
+    }
+
+    if (inKey) {
+      state = COLON;
+      if (!silent) {
+        const Action action = handler->key(token);
+        if (!act(action)) {
+          return;
+        }
+        skipNext = action == Action::SKIP;
+      }
+      return;
+    }
+
+    if (!silent && !act(handler->string(token))) {
+      return;
+    }
+
+    complete();
+  }
+
+  // Ends the number or literal being read at position 'i' of 'data'.
+  void endToken(std::string_view data, size_t i) {
+    if (state == NUMBER) {
+      const internal::ParsedNumber number = internal::parseNumber(token, 0);
+
+      switch (number.type) {
+        case internal::ParsedNumber::INVALID:
+          fail(data, i);
+          return;
+        case internal::ParsedNumber::OUT_OF_RANGE:
+          failure = Error("Value out of range");
+          state = FAILED;
+          return;
+        case internal::ParsedNumber::INTEGER:
+          if (!silent && !act(handler->number(Number(number.integer)))) {
+            return;
+          }
+          break;
+        case internal::ParsedNumber::UNSIGNED_INTEGER:
+          if (!silent &&
+              !act(handler->number(Number(number.unsigned_integer)))) {
+            return;
+          }
+          break;
+        case internal::ParsedNumber::FLOATING:
+          if (!silent && !act(handler->number(Number(number.floating)))) {
+            return;
+          }
+          break;
+      }
+    } else if (token == "true" || token == "false") {
+      if (!silent && !act(handler->boolean(token == "true"))) {
+        return;
+      }
+    } else if (token == "null") {
+      if (!silent && !act(handler->null())) {
+        return;
+      }
+    } else {
+      fail(data, i);
+      return;
+    }
+
+    complete();
+  }
+
+  H* handler;
+
+  enum {
+    VALUE, // Expecting a value.
+    FIRST_ELEMENT, // Expecting a value or the end of an empty array.
+    FIRST_KEY, // Expecting a key or the end of an empty object.
+    KEY, // Expecting a key.
+    COLON,
+    NEXT, // Expecting a ',' or the end of an array or object.
+    END, // Read a complete value.
+    STRING,
+    NUMBER,
+    LITERAL,
+    STOPPED,
+    FAILED,
+  } state = VALUE;
+
+  // The objects and arrays being read: '{' or '['.
+  std::vector<char> stack;
+
+  // The depth of the object or array being skipped, or 0.
+  size_t skipping = 0;
+
+  // Whether to skip the next value (the handler skipped its key).
+  bool skipNext = false;
+
+  // The string, number or literal being read, which isn't kept when
+  // 'silent' (i.e., skipped).
+  std::string token;
+  bool silent = false;
+
+  // Whether the string being read is a key, ends with a backslash and
+  // has any escapes.
+  bool inKey = false;
+  bool escaped = false;
+  bool escapes = false;
+
+  // What 'keepEscapes' has kept of a silent string: whether the next
+  // character is that of an escape, the number of hex digits of a
+  // '\\u' escape still to come, and whether the last character kept
+  // stands for characters other than escapes.
+  bool escapeNext = false;
+  size_t hexDigits = 0;
+  bool placeholder = false;
+
+  // How much of a silent string is kept before checking its escapes.
+  static constexpr size_t MAX_KEPT_ESCAPES = 4096;
+
+  size_t line = 1;
+  Option<Error> failure;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Reads 'fd' until EOF (or until the handler stops reading) 'size'
+// bytes at a time with 'reader', and then finishes reading.
+template <typename H>
+Try<Nothing> read(int_fd fd, Reader<H>* reader, size_t size = 64 * 1024) {
+  while (!reader->stopped()) {
+    Result<std::string> data = os::read(fd, size);
+    if (data.isError()) {
+      return Error("Failed to read: " + data.error());
+    } else if (data.isNone()) {
+      break;
+    }
+
+    Try<Nothing> read = reader->feed(data.get());
+    if (read.isError()) {
+      return read;
+    }
+  }
+
+  return reader->finish();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace JSON
@@ -0,0 +1,107 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "fmt/format.h"
+#include "stout/error.h"
+#include "stout/gzip.h"
+#include "stout/jsonify.h"
+#include "stout/nothing.h"
+#include "stout/try.h"
+
+#include "stout/os/int_fd.h"
+#include "stout/os/write.h"
+
+// Sinks for `JSON::write` (see stout/jsonify.h), to write large JSON
+// to a file descriptor or compressed without having all of it in
+// memory at once.
+
+namespace JSON {
+
+////////////////////////////////////////////////////////////////////////
+
+// Returns a sink that writes to `fd`, e.g., a file or a socket.
+inline Sink sink(int_fd fd) {
+  return [fd](std::string_view data) -> Try<Nothing> {
+    if (os::signal_safe::write_impl(fd, data.data(), data.size()) < 0) {
+#ifdef _WIN32
+      return WindowsError();
+#else
+      return ErrnoError();
+#endif // _WIN32
+    }
+    return Nothing();
+  };
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// Writes `jsonify(value)` to `fd` `size` bytes at a time.
+template <typename T>
+Try<Nothing> write(
+    int_fd fd,
+    const T& value,
+    size_t size = internal::FLUSH_SIZE) {
+  return write(sink(fd), value, size);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// Writes `jsonify(value)` gzip compressed (with a compression level as
+// for `gzip::compress`) to `sink`, compressing `size` bytes at a time.
+// The sink is only called when there's compressed output.
+template <typename T>
+Try<Nothing> compress(
+    const Sink& sink,
+    const T& value,
+    int level = Z_DEFAULT_COMPRESSION,
+    size_t size = internal::FLUSH_SIZE) {
+  if (!(level == Z_DEFAULT_COMPRESSION
+        || (level >= Z_NO_COMPRESSION && level <= Z_BEST_COMPRESSION))) {
+    return Error(fmt::format("Invalid compression level: {}", level));
+  }
+
+  gzip::Compressor compressor(level);
+
+  Try<Nothing> write = JSON::write(
+      [&](std::string_view data) -> Try<Nothing> {
+        Try<std::string> compressed = compressor.compress(data);
+        if (compressed.isError()) {
+          return Error("Failed to compress: " + compressed.error());
+        } else if (compressed->empty()) {
+          return Nothing();
+        }
+        return sink(compressed.get());
+      },
+      value,
+      size);
+
+  if (write.isError()) {
+    return write;
+  }
+
+  Try<std::string> compressed = compressor.finish();
+  if (compressed.isError()) {
+    return Error("Failed to compress: " + compressed.error());
+  }
+
+  return sink(compressed.get());
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace JSON
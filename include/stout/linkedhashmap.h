@@ -12,30 +12,52 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
+#include <memory>
+#include <type_traits>
 #include <utility>
 
 #include "stout/foreach.h"
+#include "stout/footprint.h"
+#include "stout/hash.h"
 #include "stout/hashmap.h"
 #include "stout/option.h"
+#include "stout/views.h"
 
 ////////////////////////////////////////////////////////////////////////
 
 // Implementation of a hashmap that maintains the insertion order of
-// the keys. Updating a key does not change insertion order.
+// the keys. Updating a key does not change insertion order. Both the
+// entries and the index are allocated with 'Allocator', e.g., from an
+// arena, see stout/pmr.h.
 //
 // TODO(vinod/bmahler): Consider extending from stout::hashmap and/or
 // having a compatible API with stout::hashmap.
-template <typename Key, typename Value>
+template <
+    typename Key,
+    typename Value,
+    typename Allocator = std::allocator<std::pair<Key, Value>>>
 class LinkedHashMap {
  public:
   typedef std::pair<Key, Value> entry;
-  typedef std::list<entry> list;
-  typedef hashmap<Key, typename list::iterator> map;
+  typedef std::list<entry, Allocator> list;
+  typedef hashmap<
+      Key,
+      typename list::iterator,
+      stout::Hash<Key>,
+      std::equal_to<Key>,
+      typename std::allocator_traits<Allocator>::template rebind_alloc<
+          std::pair<const Key, typename list::iterator>>>
+    map;
 
   LinkedHashMap() = default;
 
-  LinkedHashMap(const LinkedHashMap<Key, Value>& other)
+  explicit LinkedHashMap(const Allocator& allocator)
+    : entries_(allocator),
+      keys_(typename map::allocator_type(allocator)) {}
+
+  LinkedHashMap(const LinkedHashMap& other)
     : entries_(other.entries_) {
     // Build up the index.
     for (auto it = entries_.begin(); it != entries_.end(); ++it) {
@@ -43,7 +65,7 @@ class LinkedHashMap {
     }
   }
 
-  LinkedHashMap& operator=(const LinkedHashMap<Key, Value>& other) {
+  LinkedHashMap& operator=(const LinkedHashMap& other) {
     clear();
 
     entries_ = other.entries_;
@@ -57,7 +79,7 @@ class LinkedHashMap {
   }
 
   // TODO(bmahler): Implement move construction / assignment.
-  LinkedHashMap(LinkedHashMap<Key, Value>&&) = delete;
+  LinkedHashMap(LinkedHashMap&&) = delete;
   LinkedHashMap& operator=(LinkedHashMap&&) = delete;
 
   Value& operator[](const Key& key) {
@@ -102,6 +124,22 @@ class LinkedHashMap {
     return 0;
   }
 
+  // Returns a view of the keys in the map in insertion order that
+  // iterates the map in place rather than copying the keys.
+  auto keys_view() const {
+    return stout::keys_view(entries_.cbegin(), entries_.cend());
+  }
+
+  // Returns a view of the values in the map in insertion order that
+  // iterates the map in place rather than copying the values.
+  auto values_view() const {
+    return stout::values_view(entries_.cbegin(), entries_.cend());
+  }
+
+  auto values_view() {
+    return stout::values_view(entries_.begin(), entries_.end());
+  }
+
   // Returns the keys in the map in insertion order.
   std::vector<Key> keys() const {
     std::vector<Key> result;
@@ -156,6 +194,13 @@ class LinkedHashMap {
     return entries_.cend();
   }
 
+  // Estimates the heap used by the entries and the index, see
+  // stout/footprint.h.
+  friend size_t heapFootprint(const LinkedHashMap& map) {
+    return stout::heapFootprint(map.entries_) +
+      stout::heapFootprint(map.keys_);
+  }
+
  private:
   list entries_; // Key-value pairs ordered by insertion order.
   map keys_; // Map from key to "pointer" to key's location in list.
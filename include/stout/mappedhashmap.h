@@ -0,0 +1,449 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "stout/error.h"
+#include "stout/hash.h"
+#include "stout/none.h"
+#include "stout/nothing.h"
+#include "stout/option.h"
+#include "stout/os/close.h"
+#include "stout/os/open.h"
+#include "stout/os/read.h"
+#include "stout/os/rename.h"
+#include "stout/os/write.h"
+#include "stout/try.h"
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+// How keys and values are stored in a 'MappedHashMap'. Strings are
+// stored as their bytes and read back as 'std::string_view's into the
+// mapping, other types are stored as their object representation (so
+// keys must not contain padding and values must be trivially
+// copyable).
+template <typename T>
+struct Mapped {
+  static_assert(
+      std::is_trivially_copyable<T>::value,
+      "MappedHashMap only supports strings and trivially copyable types");
+
+  typedef T View;
+
+  static std::string_view bytes(const T& t) {
+    return std::string_view(reinterpret_cast<const char*>(&t), sizeof(T));
+  }
+
+  // Returns whether 'bytes' can be read back with 'view', i.e., they
+  // aren't from a file written with a different type.
+  static bool valid(std::string_view bytes) {
+    return bytes.size() == sizeof(T);
+  }
+
+  static View view(std::string_view bytes) {
+    T t;
+    memcpy(&t, bytes.data(), sizeof(T));
+    return t;
+  }
+};
+
+
+template <>
+struct Mapped<std::string> {
+  typedef std::string_view View;
+
+  static std::string_view bytes(std::string_view s) {
+    return s;
+  }
+
+  static bool valid(std::string_view) {
+    return true;
+  }
+
+  static View view(std::string_view bytes) {
+    return bytes;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// The hash of the bytes of a key, with a fixed seed rather than the
+// per process 'hash::seed()' since the hashes are persisted.
+inline uint64_t mappedHash(std::string_view bytes) {
+  return stout::hash::bytes(bytes.data(), bytes.size(), 0);
+}
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// An immutable hash table that is stored in a file and 'mmap'ed for
+// lookups, so opening even a very large table is O(1) and its pages
+// are shared by every process on the host that opens the same file.
+// A table is built once from any map (e.g., a 'hashmap'):
+//
+//   MappedHashMap<std::string, uint64_t>::write(path, map);
+//
+// and then opened (cheaply, possibly by many processes) for lookups:
+//
+//   Try<MappedHashMap<std::string, uint64_t>> table =
+//     MappedHashMap<std::string, uint64_t>::open(path);
+//
+//   Option<uint64_t> value = table->get("key");
+//
+// Keys and values are either 'std::string's or trivially copyable
+// types. Strings are returned as 'std::string_view's into the mapping
+// (no copy is made) which are valid for as long as any copy of the
+// table exists.
+//
+// The file is an open addressed table with linear probing at a load
+// factor of at most 1/2 followed by the entries. It's written in the
+// byte order of the host that built it and 'open' rejects files from
+// a host with a different byte order.
+//
+// NOTE: A table must not be rewritten in place while it's mapped,
+// 'write' therefore writes to a temporary file which is then renamed
+// over 'path', which leaves existing mappings of the old file intact.
+template <typename Key, typename Value>
+class MappedHashMap {
+  static_assert(
+      std::is_same<Key, std::string>::value ||
+        std::has_unique_object_representations<Key>::value,
+      "MappedHashMap keys must be strings or have no padding");
+
+ public:
+  typedef typename internal::Mapped<Key>::View KeyView;
+  typedef typename internal::Mapped<Value>::View ValueView;
+
+  // Returns 'map' (any iterable of key/value pairs with unique keys)
+  // in the format read by 'parse' and 'open'.
+  template <typename Map>
+  static std::string serialize(const Map& map);
+
+  // Writes 'map' to 'path', see 'serialize'.
+  template <typename Map>
+  static Try<Nothing> write(const std::string& path, const Map& map) {
+    const std::string temporary = path + ".tmp";
+
+    Try<Nothing> write = os::write(temporary, serialize(map), true);
+    if (write.isError()) {
+      return Error(
+          "Failed to write '" + temporary + "': " + write.error());
+    }
+
+    return os::rename(temporary, path);
+  }
+
+  // Maps the table at 'path' into memory.
+  static Try<MappedHashMap> open(const std::string& path);
+
+  // Returns the table in 'data', e.g., the output of 'serialize'.
+  static Try<MappedHashMap> parse(std::string data) {
+    std::shared_ptr<Mapping> mapping(new Mapping());
+    mapping->owned = std::move(data);
+    mapping->data = mapping->owned.data();
+    mapping->size = mapping->owned.size();
+
+    return parse(std::move(mapping));
+  }
+
+  Option<ValueView> get(const KeyView& key) const {
+    const char* entry = find(key);
+    if (entry == nullptr) {
+      return None();
+    }
+
+    uint32_t sizes[2];
+    memcpy(sizes, entry, sizeof(sizes));
+    return internal::Mapped<Value>::view(
+        std::string_view(entry + sizeof(sizes) + sizes[0], sizes[1]));
+  }
+
+  bool contains(const KeyView& key) const {
+    return find(key) != nullptr;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+ private:
+  // The file starts with a header followed by 'capacity' slots and
+  // then the entries, each of which is the size of its key and value
+  // as 'uint32_t's followed by their bytes, padded to 8 bytes.
+  struct Header {
+    char magic[8];
+    uint64_t order;
+    uint64_t size;
+    uint64_t capacity;
+  };
+
+  // An empty slot has an 'offset' of 0, otherwise it's the position of
+  // the entry in the file.
+  struct Slot {
+    uint64_t hash;
+    uint64_t offset;
+  };
+
+  static constexpr char MAGIC[8] = {'S', 'T', 'O', 'U', 'T', 'M', 'H', '1'};
+
+  // Written in host order, so it reads differently on a host with a
+  // different byte order.
+  static constexpr uint64_t ORDER = 0x0102030405060708ULL;
+
+  // The memory of a table, shared by all copies of it.
+  struct Mapping {
+    Mapping() = default;
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping() {
+#ifndef _WIN32
+      if (mapped) {
+        munmap(const_cast<char*>(data), size);
+      }
+#endif // _WIN32
+    }
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+
+    // Only used when the table is not mapped from a file.
+    std::string owned;
+  };
+
+  MappedHashMap() = default;
+
+  static Try<MappedHashMap> parse(std::shared_ptr<Mapping> mapping);
+
+  const char* find(const KeyView& key) const {
+    const std::string_view bytes = internal::Mapped<Key>::bytes(key);
+    const uint64_t hash = internal::mappedHash(bytes);
+    const uint64_t mask = capacity - 1;
+
+    for (uint64_t i = hash & mask, probes = 0;
+         probes < capacity;
+         i = (i + 1) & mask, probes++) {
+      Slot slot;
+      memcpy(&slot, slots + i * sizeof(Slot), sizeof(Slot));
+
+      if (slot.offset == 0) {
+        return nullptr;
+      }
+
+      if (slot.hash != hash) {
+        continue;
+      }
+
+      // Check the entry is within the mapping in case the file is
+      // corrupt, rather than reading past its end.
+      uint32_t sizes[2];
+      if (slot.offset > mapping->size - sizeof(sizes)) {
+        return nullptr;
+      }
+
+      const char* entry = mapping->data + slot.offset;
+      memcpy(sizes, entry, sizeof(sizes));
+
+      if (uint64_t(sizes[0]) + sizes[1] >
+          mapping->size - slot.offset - sizeof(sizes)) {
+        return nullptr;
+      }
+
+      if (std::string_view(entry + sizeof(sizes), sizes[0]) == bytes) {
+        // Reject a value of the wrong size rather than reading past it
+        // (e.g., from a table written with a different 'Value').
+        if (!internal::Mapped<Value>::valid(std::string_view(
+                entry + sizeof(sizes) + sizes[0],
+                sizes[1]))) {
+          return nullptr;
+        }
+        return entry;
+      }
+    }
+
+    return nullptr;
+  }
+
+  std::shared_ptr<Mapping> mapping;
+  const char* slots = nullptr;
+  uint64_t capacity = 0;
+  size_t size_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename Key, typename Value>
+template <typename Map>
+std::string MappedHashMap<Key, Value>::serialize(const Map& map) {
+  std::vector<std::pair<std::string_view, std::string_view>> entries;
+  for (const auto& [key, value] : map) {
+    entries.emplace_back(
+        internal::Mapped<Key>::bytes(key),
+        internal::Mapped<Value>::bytes(value));
+  }
+
+  uint64_t capacity = 1;
+  while (capacity < 2 * entries.size()) {
+    capacity *= 2;
+  }
+
+  Header header;
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.order = ORDER;
+  header.size = entries.size();
+  header.capacity = capacity;
+
+  std::vector<Slot> slots(capacity, Slot{0, 0});
+
+  std::string data(sizeof(Header) + capacity * sizeof(Slot), '\0');
+  memcpy(&data[0], &header, sizeof(Header));
+
+  for (const auto& [key, value] : entries) {
+    uint64_t i = internal::mappedHash(key) & (capacity - 1);
+    while (slots[i].offset != 0) {
+      i = (i + 1) & (capacity - 1);
+    }
+
+    slots[i].hash = internal::mappedHash(key);
+    slots[i].offset = data.size();
+
+    const uint32_t sizes[2] = {
+      static_cast<uint32_t>(key.size()),
+      static_cast<uint32_t>(value.size()),
+    };
+
+    data.append(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    data.append(key);
+    data.append(value);
+    data.append((8 - data.size() % 8) % 8, '\0');
+  }
+
+  memcpy(&data[sizeof(Header)], slots.data(), capacity * sizeof(Slot));
+
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename Key, typename Value>
+Try<MappedHashMap<Key, Value>> MappedHashMap<Key, Value>::open(
+    const std::string& path) {
+#ifdef _WIN32
+  // TODO: Use 'CreateFileMapping' rather than reading the file.
+  Try<std::string> read = os::read(path);
+  if (read.isError()) {
+    return Error("Failed to read '" + path + "': " + read.error());
+  }
+
+  return parse(std::move(read.get()));
+#else
+  Try<int_fd> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  struct stat s;
+  if (::fstat(fd.get(), &s) < 0) {
+    ErrnoError error("Failed to stat '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  const size_t size = s.st_size;
+
+  if (size < sizeof(Header)) {
+    os::close(fd.get());
+    return Error("'" + path + "' is not a MappedHashMap");
+  }
+
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+
+  // The mapping keeps a reference to the file.
+  os::close(fd.get());
+
+  if (data == MAP_FAILED) {
+    return ErrnoError("Failed to mmap '" + path + "'");
+  }
+
+  std::shared_ptr<Mapping> mapping(new Mapping());
+  mapping->data = static_cast<const char*>(data);
+  mapping->size = size;
+  mapping->mapped = true;
+
+  return parse(std::move(mapping));
+#endif // _WIN32
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename Key, typename Value>
+Try<MappedHashMap<Key, Value>> MappedHashMap<Key, Value>::parse(
+    std::shared_ptr<Mapping> mapping) {
+  Header header;
+  if (mapping->size < sizeof(Header)) {
+    return Error("Not a MappedHashMap");
+  }
+
+  memcpy(&header, mapping->data, sizeof(Header));
+
+  if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    return Error("Not a MappedHashMap");
+  }
+
+  if (header.order != ORDER) {
+    return Error("MappedHashMap was written with a different byte order");
+  }
+
+  if (header.capacity == 0 ||
+      (header.capacity & (header.capacity - 1)) != 0 ||
+      header.size > header.capacity ||
+      header.capacity >
+        (mapping->size - sizeof(Header)) / sizeof(Slot)) {
+    return Error(
+        "Invalid capacity " + std::to_string(header.capacity) +
+        " for a MappedHashMap of " + std::to_string(mapping->size) +
+        " bytes");
+  }
+
+  MappedHashMap map;
+  map.slots = mapping->data + sizeof(Header);
+  map.capacity = header.capacity;
+  map.size_ = header.size;
+  map.mapping = std::move(mapping);
+
+  return map;
+}
+
+////////////////////////////////////////////////////////////////////////
@@ -15,11 +15,14 @@
 #include <algorithm> // For find.
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <unordered_map>
 #include <utility>
 
 #include "stout/foreach.h"
+#include "stout/hash.h"
+#include "stout/views.h"
 
 ////////////////////////////////////////////////////////////////////////
 
@@ -31,18 +34,44 @@
 template <
     typename Key,
     typename Value,
-    typename Hash = std::hash<Key>,
-    typename Equal = std::equal_to<Key>>
-class multihashmap : public std::unordered_multimap<Key, Value, Hash, Equal> {
+    typename Hash = stout::Hash<Key>,
+    typename Equal = std::equal_to<Key>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class multihashmap
+  : public std::unordered_multimap<Key, Value, Hash, Equal, Allocator> {
  public:
+  typedef typename std::unordered_multimap<
+      Key,
+      Value,
+      Hash,
+      Equal,
+      Allocator>::const_iterator const_iterator;
+
+  typedef stout::IteratorRange<stout::ValueIterator<const_iterator>>
+    values_view_type;
+
+  typedef stout::IteratorRange<
+      stout::DistinctKeyIterator<const_iterator, Equal>>
+    keys_view_type;
+
   multihashmap() {}
+  explicit multihashmap(const Allocator& allocator);
   multihashmap(const std::multimap<Key, Value>& multimap);
   multihashmap(std::multimap<Key, Value>&& multimap);
-  multihashmap(std::initializer_list<std::pair<const Key, Value>> list);
+  multihashmap(
+      std::initializer_list<std::pair<const Key, Value>> list,
+      const Allocator& allocator = Allocator());
 
   void put(const Key& key, const Value& value);
   std::list<Value> get(const Key& key) const;
   std::set<Key> keys() const;
+
+  // Like 'get' and 'keys' except these return views that iterate the
+  // map in place rather than copying. Note that the keys are visited
+  // in no particular order, unlike 'keys' which sorts them.
+  values_view_type equal_range_view(const Key& key) const;
+  keys_view_type keys_view() const;
+
   bool remove(const Key& key);
   bool remove(const Key& key, const Value& value);
   bool contains(const Key& key) const;
@@ -51,51 +80,93 @@ class multihashmap : public std::unordered_multimap<Key, Value, Hash, Equal> {
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-multihashmap<Key, Value, Hash, Equal>::multihashmap(
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+multihashmap<Key, Value, Hash, Equal, Allocator>::multihashmap(
+    const Allocator& allocator)
+  : std::unordered_multimap<Key, Value, Hash, Equal, Allocator>(allocator) {}
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+multihashmap<Key, Value, Hash, Equal, Allocator>::multihashmap(
     const std::multimap<Key, Value>& multimap) {
-  std::unordered_multimap<Key, Value, Hash, Equal>::reserve(multimap.size());
+  this->reserve(multimap.size());
 
   foreachpair(const Key& key, const Value& value, multimap) {
-    std::unordered_multimap<Key, Value, Hash, Equal>::emplace(key, value);
+    this->emplace(key, value);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-multihashmap<Key, Value, Hash, Equal>::multihashmap(
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+multihashmap<Key, Value, Hash, Equal, Allocator>::multihashmap(
     std::multimap<Key, Value>&& multimap) {
-  std::unordered_multimap<Key, Value, Hash, Equal>::insert(
+  std::unordered_multimap<Key, Value, Hash, Equal, Allocator>::insert(
       std::make_move_iterator(multimap.begin()),
       std::make_move_iterator(multimap.end()));
 }
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-multihashmap<Key, Value, Hash, Equal>::multihashmap(
-    std::initializer_list<std::pair<const Key, Value>> list)
-  : std::unordered_multimap<Key, Value, Hash, Equal>(list) {}
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+multihashmap<Key, Value, Hash, Equal, Allocator>::multihashmap(
+    std::initializer_list<std::pair<const Key, Value>> list,
+    const Allocator& allocator)
+  : std::unordered_multimap<Key, Value, Hash, Equal, Allocator>(
+        list,
+        0,
+        Hash(),
+        Equal(),
+        allocator) {}
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-void multihashmap<Key, Value, Hash, Equal>::put(
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+void multihashmap<Key, Value, Hash, Equal, Allocator>::put(
     const Key& key,
     const Value& value) {
-  std::unordered_multimap<Key, Value, Hash, Equal>::insert({key, value});
+  this->insert({key, value});
 }
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-std::list<Value> multihashmap<Key, Value, Hash, Equal>::get(
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+std::list<Value> multihashmap<Key, Value, Hash, Equal, Allocator>::get(
     const Key& key) const {
   std::list<Value> values; // Values to return.
 
-  auto range =
-      std::unordered_multimap<Key, Value, Hash, Equal>::equal_range(key);
+  auto range = this->equal_range(key);
 
   for (auto i = range.first; i != range.second; ++i) {
     values.push_back(i->second);
@@ -106,8 +177,13 @@ std::list<Value> multihashmap<Key, Value, Hash, Equal>::get(
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-std::set<Key> multihashmap<Key, Value, Hash, Equal>::keys() const {
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+std::set<Key> multihashmap<Key, Value, Hash, Equal, Allocator>::keys() const {
   std::set<Key> keys;
   foreachkey(const Key& key, *this) {
     keys.insert(key);
@@ -117,23 +193,68 @@ std::set<Key> multihashmap<Key, Value, Hash, Equal>::keys() const {
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-bool multihashmap<Key, Value, Hash, Equal>::remove(const Key& key) {
-  return std::unordered_multimap<Key, Value, Hash, Equal>::erase(key) > 0;
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+typename multihashmap<Key, Value, Hash, Equal, Allocator>::values_view_type
+multihashmap<Key, Value, Hash, Equal, Allocator>::equal_range_view(
+    const Key& key) const {
+  auto range = this->equal_range(key);
+
+  return stout::values_view(range.first, range.second);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+typename multihashmap<Key, Value, Hash, Equal, Allocator>::keys_view_type
+multihashmap<Key, Value, Hash, Equal, Allocator>::keys_view() const {
+  typedef stout::DistinctKeyIterator<const_iterator, Equal> iterator;
+
+  const_iterator begin = this->begin();
+  const_iterator end = this->end();
+
+  return keys_view_type(
+      iterator(begin, end, this->key_eq()),
+      iterator(end, end, this->key_eq()));
 }
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-bool multihashmap<Key, Value, Hash, Equal>::remove(
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+bool multihashmap<Key, Value, Hash, Equal, Allocator>::remove(const Key& key) {
+  return this->erase(key) > 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+bool multihashmap<Key, Value, Hash, Equal, Allocator>::remove(
     const Key& key,
     const Value& value) {
-  auto range =
-      std::unordered_multimap<Key, Value, Hash, Equal>::equal_range(key);
+  auto range = this->equal_range(key);
 
   for (auto i = range.first; i != range.second; ++i) {
     if (i->second == value) {
-      std::unordered_multimap<Key, Value, Hash, Equal>::erase(i);
+      std::unordered_multimap<Key, Value, Hash, Equal, Allocator>::erase(i);
       return true;
     }
   }
@@ -143,19 +264,34 @@ bool multihashmap<Key, Value, Hash, Equal>::remove(
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-bool multihashmap<Key, Value, Hash, Equal>::contains(const Key& key) const {
-  return multihashmap<Key, Value, Hash, Equal>::count(key) > 0;
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+bool multihashmap<Key, Value, Hash, Equal, Allocator>::contains(
+    const Key& key) const {
+  return multihashmap<Key, Value, Hash, Equal, Allocator>::count(key) > 0;
 }
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Value, typename Hash, typename Equal>
-bool multihashmap<Key, Value, Hash, Equal>::contains(
+template <
+    typename Key,
+    typename Value,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+bool multihashmap<Key, Value, Hash, Equal, Allocator>::contains(
     const Key& key,
     const Value& value) const {
-  const std::list<Value> values = get(key);
-  return std::find(values.begin(), values.end(), value) != values.end();
+  foreach (const Value& v, equal_range_view(key)) {
+    if (v == value) {
+      return true;
+    }
+  }
+  return false;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,567 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stout/bits.h"
+#include "stout/hash.h"
+#include "stout/none.h"
+#include "stout/option.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// An immutable (persistent) hash map where every "modification" like
+// 'put' or 'erase' returns a new version of the map, leaving the
+// original untouched. Versions share all of the structure that didn't
+// change so creating a new version costs O(log n) time and memory
+// rather than the O(n) of copying a 'hashmap'. This makes it cheap to
+// publish a snapshot of a large map to readers after every change.
+//
+// The map is a hash array mapped trie (HAMT) in the "compressed" form
+// (CHAMP) where each node uses 5 bits of the hash of a key to pick one
+// of 32 slots, and stores entries and child nodes in two compact
+// arrays indexed by a pair of bitmaps. Keys whose hashes are equal in
+// all bits end up in a "collision" node at the bottom of the trie.
+//
+// Since nodes are never modified after they are created, and are
+// reference counted via 'std::shared_ptr', any number of threads can
+// read any versions concurrently, including while other threads create
+// new versions. Publishing a new version to other threads still needs
+// synchronization though, e.g., a 'synchronized' or atomic pointer to
+// the current version.
+template <
+    typename Key,
+    typename Value,
+    typename Hash = stout::Hash<Key>,
+    typename Equal = std::equal_to<Key>>
+class PersistentHashMap {
+  static constexpr size_t BITS = 5;
+  static constexpr size_t MASK = (1 << BITS) - 1;
+
+  // The number of levels until every bit of the hash has been used.
+  static constexpr size_t LEVELS = (sizeof(size_t) * 8 + BITS - 1) / BITS;
+
+  struct Node;
+
+ public:
+  typedef std::pair<Key, Value> entry;
+
+  class const_iterator;
+
+  PersistentHashMap() {}
+
+  PersistentHashMap(std::initializer_list<entry> list) {
+    for (const entry& entry : list) {
+      *this = put(entry.first, entry.second);
+    }
+  }
+
+  // Checks whether this map contains a binding for a key.
+  bool contains(const Key& key) const {
+    return find(key) != nullptr;
+  }
+
+  // Returns an Option for the binding to the key.
+  Option<Value> get(const Key& key) const {
+    const entry* found = find(key);
+    if (found == nullptr) {
+      return None();
+    }
+    return found->second;
+  }
+
+  // Returns a new version of this map with the key bound to the
+  // value, replacing an old binding if the key is already present.
+  PersistentHashMap put(const Key& key, const Value& value) const {
+    if (!root) {
+      return PersistentHashMap(leaf(entry(key, value)), 1);
+    }
+
+    bool added = false;
+
+    std::shared_ptr<const Node> node =
+      put(root, hash(key), key, value, 0, &added);
+
+    return PersistentHashMap(std::move(node), size_ + (added ? 1 : 0));
+  }
+
+  // Returns a new version of this map without a binding for the key,
+  // or this version if there wasn't one to begin with.
+  PersistentHashMap erase(const Key& key) const {
+    if (!root) {
+      return *this;
+    }
+
+    std::shared_ptr<const Node> node = erase(root, hash(key), key, 0);
+
+    if (node == root) {
+      return *this;
+    }
+
+    return PersistentHashMap(std::move(node), size_ - 1);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  // Support for iteration; this allows using `foreachpair` and
+  // related constructs. The order of iteration is unspecified.
+  const_iterator begin() const {
+    return const_iterator(root.get());
+  }
+
+  const_iterator end() const {
+    return const_iterator();
+  }
+
+  // A forward iterator over the entries of a version of the map which
+  // remains valid as long as that version (or a copy) exists.
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef entry value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const entry* pointer;
+    typedef const entry& reference;
+
+    const_iterator() {}
+
+    reference operator*() const {
+      return *current;
+    }
+
+    pointer operator->() const {
+      return current;
+    }
+
+    const_iterator& operator++() {
+      advance();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator result = *this;
+      advance();
+      return result;
+    }
+
+    bool operator==(const const_iterator& that) const {
+      return current == that.current;
+    }
+
+    bool operator!=(const const_iterator& that) const {
+      return current != that.current;
+    }
+
+   private:
+    friend class PersistentHashMap;
+
+    explicit const_iterator(const Node* node) {
+      if (node != nullptr) {
+        stack[depth++] = {node, 0};
+        advance();
+      }
+    }
+
+    // Moves to the next entry in a depth first walk, visiting the
+    // entries of a node before its children.
+    void advance() {
+      while (depth > 0) {
+        Frame& frame = stack[depth - 1];
+        const size_t entries = frame.node->entries.size();
+
+        if (frame.index < entries) {
+          current = &frame.node->entries[frame.index++];
+          return;
+        }
+
+        if (frame.index - entries < frame.node->nodes.size()) {
+          const Node* child = frame.node->nodes[frame.index - entries].get();
+          frame.index++;
+          stack[depth++] = {child, 0};
+        } else {
+          depth--;
+        }
+      }
+
+      current = nullptr;
+    }
+
+    struct Frame {
+      const Node* node;
+      size_t index; // Entries first, followed by child nodes.
+    };
+
+    // One frame for each level of the trie plus a collision node.
+    std::array<Frame, LEVELS + 1> stack;
+    size_t depth = 0;
+    const entry* current = nullptr;
+  };
+
+ private:
+  // A node of the trie. Bit 'i' of 'datamap' is set if slot 'i' holds
+  // an entry, and of 'nodemap' if it holds a child node, in which case
+  // the entry (or child) is at the index of the number of lower bits
+  // set in the bitmap. A collision node (only below 'LEVELS') instead
+  // holds an unordered array of entries and no bitmaps.
+  struct Node {
+    uint32_t datamap = 0;
+    uint32_t nodemap = 0;
+    std::vector<entry> entries;
+    std::vector<std::shared_ptr<const Node>> nodes;
+  };
+
+  PersistentHashMap(std::shared_ptr<const Node> _root, size_t _size)
+    : root(std::move(_root)),
+      size_(_size) {}
+
+  static size_t hash(const Key& key) {
+    return Hash()(key);
+  }
+
+  static bool equal(const Key& left, const Key& right) {
+    return Equal()(left, right);
+  }
+
+  static uint32_t bit(size_t hash, size_t shift) {
+    return uint32_t(1) << ((hash >> shift) & MASK);
+  }
+
+  // Returns the index of the slot for 'bit' within 'bitmap'.
+  static size_t index(uint32_t bitmap, uint32_t bit) {
+    return bits::countSetBits(bitmap & (bit - 1));
+  }
+
+  static bool collision(size_t shift) {
+    return shift >= LEVELS * BITS;
+  }
+
+  static std::shared_ptr<const Node> leaf(entry&& entry) {
+    std::shared_ptr<Node> node = std::make_shared<Node>();
+    node->datamap = bit(hash(entry.first), 0);
+    node->entries.push_back(std::move(entry));
+    return node;
+  }
+
+  const entry* find(const Key& key) const {
+    const size_t hash = this->hash(key);
+
+    const Node* node = root.get();
+
+    for (size_t shift = 0; node != nullptr; shift += BITS) {
+      if (collision(shift)) {
+        for (const entry& entry : node->entries) {
+          if (equal(entry.first, key)) {
+            return &entry;
+          }
+        }
+        return nullptr;
+      }
+
+      const uint32_t bit = this->bit(hash, shift);
+
+      if (node->datamap & bit) {
+        const entry& entry = node->entries[index(node->datamap, bit)];
+        return equal(entry.first, key) ? &entry : nullptr;
+      }
+
+      if (node->nodemap & bit) {
+        node = node->nodes[index(node->nodemap, bit)].get();
+      } else {
+        node = nullptr;
+      }
+    }
+
+    return nullptr;
+  }
+
+  // Returns a copy of 'node' with the entry at 'position' replaced by,
+  // or if 'insert' is true preceded by, 'entry'.
+  static std::shared_ptr<Node> copy(
+      const Node& node,
+      size_t position,
+      entry&& entry,
+      bool insert) {
+    std::shared_ptr<Node> result = std::make_shared<Node>();
+    result->datamap = node.datamap;
+    result->nodemap = node.nodemap;
+    result->nodes = node.nodes;
+
+    result->entries.reserve(node.entries.size() + (insert ? 1 : 0));
+    for (size_t i = 0; i < node.entries.size(); i++) {
+      if (i == position) {
+        result->entries.push_back(std::move(entry));
+        if (!insert) {
+          continue;
+        }
+      }
+      result->entries.push_back(node.entries[i]);
+    }
+
+    if (position == node.entries.size()) {
+      result->entries.push_back(std::move(entry));
+    }
+
+    return result;
+  }
+
+  // Returns a node holding the two entries, whose keys are different
+  // but whose hashes are equal in all bits below 'shift'.
+  static std::shared_ptr<const Node> merge(
+      entry&& first,
+      size_t firstHash,
+      entry&& second,
+      size_t secondHash,
+      size_t shift) {
+    std::shared_ptr<Node> node = std::make_shared<Node>();
+
+    if (collision(shift)) {
+      node->entries.push_back(std::move(first));
+      node->entries.push_back(std::move(second));
+      return node;
+    }
+
+    const uint32_t firstBit = bit(firstHash, shift);
+    const uint32_t secondBit = bit(secondHash, shift);
+
+    if (firstBit == secondBit) {
+      node->nodemap = firstBit;
+      node->nodes.push_back(merge(
+          std::move(first),
+          firstHash,
+          std::move(second),
+          secondHash,
+          shift + BITS));
+    } else {
+      node->datamap = firstBit | secondBit;
+      if (firstBit < secondBit) {
+        node->entries.push_back(std::move(first));
+        node->entries.push_back(std::move(second));
+      } else {
+        node->entries.push_back(std::move(second));
+        node->entries.push_back(std::move(first));
+      }
+    }
+
+    return node;
+  }
+
+  static std::shared_ptr<const Node> put(
+      const std::shared_ptr<const Node>& node,
+      size_t hash,
+      const Key& key,
+      const Value& value,
+      size_t shift,
+      bool* added) {
+    if (collision(shift)) {
+      for (size_t i = 0; i < node->entries.size(); i++) {
+        if (equal(node->entries[i].first, key)) {
+          return copy(*node, i, entry(key, value), false);
+        }
+      }
+      *added = true;
+      return copy(*node, node->entries.size(), entry(key, value), true);
+    }
+
+    const uint32_t bit = PersistentHashMap::bit(hash, shift);
+
+    if (node->datamap & bit) {
+      const size_t i = index(node->datamap, bit);
+      const entry& existing = node->entries[i];
+
+      if (equal(existing.first, key)) {
+        return copy(*node, i, entry(key, value), false);
+      }
+
+      // Push both entries down into a new child node.
+      *added = true;
+
+      std::shared_ptr<Node> result = std::make_shared<Node>();
+      result->datamap = node->datamap & ~bit;
+      result->nodemap = node->nodemap | bit;
+
+      result->entries.reserve(node->entries.size() - 1);
+      for (size_t j = 0; j < node->entries.size(); j++) {
+        if (j != i) {
+          result->entries.push_back(node->entries[j]);
+        }
+      }
+
+      result->nodes = node->nodes;
+      result->nodes.insert(
+          result->nodes.begin() + index(result->nodemap, bit),
+          merge(
+              entry(existing),
+              PersistentHashMap::hash(existing.first),
+              entry(key, value),
+              hash,
+              shift + BITS));
+
+      return result;
+    }
+
+    if (node->nodemap & bit) {
+      const size_t i = index(node->nodemap, bit);
+
+      std::shared_ptr<Node> result = std::make_shared<Node>(*node);
+      result->nodes[i] =
+        put(node->nodes[i], hash, key, value, shift + BITS, added);
+
+      return result;
+    }
+
+    *added = true;
+
+    std::shared_ptr<Node> result = copy(
+        *node,
+        index(node->datamap, bit),
+        entry(key, value),
+        true);
+
+    result->datamap |= bit;
+
+    return result;
+  }
+
+  // Returns 'node' itself if it doesn't contain 'key', or a copy
+  // without the entry for 'key', which is null if it would be empty.
+  static std::shared_ptr<const Node> erase(
+      const std::shared_ptr<const Node>& node,
+      size_t hash,
+      const Key& key,
+      size_t shift) {
+    if (collision(shift)) {
+      for (size_t i = 0; i < node->entries.size(); i++) {
+        if (equal(node->entries[i].first, key)) {
+          return without(*node, i, 0);
+        }
+      }
+      return node;
+    }
+
+    const uint32_t bit = PersistentHashMap::bit(hash, shift);
+
+    if (node->datamap & bit) {
+      const size_t i = index(node->datamap, bit);
+
+      if (!equal(node->entries[i].first, key)) {
+        return node;
+      }
+
+      return without(*node, i, bit);
+    }
+
+    if (node->nodemap & bit) {
+      const size_t i = index(node->nodemap, bit);
+
+      std::shared_ptr<const Node> child =
+        erase(node->nodes[i], hash, key, shift + BITS);
+
+      if (child == node->nodes[i]) {
+        return node;
+      }
+
+      // NOTE: Since a child with a single entry is always pulled up
+      // (see below) a child can't become empty, but handle it anyway.
+      if (!child) {
+        std::shared_ptr<Node> result = std::make_shared<Node>(*node);
+        result->nodemap &= ~bit;
+        result->nodes.erase(result->nodes.begin() + i);
+        if (result->entries.empty() && result->nodes.empty()) {
+          return nullptr;
+        }
+        return result;
+      }
+
+      // Keep the trie canonical by pulling a child with just a single
+      // entry up into this node, so that 'put' followed by 'erase'
+      // results in the same trie as before.
+      if (child->nodes.empty() && child->entries.size() == 1) {
+        std::shared_ptr<Node> result = std::make_shared<Node>();
+        result->datamap = node->datamap | bit;
+        result->nodemap = node->nodemap & ~bit;
+
+        const size_t position = index(result->datamap, bit);
+
+        result->entries.reserve(node->entries.size() + 1);
+        result->entries.insert(
+            result->entries.end(),
+            node->entries.begin(),
+            node->entries.begin() + position);
+        result->entries.push_back(child->entries.front());
+        result->entries.insert(
+            result->entries.end(),
+            node->entries.begin() + position,
+            node->entries.end());
+
+        result->nodes = node->nodes;
+        result->nodes.erase(result->nodes.begin() + i);
+
+        // If this node is now just a single entry it will in turn be
+        // pulled up by its parent, unless it's the root.
+        return result;
+      }
+
+      std::shared_ptr<Node> result = std::make_shared<Node>(*node);
+      result->nodes[i] = std::move(child);
+      return result;
+    }
+
+    return node;
+  }
+
+  // Returns a copy of 'node' without the entry at 'position' for the
+  // slot 'bit', or null if that was the only thing in the node.
+  static std::shared_ptr<const Node> without(
+      const Node& node,
+      size_t position,
+      uint32_t bit) {
+    if (node.entries.size() == 1 && node.nodes.empty()) {
+      return nullptr;
+    }
+
+    std::shared_ptr<Node> result = std::make_shared<Node>();
+    result->datamap = node.datamap & ~bit;
+    result->nodemap = node.nodemap;
+    result->nodes = node.nodes;
+
+    result->entries.reserve(node.entries.size() - 1);
+    for (size_t i = 0; i < node.entries.size(); i++) {
+      if (i != position) {
+        result->entries.push_back(node.entries[i]);
+      }
+    }
+
+    return result;
+  }
+
+  std::shared_ptr<const Node> root;
+  size_t size_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,95 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+#include "stout/hash.h"
+#include "stout/hashmap.h"
+#include "stout/hashset.h"
+#include "stout/linkedhashmap.h"
+#include "stout/multihashmap.h"
+
+////////////////////////////////////////////////////////////////////////
+
+// Variants of the collections that allocate from a
+// 'std::pmr::memory_resource', like the 'std::pmr' containers, e.g.:
+//
+//   stout::Arena arena;
+//   stout::pmr::hashmap<std::pmr::string, int> map(&arena);
+//
+// Keys and values that are themselves 'std::pmr' containers (such as
+// 'std::pmr::string' above) allocate from the same resource.
+
+////////////////////////////////////////////////////////////////////////
+
+namespace stout {
+namespace pmr {
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename Key,
+    typename Value,
+    typename Hash = stout::Hash<Key>,
+    typename Equal = std::equal_to<Key>>
+using hashmap = ::hashmap<
+    Key,
+    Value,
+    Hash,
+    Equal,
+    std::pmr::polymorphic_allocator<std::pair<const Key, Value>>>;
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename Elem,
+    typename Hash = stout::Hash<Elem>,
+    typename Equal = std::equal_to<Elem>>
+using hashset = ::hashset<
+    Elem,
+    Hash,
+    Equal,
+    std::pmr::polymorphic_allocator<Elem>>;
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename Key, typename Value>
+using LinkedHashMap = ::LinkedHashMap<
+    Key,
+    Value,
+    std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+
+////////////////////////////////////////////////////////////////////////
+
+template <
+    typename Key,
+    typename Value,
+    typename Hash = stout::Hash<Key>,
+    typename Equal = std::equal_to<Key>>
+using multihashmap = ::multihashmap<
+    Key,
+    Value,
+    Hash,
+    Equal,
+    std::pmr::polymorphic_allocator<std::pair<const Key, Value>>>;
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace pmr
+} // namespace stout
+
+////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,971 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "stout/bits.h"
+#include "stout/error.h"
+#include "stout/try.h"
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+namespace roaring {
+
+////////////////////////////////////////////////////////////////////////
+
+// The most values an array container holds before it becomes a bitmap
+// container, which is where the two use the same amount of memory.
+constexpr size_t ARRAY_MAX = 4096;
+
+// The number of 64 bit words in a bitmap container.
+constexpr size_t WORDS = (1 << 16) / 64;
+
+// The values of a 'RoaringBitmap' that share their upper 16 bits,
+// stored as one of:
+//
+//   ARRAY:  the sorted lower 16 bits of each value in 'values'.
+//   BITMAP: a bit per possible value in 'words'.
+//   RUN:    sorted, disjoint runs of values, each stored in 'values'
+//           as the first value followed by the length of the run
+//           minus 1.
+struct Container {
+  enum Type : uint8_t {
+    ARRAY = 0,
+    BITMAP = 1,
+    RUN = 2,
+  };
+
+  Type type = ARRAY;
+  uint32_t cardinality = 0;
+  std::vector<uint16_t> values;
+  std::vector<uint64_t> words;
+
+  bool contains(uint16_t value) const {
+    switch (type) {
+      case ARRAY:
+        return std::binary_search(values.begin(), values.end(), value);
+      case BITMAP:
+        return (words[value / 64] >> (value % 64)) & 1;
+      case RUN: {
+        // Find the last run that starts at or before 'value'.
+        size_t lower = 0, upper = values.size() / 2;
+        while (lower < upper) {
+          const size_t middle = (lower + upper) / 2;
+          if (values[2 * middle] <= value) {
+            lower = middle + 1;
+          } else {
+            upper = middle;
+          }
+        }
+        return lower > 0 &&
+          value - values[2 * (lower - 1)] <= values[2 * (lower - 1) + 1];
+      }
+    }
+    return false;
+  }
+
+  // Returns true if 'value' was added.
+  bool add(uint16_t value) {
+    if (type == RUN) {
+      if (contains(value)) {
+        return false;
+      }
+      materialize();
+    }
+
+    if (type == ARRAY) {
+      auto i = std::lower_bound(values.begin(), values.end(), value);
+      if (i != values.end() && *i == value) {
+        return false;
+      }
+      values.insert(i, value);
+      cardinality++;
+      if (cardinality > ARRAY_MAX) {
+        toBitmap();
+      }
+      return true;
+    }
+
+    uint64_t& word = words[value / 64];
+    const uint64_t bit = uint64_t(1) << (value % 64);
+    if (word & bit) {
+      return false;
+    }
+    word |= bit;
+    cardinality++;
+    return true;
+  }
+
+  // Returns true if 'value' was removed.
+  bool remove(uint16_t value) {
+    if (type == RUN) {
+      if (!contains(value)) {
+        return false;
+      }
+      materialize();
+    }
+
+    if (type == ARRAY) {
+      auto i = std::lower_bound(values.begin(), values.end(), value);
+      if (i == values.end() || *i != value) {
+        return false;
+      }
+      values.erase(i);
+      cardinality--;
+      return true;
+    }
+
+    uint64_t& word = words[value / 64];
+    const uint64_t bit = uint64_t(1) << (value % 64);
+    if (!(word & bit)) {
+      return false;
+    }
+    word &= ~bit;
+    cardinality--;
+    if (cardinality <= ARRAY_MAX) {
+      toArray();
+    }
+    return true;
+  }
+
+  // Calls 'f' with each value in increasing order.
+  template <typename F>
+  void each(F&& f) const {
+    switch (type) {
+      case ARRAY:
+        for (uint16_t value : values) {
+          f(value);
+        }
+        break;
+      case BITMAP:
+        for (size_t i = 0; i < WORDS; i++) {
+          for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+            f(static_cast<uint16_t>(i * 64 + bits::countTrailingZeros(word)));
+          }
+        }
+        break;
+      case RUN:
+        for (size_t i = 0; i < values.size(); i += 2) {
+          for (uint32_t value = values[i];
+               value <= uint32_t(values[i]) + values[i + 1];
+               value++) {
+            f(static_cast<uint16_t>(value));
+          }
+        }
+        break;
+    }
+  }
+
+  void toBitmap() {
+    std::vector<uint64_t> result(WORDS, 0);
+    each([&](uint16_t value) {
+      result[value / 64] |= uint64_t(1) << (value % 64);
+    });
+    words.swap(result);
+    values = std::vector<uint16_t>();
+    type = BITMAP;
+  }
+
+  void toArray() {
+    std::vector<uint16_t> result;
+    result.reserve(cardinality);
+    each([&](uint16_t value) {
+      result.push_back(value);
+    });
+    values.swap(result);
+    words = std::vector<uint64_t>();
+    type = ARRAY;
+  }
+
+  // Converts a run container to an array or bitmap container.
+  void materialize() {
+    if (type == RUN) {
+      if (cardinality <= ARRAY_MAX) {
+        toArray();
+      } else {
+        toBitmap();
+      }
+    }
+  }
+
+  // Converts to whichever type is smallest.
+  void optimize() {
+    // Count the runs.
+    size_t runs = 0;
+    int64_t previous = -2;
+    each([&](uint16_t value) {
+      if (value != previous + 1) {
+        runs++;
+      }
+      previous = value;
+    });
+
+    const size_t run = 4 * runs;
+    const size_t other = std::min<size_t>(2 * cardinality, WORDS * 8);
+
+    if (run < other) {
+      std::vector<uint16_t> result;
+      result.reserve(2 * runs);
+      each([&](uint16_t value) {
+        if (!result.empty() &&
+            uint32_t(result[result.size() - 2]) +
+              result[result.size() - 1] + 1 == value) {
+          result.back()++;
+        } else {
+          result.push_back(value);
+          result.push_back(0);
+        }
+      });
+      values.swap(result);
+      words = std::vector<uint64_t>();
+      type = RUN;
+    } else {
+      materialize();
+    }
+  }
+
+  // Sets the type and cardinality of a container whose 'words' were
+  // just computed.
+  void normalize() {
+    type = BITMAP;
+    cardinality = 0;
+    for (uint64_t word : words) {
+      cardinality += bits::popcount(word);
+    }
+    if (cardinality <= ARRAY_MAX) {
+      toArray();
+    }
+  }
+
+  size_t bytes() const {
+    return values.capacity() * sizeof(uint16_t) +
+      words.capacity() * sizeof(uint64_t);
+  }
+
+  bool operator==(const Container& that) const {
+    if (cardinality != that.cardinality) {
+      return false;
+    }
+    if (type == that.type) {
+      return values == that.values && words == that.words;
+    }
+    std::vector<uint16_t> left, right;
+    each([&](uint16_t value) { left.push_back(value); });
+    that.each([&](uint16_t value) { right.push_back(value); });
+    return left == right;
+  }
+};
+
+
+// Returns 'container' if it's not a run container, otherwise the
+// container materialized into 'scratch'.
+inline const Container& materialized(
+    const Container& container,
+    Container* scratch) {
+  if (container.type != Container::RUN) {
+    return container;
+  }
+  *scratch = container;
+  scratch->materialize();
+  return *scratch;
+}
+
+
+inline Container intersect(const Container& a_, const Container& b_) {
+  Container scratch1, scratch2;
+  const Container& a = materialized(a_, &scratch1);
+  const Container& b = materialized(b_, &scratch2);
+
+  Container result;
+
+  if (a.type == Container::BITMAP && b.type == Container::BITMAP) {
+    result.words.resize(WORDS);
+    for (size_t i = 0; i < WORDS; i++) {
+      result.words[i] = a.words[i] & b.words[i];
+    }
+    result.normalize();
+  } else if (a.type == Container::ARRAY && b.type == Container::ARRAY) {
+    std::set_intersection(
+        a.values.begin(),
+        a.values.end(),
+        b.values.begin(),
+        b.values.end(),
+        std::back_inserter(result.values));
+    result.cardinality = result.values.size();
+  } else {
+    const Container& array = a.type == Container::ARRAY ? a : b;
+    const Container& bitmap = a.type == Container::ARRAY ? b : a;
+    for (uint16_t value : array.values) {
+      if (bitmap.contains(value)) {
+        result.values.push_back(value);
+      }
+    }
+    result.cardinality = result.values.size();
+  }
+
+  return result;
+}
+
+
+inline Container unite(const Container& a_, const Container& b_) {
+  Container scratch1, scratch2;
+  const Container& a = materialized(a_, &scratch1);
+  const Container& b = materialized(b_, &scratch2);
+
+  Container result;
+
+  if (a.type == Container::ARRAY && b.type == Container::ARRAY) {
+    result.values.reserve(a.values.size() + b.values.size());
+    std::set_union(
+        a.values.begin(),
+        a.values.end(),
+        b.values.begin(),
+        b.values.end(),
+        std::back_inserter(result.values));
+    result.cardinality = result.values.size();
+    if (result.cardinality > ARRAY_MAX) {
+      result.toBitmap();
+    }
+  } else if (a.type == Container::BITMAP && b.type == Container::BITMAP) {
+    result.words.resize(WORDS);
+    for (size_t i = 0; i < WORDS; i++) {
+      result.words[i] = a.words[i] | b.words[i];
+    }
+    result.normalize();
+  } else {
+    const Container& array = a.type == Container::ARRAY ? a : b;
+    const Container& bitmap = a.type == Container::ARRAY ? b : a;
+    result = bitmap;
+    for (uint16_t value : array.values) {
+      result.add(value);
+    }
+  }
+
+  return result;
+}
+
+
+inline Container subtract(const Container& a_, const Container& b_) {
+  Container scratch1, scratch2;
+  const Container& a = materialized(a_, &scratch1);
+  const Container& b = materialized(b_, &scratch2);
+
+  Container result;
+
+  if (a.type == Container::ARRAY) {
+    for (uint16_t value : a.values) {
+      if (!b.contains(value)) {
+        result.values.push_back(value);
+      }
+    }
+    result.cardinality = result.values.size();
+  } else if (b.type == Container::BITMAP) {
+    result.words.resize(WORDS);
+    for (size_t i = 0; i < WORDS; i++) {
+      result.words[i] = a.words[i] & ~b.words[i];
+    }
+    result.normalize();
+  } else {
+    result = a;
+    for (uint16_t value : b.values) {
+      result.words[value / 64] &= ~(uint64_t(1) << (value % 64));
+    }
+    result.normalize();
+  }
+
+  return result;
+}
+
+} // namespace roaring {
+} // namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+// A compressed set of 32 bit unsigned integers (a "Roaring" bitmap).
+// Values are partitioned by their upper 16 bits into containers, each
+// of which is stored as a sorted array of the lower 16 bits when
+// sparse (at most 4096 values), as a bitmap of 8KB when dense, or,
+// after 'optimize()', as runs of consecutive values where that's
+// smaller still. This makes large sets of small integers (e.g., pids,
+// ports or task indexes) 10-100x smaller than as a 'std::set' or
+// 'hashset', and union, intersection and difference much faster: the
+// dense containers are combined a word at a time (in loops that the
+// compiler vectorizes) and the sparse ones with linear merges.
+class RoaringBitmap {
+  typedef internal::roaring::Container Container;
+
+ public:
+  class const_iterator;
+  typedef const_iterator iterator;
+
+  RoaringBitmap() {}
+
+  RoaringBitmap(std::initializer_list<uint32_t> values) {
+    for (uint32_t value : values) {
+      add(value);
+    }
+  }
+
+  template <typename Iterator>
+  RoaringBitmap(Iterator begin, Iterator end) {
+    for (; begin != end; ++begin) {
+      add(static_cast<uint32_t>(*begin));
+    }
+  }
+
+  // Parses a bitmap from the output of 'serialize'.
+  static Try<RoaringBitmap> parse(const std::string& data);
+
+  // Returns true if 'value' was added, i.e., it wasn't in the set.
+  bool add(uint32_t value) {
+    const uint16_t key = value >> 16;
+    auto i = std::lower_bound(keys.begin(), keys.end(), key);
+    const size_t index = i - keys.begin();
+    if (i == keys.end() || *i != key) {
+      keys.insert(i, key);
+      containers.insert(containers.begin() + index, Container());
+    }
+    return containers[index].add(static_cast<uint16_t>(value));
+  }
+
+  // Returns true if 'value' was removed, i.e., it was in the set.
+  bool remove(uint32_t value) {
+    const uint16_t key = value >> 16;
+    auto i = std::lower_bound(keys.begin(), keys.end(), key);
+    if (i == keys.end() || *i != key) {
+      return false;
+    }
+    const size_t index = i - keys.begin();
+    if (!containers[index].remove(static_cast<uint16_t>(value))) {
+      return false;
+    }
+    if (containers[index].cardinality == 0) {
+      keys.erase(i);
+      containers.erase(containers.begin() + index);
+    }
+    return true;
+  }
+
+  bool contains(uint32_t value) const {
+    const uint16_t key = value >> 16;
+    auto i = std::lower_bound(keys.begin(), keys.end(), key);
+    return i != keys.end() && *i == key &&
+      containers[i - keys.begin()].contains(static_cast<uint16_t>(value));
+  }
+
+  // Returns the number of values in the set.
+  uint64_t size() const {
+    uint64_t result = 0;
+    for (const Container& container : containers) {
+      result += container.cardinality;
+    }
+    return result;
+  }
+
+  bool empty() const {
+    return containers.empty();
+  }
+
+  void clear() {
+    keys.clear();
+    containers.clear();
+  }
+
+  // Converts each container into runs of consecutive values where
+  // that's smaller, e.g., for sets built from ranges. Call this once
+  // a set is built, since adding to or removing from a container of
+  // runs converts it back.
+  void optimize() {
+    for (Container& container : containers) {
+      container.optimize();
+    }
+  }
+
+  // Returns the memory used by the containers (excluding the object
+  // itself).
+  size_t bytes() const {
+    size_t result = keys.capacity() * sizeof(uint16_t) +
+      containers.capacity() * sizeof(Container);
+    for (const Container& container : containers) {
+      result += container.bytes();
+    }
+    return result;
+  }
+
+  // Returns the set in a compact (little endian) binary format that
+  // can be parsed with 'parse'.
+  std::string serialize() const;
+
+  RoaringBitmap& operator&=(const RoaringBitmap& that) {
+    *this = combine(*this, that, internal::roaring::intersect, false, false);
+    return *this;
+  }
+
+  RoaringBitmap& operator|=(const RoaringBitmap& that) {
+    *this = combine(*this, that, internal::roaring::unite, true, true);
+    return *this;
+  }
+
+  RoaringBitmap& operator-=(const RoaringBitmap& that) {
+    *this = combine(*this, that, internal::roaring::subtract, true, false);
+    return *this;
+  }
+
+  bool operator==(const RoaringBitmap& that) const {
+    return keys == that.keys && containers == that.containers;
+  }
+
+  bool operator!=(const RoaringBitmap& that) const {
+    return !(*this == that);
+  }
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  // Estimates the heap used by the containers, see stout/footprint.h.
+  friend size_t heapFootprint(const RoaringBitmap& bitmap) {
+    return bitmap.bytes();
+  }
+
+ private:
+  // Combines the containers of 'left' and 'right' with the same keys
+  // using 'f', and includes the containers with keys in only one of
+  // them if 'keepLeft' or 'keepRight'.
+  template <typename F>
+  static RoaringBitmap combine(
+      const RoaringBitmap& left,
+      const RoaringBitmap& right,
+      F&& f,
+      bool keepLeft,
+      bool keepRight) {
+    RoaringBitmap result;
+
+    size_t i = 0, j = 0;
+    while (i < left.keys.size() || j < right.keys.size()) {
+      if (j == right.keys.size() ||
+          (i < left.keys.size() && left.keys[i] < right.keys[j])) {
+        if (keepLeft) {
+          result.keys.push_back(left.keys[i]);
+          result.containers.push_back(left.containers[i]);
+        }
+        i++;
+      } else if (i == left.keys.size() || right.keys[j] < left.keys[i]) {
+        if (keepRight) {
+          result.keys.push_back(right.keys[j]);
+          result.containers.push_back(right.containers[j]);
+        }
+        j++;
+      } else {
+        Container container = f(left.containers[i], right.containers[j]);
+        if (container.cardinality > 0) {
+          result.keys.push_back(left.keys[i]);
+          result.containers.push_back(std::move(container));
+        }
+        i++;
+        j++;
+      }
+    }
+
+    return result;
+  }
+
+  // The upper 16 bits of the values in each container, sorted.
+  std::vector<uint16_t> keys;
+  std::vector<Container> containers;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Iterates the values of a 'RoaringBitmap' in increasing order.
+class RoaringBitmap::const_iterator {
+ public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef uint32_t value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef const uint32_t* pointer;
+  typedef const uint32_t& reference;
+
+  const_iterator() = default;
+
+  const uint32_t& operator*() const {
+    return value;
+  }
+
+  const_iterator& operator++() {
+    const Container& container = bitmap->containers[index];
+
+    switch (container.type) {
+      case Container::ARRAY:
+        if (++position < container.values.size()) {
+          set(container.values[position]);
+          return *this;
+        }
+        break;
+      case Container::BITMAP: {
+        // Look for the next set bit after the current one.
+        size_t bit = (value & 0xffff) + 1;
+        size_t word = bit / 64;
+        if (word < internal::roaring::WORDS) {
+          uint64_t bits = container.words[word] & (~uint64_t(0) << (bit % 64));
+          while (bits == 0 && ++word < internal::roaring::WORDS) {
+            bits = container.words[word];
+          }
+          if (bits != 0) {
+            set(word * 64 + bits::countTrailingZeros(bits));
+            return *this;
+          }
+        }
+        break;
+      }
+      case Container::RUN: {
+        const uint32_t low = value & 0xffff;
+        if (low < uint32_t(container.values[position]) +
+              container.values[position + 1]) {
+          set(low + 1);
+          return *this;
+        }
+        position += 2;
+        if (position < container.values.size()) {
+          set(container.values[position]);
+          return *this;
+        }
+        break;
+      }
+    }
+
+    index++;
+    first();
+    return *this;
+  }
+
+  const_iterator operator++(int) {
+    const_iterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  bool operator==(const const_iterator& that) const {
+    return bitmap == that.bitmap &&
+      index == that.index &&
+      (index == bitmap->containers.size() || value == that.value);
+  }
+
+  bool operator!=(const const_iterator& that) const {
+    return !(*this == that);
+  }
+
+ private:
+  friend class RoaringBitmap;
+
+  const_iterator(const RoaringBitmap* bitmap, size_t index)
+    : bitmap(bitmap), index(index) {
+    first();
+  }
+
+  // Moves to the first value of the container at 'index', if any.
+  void first() {
+    position = 0;
+    if (index >= bitmap->containers.size()) {
+      return;
+    }
+
+    const Container& container = bitmap->containers[index];
+    switch (container.type) {
+      case Container::ARRAY:
+      case Container::RUN:
+        set(container.values[0]);
+        break;
+      case Container::BITMAP:
+        for (size_t word = 0; word < internal::roaring::WORDS; word++) {
+          if (container.words[word] != 0) {
+            set(word * 64 + bits::countTrailingZeros(container.words[word]));
+            break;
+          }
+        }
+        break;
+    }
+  }
+
+  void set(uint32_t low) {
+    value = (uint32_t(bitmap->keys[index]) << 16) | low;
+  }
+
+  const RoaringBitmap* bitmap = nullptr;
+  size_t index = 0;
+
+  // The index into the 'values' of an array or run container.
+  size_t position = 0;
+
+  uint32_t value = 0;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+inline RoaringBitmap::const_iterator RoaringBitmap::begin() const {
+  return const_iterator(this, 0);
+}
+
+
+inline RoaringBitmap::const_iterator RoaringBitmap::end() const {
+  return const_iterator(this, containers.size());
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+namespace roaring {
+
+inline void encode(std::string* data, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; i++) {
+    data->push_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+
+inline uint64_t decode(const std::string& data, size_t offset, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; i++) {
+    value |= uint64_t(static_cast<unsigned char>(data[offset + i]))
+      << (8 * i);
+  }
+  return value;
+}
+
+inline constexpr char MAGIC[] = "STOUTRB1";
+
+} // namespace roaring {
+} // namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+// The format is the magic, the number of containers (4 bytes) and
+// then each container as its key (2 bytes), type (1 byte),
+// cardinality (4 bytes), the number of 'values' or 'words' (4 bytes)
+// and then those.
+inline std::string RoaringBitmap::serialize() const {
+  using internal::roaring::encode;
+
+  std::string data = internal::roaring::MAGIC;
+  data.reserve(data.size() + 4 + bytes());
+
+  encode(&data, keys.size(), 4);
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    const Container& container = containers[i];
+    encode(&data, keys[i], 2);
+    encode(&data, container.type, 1);
+    encode(&data, container.cardinality, 4);
+    if (container.type == Container::BITMAP) {
+      encode(&data, container.words.size(), 4);
+      for (uint64_t word : container.words) {
+        encode(&data, word, 8);
+      }
+    } else {
+      encode(&data, container.values.size(), 4);
+      for (uint16_t value : container.values) {
+        encode(&data, value, 2);
+      }
+    }
+  }
+
+  return data;
+}
+
+
+inline Try<RoaringBitmap> RoaringBitmap::parse(const std::string& data) {
+  using internal::roaring::decode;
+
+  const std::string magic = internal::roaring::MAGIC;
+
+  if (data.size() < magic.size() + 4 ||
+      data.compare(0, magic.size(), magic) != 0) {
+    return Error("Not a serialized RoaringBitmap");
+  }
+
+  size_t offset = magic.size();
+  const size_t count = decode(data, offset, 4);
+  offset += 4;
+
+  RoaringBitmap bitmap;
+
+  for (size_t i = 0; i < count; i++) {
+    if (data.size() - offset < 11) {
+      return Error("Truncated RoaringBitmap");
+    }
+
+    const uint16_t key = decode(data, offset, 2);
+    const uint8_t type = decode(data, offset + 2, 1);
+
+    Container container;
+    container.cardinality = decode(data, offset + 3, 4);
+    const size_t size = decode(data, offset + 7, 4);
+    offset += 11;
+
+    if (!bitmap.keys.empty() && key <= bitmap.keys.back()) {
+      return Error("RoaringBitmap containers are not sorted");
+    }
+
+    const size_t width = type == Container::BITMAP ? 8 : 2;
+
+    if ((data.size() - offset) / width < size) {
+      return Error("Truncated RoaringBitmap");
+    }
+
+    // Validate the sizes so that a corrupt container can't be used to
+    // read or write past the end of its values or words.
+    switch (type) {
+      case Container::ARRAY:
+        if (size == 0 ||
+            size != container.cardinality ||
+            size > internal::roaring::ARRAY_MAX) {
+          return Error("Invalid RoaringBitmap array container");
+        }
+        break;
+      case Container::BITMAP:
+        if (size != internal::roaring::WORDS ||
+            container.cardinality <= internal::roaring::ARRAY_MAX) {
+          return Error("Invalid RoaringBitmap bitmap container");
+        }
+        break;
+      case Container::RUN:
+        if (size == 0 || size % 2 != 0) {
+          return Error("Invalid RoaringBitmap run container");
+        }
+        break;
+      default:
+        return Error("Unknown RoaringBitmap container type");
+    }
+
+    container.type = static_cast<Container::Type>(type);
+
+    if (type == Container::BITMAP) {
+      container.words.resize(size);
+      for (uint64_t& word : container.words) {
+        word = decode(data, offset, 8);
+        offset += 8;
+      }
+    } else {
+      container.values.resize(size);
+      for (uint16_t& value : container.values) {
+        value = decode(data, offset, 2);
+        offset += 2;
+      }
+    }
+
+    // Validate the contents, since iteration relies on the values
+    // being sorted and the runs staying within the container, and
+    // 'size()' on the recorded cardinality.
+    switch (type) {
+      case Container::ARRAY:
+        for (size_t j = 1; j < size; j++) {
+          if (container.values[j - 1] >= container.values[j]) {
+            return Error("Invalid RoaringBitmap array container");
+          }
+        }
+        break;
+      case Container::BITMAP: {
+        uint64_t cardinality = 0;
+        for (uint64_t word : container.words) {
+          cardinality += bits::popcount(word);
+        }
+        if (cardinality != container.cardinality) {
+          return Error("Invalid RoaringBitmap bitmap container");
+        }
+        break;
+      }
+      case Container::RUN: {
+        uint64_t cardinality = 0;
+        for (size_t j = 0; j < size; j += 2) {
+          const uint32_t start = container.values[j];
+          const uint32_t last = start + container.values[j + 1];
+          if (last > 0xffff ||
+              (j > 0 &&
+               start <= uint32_t(container.values[j - 2]) +
+                 container.values[j - 1])) {
+            return Error("Invalid RoaringBitmap run container");
+          }
+          cardinality += last - start + 1;
+        }
+        if (cardinality != container.cardinality) {
+          return Error("Invalid RoaringBitmap run container");
+        }
+        break;
+      }
+    }
+
+    bitmap.keys.push_back(key);
+    bitmap.containers.push_back(std::move(container));
+  }
+
+  if (offset != data.size()) {
+    return Error("Unexpected data after RoaringBitmap");
+  }
+
+  return bitmap;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline RoaringBitmap operator&(
+    const RoaringBitmap& left,
+    const RoaringBitmap& right) {
+  RoaringBitmap result = left;
+  result &= right;
+  return result;
+}
+
+
+inline RoaringBitmap operator|(
+    const RoaringBitmap& left,
+    const RoaringBitmap& right) {
+  RoaringBitmap result = left;
+  result |= right;
+  return result;
+}
+
+
+inline RoaringBitmap operator-(
+    const RoaringBitmap& left,
+    const RoaringBitmap& right) {
+  RoaringBitmap result = left;
+  result -= right;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+inline std::ostream& operator<<(
+    std::ostream& stream,
+    const RoaringBitmap& bitmap) {
+  stream << "{ ";
+  bool first = true;
+  for (uint32_t value : bitmap) {
+    if (!first) {
+      stream << ", ";
+    }
+    stream << value;
+    first = false;
+  }
+  return stream << " }";
+}
+
+////////////////////////////////////////////////////////////////////////
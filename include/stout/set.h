@@ -13,6 +13,7 @@
 #pragma once
 
 #include <algorithm> // For std::set_intersection and std::set_difference.
+#include <iterator>
 #include <set>
 
 ////////////////////////////////////////////////////////////////////////
@@ -28,6 +29,14 @@ std::set<T> operator|(const std::set<T>& left, const std::set<T>& right) {
 
 ////////////////////////////////////////////////////////////////////////
 
+template <typename T>
+std::set<T>& operator|=(std::set<T>& left, const std::set<T>& right) {
+  left.insert(right.begin(), right.end());
+  return left;
+}
+
+////////////////////////////////////////////////////////////////////////
+
 template <typename T>
 std::set<T> operator+(const std::set<T>& left, const T& t) {
   std::set<T> result = left;
@@ -45,7 +54,7 @@ std::set<T> operator&(const std::set<T>& left, const std::set<T>& right) {
       left.end(),
       right.begin(),
       right.end(),
-      std::inserter(result, result.begin()));
+      std::inserter(result, result.end()));
   return result;
 }
 
@@ -59,8 +68,31 @@ std::set<T> operator-(const std::set<T>& left, const std::set<T>& right) {
       left.end(),
       right.begin(),
       right.end(),
-      std::inserter(result, result.begin()));
+      std::inserter(result, result.end()));
   return result;
 }
 
 ////////////////////////////////////////////////////////////////////////
+
+// Removes the elements of 'right' from 'left' in place, skipping over
+// the runs of either set that can't intersect with the other.
+template <typename T>
+std::set<T>& operator-=(std::set<T>& left, const std::set<T>& right) {
+  auto i = left.begin();
+  auto j = right.begin();
+
+  while (i != left.end() && j != right.end()) {
+    if (*i < *j) {
+      i = left.lower_bound(*j);
+    } else if (*j < *i) {
+      j = right.lower_bound(*i);
+    } else {
+      i = left.erase(i);
+      ++j;
+    }
+  }
+
+  return left;
+}
+
+////////////////////////////////////////////////////////////////////////
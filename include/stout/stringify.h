@@ -184,11 +184,11 @@ std::string stringify(const std::map<K, V>& map) {
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename T>
-std::string stringify(const hashset<T>& set) {
+template <typename T, typename Hash, typename Equal, typename Allocator>
+std::string stringify(const hashset<T, Hash, Equal, Allocator>& set) {
   std::ostringstream out;
   out << "{ ";
-  typename hashset<T>::const_iterator iterator = set.begin();
+  auto iterator = set.begin();
   while (iterator != set.end()) {
     out << stringify(*iterator);
     if (++iterator != set.end()) {
@@ -201,11 +201,16 @@ std::string stringify(const hashset<T>& set) {
 
 ////////////////////////////////////////////////////////////////////////
 
-template <typename K, typename V>
-std::string stringify(const hashmap<K, V>& map) {
+template <
+    typename K,
+    typename V,
+    typename Hash,
+    typename Equal,
+    typename Allocator>
+std::string stringify(const hashmap<K, V, Hash, Equal, Allocator>& map) {
   std::ostringstream out;
   out << "{ ";
-  typename hashmap<K, V>::const_iterator iterator = map.begin();
+  auto iterator = map.begin();
   while (iterator != map.end()) {
     out << stringify(iterator->first);
     out << ": ";
@@ -18,10 +18,18 @@
 #include <boost/uuid/string_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <chrono>
+#include <cstdint>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "stout/error.h"
+#include "stout/hash.h"
+#include "stout/none.h"
+#include "stout/option.h"
 #include "stout/try.h"
 
 #ifdef _WIN32
@@ -34,8 +42,59 @@ namespace id {
 
 ////////////////////////////////////////////////////////////////////////
 
+namespace internal {
+
+// Lookup tables for converting between bytes and hex digits.
+struct HexTables {
+  constexpr HexTables() : encode(), decode() {
+    constexpr char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 256; i++) {
+      encode[2 * i] = digits[i >> 4];
+      encode[2 * i + 1] = digits[i & 0xf];
+      decode[i] = -1;
+    }
+    for (int i = 0; i < 10; i++) {
+      decode['0' + i] = i;
+    }
+    for (int i = 0; i < 6; i++) {
+      decode['a' + i] = 10 + i;
+      decode['A' + i] = 10 + i;
+    }
+  }
+
+  // The two (lowercase) hex digits of each byte.
+  char encode[512];
+
+  // The value of each hex digit, or -1.
+  int8_t decode[256];
+};
+
+inline constexpr HexTables HEX = HexTables();
+
+
+// The state of a thread's time ordered UUIDs, see 'UUID::timeOrdered'.
+struct TimeOrderedState {
+  TimeOrderedState() : random(std::random_device()()) {}
+
+  std::mt19937_64 random;
+
+  // The timestamp (in milliseconds since the epoch) of the last UUID.
+  uint64_t timestamp = 0;
+
+  // The counter of the last UUID, see 'UUID::timeOrdered'.
+  uint64_t counter = 0;
+};
+
+} // namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
 struct UUID : boost::uuids::uuid {
  public:
+  // The length of a UUID in its canonical text form, e.g.,
+  // "0191d2b6-1f4e-7cc3-a3a4-5d2ab0e8e0f1".
+  static constexpr size_t STRING_SIZE = 36;
+
   static UUID random() {
     static thread_local boost::uuids::random_generator* generator = nullptr;
 
@@ -46,6 +105,76 @@ struct UUID : boost::uuids::uuid {
     return UUID((*generator)());
   }
 
+  // Returns 'count' random (version 4) UUIDs.
+  static std::vector<UUID> random(size_t count) {
+    std::vector<UUID> uuids;
+    uuids.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      uuids.push_back(random());
+    }
+    return uuids;
+  }
+
+  // Returns a time ordered (version 7, see RFC 9562) UUID, i.e., one
+  // that starts with the current time in milliseconds. Unlike random
+  // UUIDs these sort (both as bytes and as strings) in the order that
+  // they were created, so inserting them as keys into a B-tree or an
+  // LSM tree appends rather than touching random pages.
+  //
+  // The 42 bits after the timestamp are a counter that starts at a
+  // random value each millisecond and is incremented for each UUID
+  // created by the same thread within that millisecond, so UUIDs
+  // created by one thread are strictly increasing (even if the clock
+  // goes backwards). The last 32 bits are random.
+  static UUID timeOrdered() {
+    static thread_local internal::TimeOrderedState state;
+
+    const uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    constexpr uint64_t COUNTER_MAX = (uint64_t(1) << 42) - 1;
+
+    if (now > state.timestamp) {
+      state.timestamp = now;
+      // Leave the top bit clear so there's room to increment.
+      state.counter = state.random() & (COUNTER_MAX >> 1);
+    } else if (state.counter < COUNTER_MAX) {
+      state.counter++;
+    } else {
+      // The counter overflowed, borrow the next millisecond.
+      state.timestamp++;
+      state.counter = 0;
+    }
+
+    const uint64_t random = state.random();
+
+    boost::uuids::uuid uuid;
+
+    const uint64_t high = (state.timestamp << 16) |
+      (uint64_t(0x7) << 12) | (state.counter >> 30);
+
+    const uint64_t low = (uint64_t(0x2) << 62) |
+      ((state.counter & ((uint64_t(1) << 30) - 1)) << 32) |
+      (random & 0xffffffff);
+
+    for (int i = 0; i < 8; i++) {
+      uuid.data[i] = static_cast<uint8_t>(high >> (56 - 8 * i));
+      uuid.data[8 + i] = static_cast<uint8_t>(low >> (56 - 8 * i));
+    }
+
+    return UUID(uuid);
+  }
+
+  // Returns 'count' time ordered UUIDs, in increasing order.
+  static std::vector<UUID> timeOrdered(size_t count) {
+    std::vector<UUID> uuids;
+    uuids.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      uuids.push_back(timeOrdered());
+    }
+    return uuids;
+  }
+
   static Try<UUID> fromBytes(const std::string& s) {
     const std::string error = "Not a valid UUID";
 
@@ -56,14 +185,56 @@ struct UUID : boost::uuids::uuid {
     boost::uuids::uuid uuid;
     memcpy(&uuid, s.data(), s.size());
 
-    if (uuid.version() == UUID::version_unknown) {
+    // NOTE: Older versions of boost don't know about time ordered
+    // (version 7) UUIDs, see 'timeOrdered'.
+    if (uuid.version() == UUID::version_unknown && uuid.data[6] >> 4 != 7) {
       return Error(error);
     }
 
     return UUID(uuid);
   }
 
+  // Parses a UUID in its canonical form (or as 32 hex digits without
+  // the hyphens) without allocating or throwing, prefer this to
+  // 'fromString' when parsing many UUIDs.
+  static Option<UUID> fromChars(std::string_view s) {
+    boost::uuids::uuid uuid;
+
+    const bool hyphens = s.size() == STRING_SIZE;
+    if (!hyphens && s.size() != 2 * uuid.size()) {
+      return None();
+    }
+
+    size_t position = 0;
+    for (size_t i = 0; i < uuid.size(); i++) {
+      if (hyphens && (i == 4 || i == 6 || i == 8 || i == 10)) {
+        if (s[position++] != '-') {
+          return None();
+        }
+      }
+
+      const int high = internal::HEX.decode[static_cast<uint8_t>(s[position])];
+      const int low =
+        internal::HEX.decode[static_cast<uint8_t>(s[position + 1])];
+      if ((high | low) < 0) {
+        return None();
+      }
+
+      uuid.data[i] = static_cast<uint8_t>((high << 4) | low);
+      position += 2;
+    }
+
+    return UUID(uuid);
+  }
+
   static Try<UUID> fromString(const std::string& s) {
+    Option<UUID> uuid = fromChars(s);
+    if (uuid.isSome()) {
+      return uuid.get();
+    }
+
+    // Fall back to boost for the other forms it accepts, e.g., with
+    // braces, and for its error messages.
     try {
       // NOTE: We don't use `thread_local` for the `string_generator`
       // (unlike for the `random_generator` above), because it is cheap
@@ -81,8 +252,24 @@ struct UUID : boost::uuids::uuid {
     return std::string(reinterpret_cast<const char*>(data), sizeof(data));
   }
 
+  // Writes the canonical form of this UUID (exactly 'STRING_SIZE'
+  // characters, without a terminating null) to 'out', returning a
+  // pointer to the character after the last one written.
+  char* toChars(char* out) const {
+    for (size_t i = 0; i < size(); i++) {
+      if (i == 4 || i == 6 || i == 8 || i == 10) {
+        *out++ = '-';
+      }
+      *out++ = internal::HEX.encode[2 * data[i]];
+      *out++ = internal::HEX.encode[2 * data[i] + 1];
+    }
+    return out;
+  }
+
   std::string toString() const {
-    return to_string(*this);
+    std::string result(STRING_SIZE, '\0');
+    toChars(result.data());
+    return result;
   }
 
  private:
@@ -106,7 +293,7 @@ struct hash<id::UUID> {
   typedef id::UUID argument_type;
 
   result_type operator()(const argument_type& uuid) const {
-    return boost::uuids::hash_value(uuid);
+    return stout::hash::bytes(uuid.begin(), uuid.size());
   }
 };
 
@@ -0,0 +1,234 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+////////////////////////////////////////////////////////////////////////
+
+// Lazy "views" over the collections, e.g., 'hashmap::keys_view()',
+// that iterate the underlying collection in place rather than copying
+// the elements into a new collection. A view is only valid as long as
+// the iterators of the underlying collection are, i.e., don't insert
+// into or erase from a collection while using a view of it.
+
+////////////////////////////////////////////////////////////////////////
+
+namespace stout {
+
+////////////////////////////////////////////////////////////////////////
+
+// A pair of iterators that can be used in a range-based for loop (or
+// with 'foreach').
+template <typename Iterator>
+class IteratorRange {
+ public:
+  typedef Iterator iterator;
+  typedef Iterator const_iterator;
+
+  IteratorRange(Iterator _begin, Iterator _end)
+    : begin_(std::move(_begin)),
+      end_(std::move(_end)) {}
+
+  Iterator begin() const {
+    return begin_;
+  }
+
+  Iterator end() const {
+    return end_;
+  }
+
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+ private:
+  Iterator begin_;
+  Iterator end_;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+namespace internal {
+
+////////////////////////////////////////////////////////////////////////
+
+// Adapts an iterator over pairs (e.g., of a map) into an iterator over
+// just the first or second member of each pair, without copying.
+// 'Derived' provides 'project', see 'KeyIterator' and 'ValueIterator'.
+template <typename Iterator, typename Derived, typename Reference>
+class ProjectingIterator {
+ public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef typename std::remove_reference<Reference>::type value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef value_type* pointer;
+  typedef Reference reference;
+
+  ProjectingIterator() = default;
+
+  explicit ProjectingIterator(Iterator _iterator)
+    : iterator(std::move(_iterator)) {}
+
+  reference operator*() const {
+    return Derived::project(*iterator);
+  }
+
+  pointer operator->() const {
+    return &Derived::project(*iterator);
+  }
+
+  Derived& operator++() {
+    ++iterator;
+    return static_cast<Derived&>(*this);
+  }
+
+  Derived operator++(int) {
+    Derived result = static_cast<Derived&>(*this);
+    ++iterator;
+    return result;
+  }
+
+  bool operator==(const ProjectingIterator& that) const {
+    return iterator == that.iterator;
+  }
+
+  bool operator!=(const ProjectingIterator& that) const {
+    return iterator != that.iterator;
+  }
+
+ protected:
+  Iterator iterator;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace internal
+
+////////////////////////////////////////////////////////////////////////
+
+// Iterates over the keys of a map given an iterator over its entries.
+template <typename Iterator>
+class KeyIterator : public internal::ProjectingIterator<
+                        Iterator,
+                        KeyIterator<Iterator>,
+                        decltype((std::declval<Iterator>()->first))> {
+ public:
+  using internal::ProjectingIterator<
+      Iterator,
+      KeyIterator<Iterator>,
+      decltype((std::declval<Iterator>()->first))>::ProjectingIterator;
+
+  template <typename Entry>
+  static auto project(Entry& entry) -> decltype((entry.first)) {
+    return entry.first;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Iterates over the values of a map given an iterator over its entries.
+template <typename Iterator>
+class ValueIterator : public internal::ProjectingIterator<
+                          Iterator,
+                          ValueIterator<Iterator>,
+                          decltype((std::declval<Iterator>()->second))> {
+ public:
+  using internal::ProjectingIterator<
+      Iterator,
+      ValueIterator<Iterator>,
+      decltype((std::declval<Iterator>()->second))>::ProjectingIterator;
+
+  template <typename Entry>
+  static auto project(Entry& entry) -> decltype((entry.second)) {
+    return entry.second;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Iterates over the distinct keys of a multimap, which relies on all
+// entries for the same key being adjacent in iteration order (as is
+// the case for both 'std::multimap' and 'std::unordered_multimap').
+template <typename Iterator, typename Equal>
+class DistinctKeyIterator : public internal::ProjectingIterator<
+                                Iterator,
+                                DistinctKeyIterator<Iterator, Equal>,
+                                decltype((std::declval<Iterator>()->first))> {
+  typedef internal::ProjectingIterator<
+      Iterator,
+      DistinctKeyIterator<Iterator, Equal>,
+      decltype((std::declval<Iterator>()->first))>
+    Base;
+
+ public:
+  DistinctKeyIterator() = default;
+
+  DistinctKeyIterator(Iterator iterator, Iterator _end, Equal _equal)
+    : Base(std::move(iterator)),
+      end(std::move(_end)),
+      equal(std::move(_equal)) {}
+
+  template <typename Entry>
+  static auto project(Entry& entry) -> decltype((entry.first)) {
+    return entry.first;
+  }
+
+  DistinctKeyIterator& operator++() {
+    Iterator previous = Base::iterator;
+    do {
+      ++Base::iterator;
+    } while (Base::iterator != end &&
+             equal(previous->first, Base::iterator->first));
+    return *this;
+  }
+
+  DistinctKeyIterator operator++(int) {
+    DistinctKeyIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+ private:
+  Iterator end;
+  Equal equal;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename Iterator>
+IteratorRange<KeyIterator<Iterator>> keys_view(Iterator begin, Iterator end) {
+  return IteratorRange<KeyIterator<Iterator>>(
+      KeyIterator<Iterator>(std::move(begin)),
+      KeyIterator<Iterator>(std::move(end)));
+}
+
+////////////////////////////////////////////////////////////////////////
+
+template <typename Iterator>
+IteratorRange<ValueIterator<Iterator>> values_view(
+    Iterator begin,
+    Iterator end) {
+  return IteratorRange<ValueIterator<Iterator>>(
+      ValueIterator<Iterator>(std::move(begin)),
+      ValueIterator<Iterator>(std::move(end)));
+}
+
+////////////////////////////////////////////////////////////////////////
+
+} // namespace stout
+
+////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,221 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "stout/arena.h"
+#include "stout/foreach.h"
+#include "stout/gtest.h"
+#include "stout/hashmap.h"
+#include "stout/pmr.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+using std::string;
+
+
+// Counts the allocations passed on to the default resource.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocations = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    allocations++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& that) const noexcept override {
+    return this == &that;
+  }
+};
+
+
+TEST(ArenaTest, Hashmap) {
+  stout::Arena arena;
+
+  stout::pmr::hashmap<std::pmr::string, int> map(&arena);
+
+  map.put("a rather long key that does not fit in a small string", 1);
+  map.put("two", 2);
+
+  EXPECT_SOME_EQ(1, map.get("a rather long key that does not fit in a small"
+                            " string"));
+  EXPECT_SOME_EQ(2, map.get("two"));
+  EXPECT_NONE(map.get("three"));
+  EXPECT_TRUE(map.contains("two"));
+
+  EXPECT_EQ(&arena, map.get_allocator().resource());
+  EXPECT_EQ(&arena, map.begin()->first.get_allocator().resource());
+
+  EXPECT_LT(0u, arena.allocated().bytes());
+}
+
+
+TEST(ArenaTest, Collections) {
+  stout::Arena arena;
+
+  stout::pmr::hashset<int> set({1, 2, 3}, &arena);
+  EXPECT_EQ(3u, set.size());
+  EXPECT_TRUE(set.contains(2));
+  EXPECT_EQ(&arena, set.get_allocator().resource());
+
+  stout::pmr::hashset<int> other(&arena);
+  other.insert(3);
+  other.insert(4);
+
+  set |= other;
+  EXPECT_EQ(4u, set.size());
+
+  set -= other;
+  EXPECT_EQ(2u, set.size());
+  EXPECT_FALSE(set.contains(3));
+
+  stout::pmr::LinkedHashMap<string, int> linked(&arena);
+  linked["b"] = 2;
+  linked["a"] = 1;
+  EXPECT_EQ(std::vector<string>({"b", "a"}), linked.keys());
+  EXPECT_SOME_EQ(1, linked.get("a"));
+  EXPECT_EQ(1u, linked.erase("a"));
+  EXPECT_EQ(1u, linked.size());
+
+  stout::pmr::multihashmap<string, int> multi(&arena);
+  multi.put("a", 1);
+  multi.put("a", 2);
+  multi.put("b", 3);
+  EXPECT_EQ(2u, multi.get("a").size());
+  EXPECT_TRUE(multi.contains("a", 2));
+  EXPECT_TRUE(multi.remove("a", 1));
+  EXPECT_FALSE(multi.contains("a", 1));
+  EXPECT_EQ(&arena, multi.get_allocator().resource());
+}
+
+
+TEST(ArenaTest, Reset) {
+  CountingResource upstream;
+
+  stout::Arena arena(1024, &upstream);
+
+  {
+    stout::pmr::hashmap<int, int> map(&arena);
+    for (int i = 0; i < 1000; i++) {
+      map[i] = i;
+    }
+    EXPECT_EQ(1000u, map.size());
+  }
+
+  EXPECT_LT(0u, arena.allocated().bytes());
+
+  const size_t allocations = upstream.allocations;
+  EXPECT_LT(0u, allocations);
+
+  arena.reset();
+
+  EXPECT_EQ(Bytes(0), arena.allocated());
+
+  // The arena is usable again after a reset.
+  stout::pmr::hashmap<int, int> map(&arena);
+  map[1] = 1;
+  EXPECT_SOME_EQ(1, map.get(1));
+}
+
+
+TEST(ArenaTest, MonotonicBuffer) {
+  CountingResource upstream;
+
+  {
+    stout::MonotonicBuffer<16 * 1024> arena(&upstream);
+
+    stout::pmr::hashset<int> set(&arena);
+    for (int i = 0; i < 100; i++) {
+      set.insert(i);
+    }
+
+    EXPECT_EQ(100u, set.size());
+  }
+
+  // Everything fit in the inline buffer.
+  EXPECT_EQ(0u, upstream.allocations);
+
+  {
+    stout::MonotonicBuffer<64> arena(&upstream);
+
+    stout::pmr::hashset<int> set(&arena);
+    for (int i = 0; i < 100; i++) {
+      set.insert(i);
+    }
+
+    EXPECT_EQ(100u, set.size());
+  }
+
+  EXPECT_LT(0u, upstream.allocations);
+}
+
+
+// Compares building and dropping a small map per "request" with the
+// global allocator against doing the same in an arena that is reset
+// after every request.
+TEST(Arena_BENCHMARK_Test, Hashmap) {
+  const int requests = 100000;
+
+  std::vector<string> names;
+  std::vector<string> values;
+  for (int i = 0; i < 16; i++) {
+    names.push_back("header-name-" + stringify(i));
+    values.push_back("some longer header value " + stringify(i));
+  }
+
+  Stopwatch watch;
+  size_t size = 0;
+
+  watch.start();
+  for (int request = 0; request < requests; request++) {
+    hashmap<string, string> map;
+    for (int i = 0; i < 16; i++) {
+      map.put(names[i], values[i]);
+    }
+    size += map.size();
+  }
+  watch.stop();
+
+  std::cout << "hashmap took " << watch.elapsed() << std::endl;
+
+  stout::Arena arena(64 * 1024);
+
+  watch.start();
+  for (int request = 0; request < requests; request++) {
+    {
+      stout::pmr::hashmap<std::pmr::string, std::pmr::string> map(&arena);
+      for (int i = 0; i < 16; i++) {
+        map.emplace(names[i], values[i]);
+      }
+      size -= map.size();
+    }
+    arena.reset();
+  }
+  watch.stop();
+
+  std::cout << "stout::pmr::hashmap in an Arena took " << watch.elapsed()
+            << std::endl;
+
+  EXPECT_EQ(0u, size);
+}
@@ -0,0 +1,172 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "stout/bihashmap.h"
+#include "stout/foreach.h"
+#include "stout/gtest.h"
+#include "stout/hashmap.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+using std::string;
+
+
+TEST(BiHashMapTest, Put) {
+  BiHashMap<string, int> map;
+
+  map.put("one", 1);
+  map.put("two", 2);
+
+  EXPECT_EQ(2u, map.size());
+  EXPECT_FALSE(map.empty());
+
+  EXPECT_SOME_EQ(1, map.get("one"));
+  EXPECT_SOME_EQ("two", map.get_key(2));
+  EXPECT_NONE(map.get("three"));
+  EXPECT_NONE(map.get_key(3));
+
+  EXPECT_TRUE(map.contains("one"));
+  EXPECT_TRUE(map.contains_value(2));
+  EXPECT_FALSE(map.contains_value(3));
+
+  EXPECT_EQ(1, map.at("one"));
+  EXPECT_EQ("two", map.at_value(2));
+
+  // Rebinding a key removes its old value.
+  map.put("one", 11);
+  EXPECT_SOME_EQ(11, map.get("one"));
+  EXPECT_FALSE(map.contains_value(1));
+  EXPECT_EQ(2u, map.size());
+
+  // Rebinding a value removes its old key.
+  map.put("deux", 2);
+  EXPECT_SOME_EQ("deux", map.get_key(2));
+  EXPECT_FALSE(map.contains("two"));
+  EXPECT_EQ(2u, map.size());
+}
+
+
+TEST(BiHashMapTest, Erase) {
+  BiHashMap<string, int> map = {{"one", 1}, {"two", 2}, {"three", 3}};
+
+  EXPECT_EQ(1u, map.erase("one"));
+  EXPECT_EQ(0u, map.erase("one"));
+  EXPECT_FALSE(map.contains_value(1));
+
+  EXPECT_EQ(1u, map.erase_value(2));
+  EXPECT_EQ(0u, map.erase_value(2));
+  EXPECT_FALSE(map.contains("two"));
+
+  EXPECT_EQ(1u, map.size());
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_NONE(map.get_key(3));
+}
+
+
+TEST(BiHashMapTest, Copy) {
+  BiHashMap<string, string> map = {{"a", "x"}, {"b", "y"}};
+
+  BiHashMap<string, string> copy = map;
+  map.put("c", "x");
+
+  EXPECT_SOME_EQ("a", copy.get_key("x"));
+  EXPECT_SOME_EQ("c", map.get_key("x"));
+
+  copy = map;
+  EXPECT_SOME_EQ("c", copy.get_key("x"));
+  EXPECT_FALSE(copy.contains("a"));
+
+  BiHashMap<string, string> moved = std::move(copy);
+  EXPECT_SOME_EQ("b", moved.get_key("y"));
+  EXPECT_EQ(2u, moved.size());
+
+  // Lookups still work after rehashing.
+  for (int i = 0; i < 1000; i++) {
+    moved.put("key" + stringify(i), "value" + stringify(i));
+  }
+
+  EXPECT_SOME_EQ("b", moved.get_key("y"));
+  EXPECT_SOME_EQ("key500", moved.get_key("value500"));
+}
+
+
+TEST(BiHashMapTest, Iteration) {
+  BiHashMap<string, int> map = {{"one", 1}, {"two", 2}};
+
+  hashmap<string, int> entries;
+  foreachpair (const string& key, int value, map) {
+    entries[key] = value;
+  }
+
+  const hashmap<string, int> expected = {{"one", 1}, {"two", 2}};
+  EXPECT_EQ(expected, entries);
+
+  int sum = 0;
+  for (int value : map.values_view()) {
+    sum += value;
+  }
+
+  EXPECT_EQ(3, sum);
+  EXPECT_EQ(2u, map.keys().size());
+  EXPECT_EQ(2u, map.values().size());
+}
+
+
+// Compares looking up keys by value with 'hashmap::contains_value'
+// and a scan against 'BiHashMap::get_key'.
+TEST(BiHashMap_BENCHMARK_Test, GetKey) {
+  const int size = 10000;
+
+  hashmap<string, string> hashmap;
+  BiHashMap<string, string> bihashmap;
+  for (int i = 0; i < size; i++) {
+    hashmap.put("key" + stringify(i), "value" + stringify(i));
+    bihashmap.put("key" + stringify(i), "value" + stringify(i));
+  }
+
+  const int lookups = 1000;
+
+  size_t found = 0;
+  Stopwatch watch;
+
+  watch.start();
+  for (int i = 0; i < lookups; i++) {
+    const string value = "value" + stringify(i * 7);
+    foreachpair (const string& key, const string& v, hashmap) {
+      if (v == value) {
+        found += key.size();
+        break;
+      }
+    }
+  }
+  watch.stop();
+
+  std::cout << "Scanning a hashmap took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  for (int i = 0; i < lookups; i++) {
+    found -= bihashmap.get_key("value" + stringify(i * 7))->size();
+  }
+  watch.stop();
+
+  std::cout << "BiHashMap::get_key took " << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(0u, found);
+}
@@ -22,3 +22,18 @@ TEST(BitsTest, CountSetBits) {
   EXPECT_EQ(26, bits::countSetBits(0xfffffcf));
   EXPECT_EQ(32, bits::countSetBits(0xffffffff));
 }
+
+
+TEST(BitsTest, Popcount) {
+  EXPECT_EQ(0, bits::popcount(0));
+  EXPECT_EQ(6, bits::popcount(0xf3));
+  EXPECT_EQ(64, bits::popcount(0xffffffffffffffffULL));
+  EXPECT_EQ(33, bits::popcount(0x80000000ffffffffULL));
+}
+
+
+TEST(BitsTest, CountTrailingZeros) {
+  EXPECT_EQ(0, bits::countTrailingZeros(1));
+  EXPECT_EQ(4, bits::countTrailingZeros(0xf0));
+  EXPECT_EQ(63, bits::countTrailingZeros(0x8000000000000000ULL));
+}
@@ -0,0 +1,148 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "stout/bloomfilter.h"
+#include "stout/foreach.h"
+#include "stout/gtest.h"
+#include "stout/hashset.h"
+#include "stout/stopwatch.h"
+#include "stout/try.h"
+
+using std::string;
+using std::vector;
+
+
+TEST(BloomFilterTest, NoFalseNegatives) {
+  BloomFilter<string> filter(1000, 0.01);
+
+  for (int i = 0; i < 1000; i++) {
+    filter.add(std::to_string(i));
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(filter.mayContain(std::to_string(i))) << i;
+  }
+}
+
+
+TEST(BloomFilterTest, FalsePositiveRate) {
+  for (double rate : {0.1, 0.01, 0.001}) {
+    BloomFilter<int> filter(10000, rate);
+
+    for (int i = 0; i < 10000; i++) {
+      filter.add(i);
+    }
+
+    size_t positives = 0;
+    for (int i = 10000; i < 110000; i++) {
+      positives += filter.mayContain(i);
+    }
+
+    // Allow some slack since the rate is only an estimate.
+    EXPECT_LT(positives / 100000.0, rate * 1.5) << rate;
+  }
+}
+
+
+TEST(BloomFilterTest, InvalidFalsePositiveRate) {
+  EXPECT_DEATH(BloomFilter<int>(100, 0.0), "false positive rate");
+  EXPECT_DEATH(BloomFilter<int>(100, -0.5), "false positive rate");
+  EXPECT_DEATH(BloomFilter<int>(100, 1.0), "false positive rate");
+  EXPECT_DEATH(BloomFilter<int>(100, 1e-300), "too large");
+}
+
+
+TEST(BloomFilterTest, Serialization) {
+  BloomFilter<int> filter(100, 0.01);
+
+  for (int i = 0; i < 100; i += 2) {
+    filter.add(i);
+  }
+
+  const string data = filter.serialize();
+
+  Try<BloomFilter<int>> parsed = BloomFilter<int>::parse(data);
+  ASSERT_SOME(parsed);
+
+  EXPECT_EQ(filter.bytes(), parsed->bytes());
+  EXPECT_EQ(data, parsed->serialize());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(filter.mayContain(i), parsed->mayContain(i)) << i;
+  }
+
+  EXPECT_ERROR(BloomFilter<int>::parse(""));
+  EXPECT_ERROR(BloomFilter<int>::parse("not a filter at all"));
+  EXPECT_ERROR(BloomFilter<int>::parse(data.substr(0, data.size() - 1)));
+}
+
+
+// Compares a pre-check with the filter against a lookup in a large
+// 'hashset', for both present and absent keys.
+TEST(BloomFilter_BENCHMARK_Test, Hashset) {
+  const int count = 1000000;
+
+  hashset<string> set;
+  BloomFilter<string> filter(count, 0.01);
+
+  for (int i = 0; i < count; i++) {
+    set.insert(std::to_string(i));
+    filter.add(std::to_string(i));
+  }
+
+  std::cout << "BloomFilter of " << count << " elements uses "
+            << filter.bytes() << " bytes" << std::endl;
+
+  vector<string> keys;
+  for (int i = 0; i < count; i++) {
+    keys.push_back(std::to_string(i * 2));
+  }
+
+  Stopwatch watch;
+  size_t found = 0;
+
+  watch.start();
+  foreach (const string& key, keys) {
+    found += set.contains(key);
+  }
+  watch.stop();
+
+  std::cout << "hashset::contains took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  foreach (const string& key, keys) {
+    found -= filter.mayContain(key) && set.contains(key);
+  }
+  watch.stop();
+
+  std::cout << "BloomFilter::mayContain before hashset::contains took "
+            << watch.elapsed() << std::endl;
+
+  watch.start();
+  size_t positives = 0;
+  foreach (const string& key, keys) {
+    positives += filter.mayContain(key);
+  }
+  watch.stop();
+
+  std::cout << "BloomFilter::mayContain took " << watch.elapsed()
+            << std::endl;
+
+  EXPECT_EQ(0u, found);
+  EXPECT_LE(static_cast<size_t>(count / 2), positives);
+}
@@ -204,3 +204,34 @@ TEST(BoundedHashMapTest, ForeachMutate) {
   list<string> values = {"foo", "qux", "caz"};
   EXPECT_EQ(values, map.values());
 }
+
+
+TEST(BoundedHashMapTest, Stats) {
+  BoundedHashMap<string, int> map(2);
+  EXPECT_NONE(map.stats());
+
+  map.enableStats();
+
+  map.set("foo", 1);
+  map.set("bar", 2);
+
+  EXPECT_SOME_EQ(1, map.get("foo"));
+  EXPECT_TRUE(map.contains("bar"));
+  EXPECT_FALSE(map.contains("baz"));
+
+  // This should evict key "foo" even though it was the last one read.
+  map.set("baz", 3);
+  EXPECT_NONE(map.get("foo"));
+
+  Option<CacheStats> stats = map.stats();
+  ASSERT_SOME(stats);
+  EXPECT_EQ(2u, stats->hits);
+  EXPECT_EQ(2u, stats->misses);
+  EXPECT_EQ(3u, stats->inserts);
+  EXPECT_EQ(1u, stats->evictions);
+
+  // Key "foo" was inserted 2 insertions before its miss, a capacity
+  // of 3 would have held it.
+  EXPECT_DOUBLE_EQ(0.5, stats->estimateHitRate(2));
+  EXPECT_DOUBLE_EQ(0.75, stats->estimateHitRate(4));
+}
@@ -12,10 +12,19 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "stout/cache.h"
+#include "stout/cachestats-json.h"
+#include "stout/duration.h"
 #include "stout/gtest.h"
+#include "stout/notification.h"
+#include "stout/try.h"
 
 
 TEST(CacheTest, Insert) {
@@ -82,3 +91,234 @@ TEST(CacheTest, LRUEviction) {
   cache.put(7, "g");
   EXPECT_NONE(cache.get(5));
 }
+
+
+TEST(CacheTest, GetOrLoad) {
+  Cache<int, std::string> cache(2);
+
+  int loads = 0;
+  auto loader = [&]() -> Try<std::string> {
+    loads++;
+    return "a";
+  };
+
+  EXPECT_SOME_EQ("a", cache.GetOrLoad(1, loader));
+  EXPECT_EQ(1, loads);
+  EXPECT_SOME_EQ("a", cache.get(1));
+
+  // Subsequent calls hit the cache rather than invoking the loader.
+  EXPECT_SOME_EQ("a", cache.GetOrLoad(1, loader));
+  EXPECT_EQ(1, loads);
+}
+
+
+TEST(CacheTest, GetOrLoadCoalescesMisses) {
+  Cache<int, std::string> cache(2);
+
+  std::atomic<int> loads(0);
+  stout::Notification<bool> loading;
+  stout::Notification<bool> finish;
+
+  std::thread leader([&]() {
+    EXPECT_SOME_EQ(
+        "a",
+        cache.GetOrLoad(1, [&]() -> Try<std::string> {
+          loads++;
+          loading.Notify(true);
+          finish.Wait();
+          return "a";
+        }));
+  });
+
+  loading.Wait();
+
+  std::vector<std::thread> followers;
+  for (int i = 0; i < 4; i++) {
+    followers.emplace_back([&]() {
+      EXPECT_SOME_EQ(
+          "a",
+          cache.GetOrLoad(1, [&]() -> Try<std::string> {
+            loads++;
+            return "b";
+          }));
+    });
+  }
+
+  finish.Notify(true);
+
+  leader.join();
+  for (std::thread& follower : followers) {
+    follower.join();
+  }
+
+  // Followers that arrived after the load completed hit the cache,
+  // either way the loader only ran once.
+  EXPECT_EQ(1, loads.load());
+}
+
+
+TEST(CacheTest, GetOrLoadThrows) {
+  Cache<int, std::string> cache(2);
+
+  stout::Notification<bool> loading;
+  stout::Notification<bool> finish;
+
+  std::thread leader([&]() {
+    EXPECT_THROW(
+        cache.GetOrLoad(1, [&]() -> Try<std::string> {
+          loading.Notify(true);
+          finish.Wait();
+          throw std::runtime_error("failed");
+        }),
+        std::runtime_error);
+  });
+
+  loading.Wait();
+
+  // A waiter gets an error rather than blocking forever.
+  std::thread follower([&]() {
+    EXPECT_ERROR(cache.GetOrLoad(1, []() -> Try<std::string> {
+      return "b";
+    }));
+  });
+
+  // Give the follower a chance to start waiting.
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  finish.Notify(true);
+
+  leader.join();
+  follower.join();
+
+  // Later callers don't join the failed load.
+  EXPECT_SOME_EQ("c", cache.GetOrLoad(1, []() -> Try<std::string> {
+    return "c";
+  }));
+}
+
+
+TEST(CacheTest, GetOrLoadInvalidated) {
+  Cache<int, std::string> cache(2);
+
+  // A 'put' while loading is not overwritten by the load.
+  EXPECT_SOME_EQ("a", cache.GetOrLoad(1, [&]() -> Try<std::string> {
+    cache.put(1, "b");
+    return "a";
+  }));
+  EXPECT_SOME_EQ("b", cache.get(1));
+
+  // Nor is an 'erase' undone by it.
+  EXPECT_SOME_EQ("a", cache.GetOrLoad(2, [&]() -> Try<std::string> {
+    cache.erase(2);
+    return "a";
+  }));
+  EXPECT_NONE(cache.get(2));
+
+  // Nor is a failure remembered after a 'put'.
+  Cache<int, std::string> negative(2, Seconds(60));
+  EXPECT_ERROR(negative.GetOrLoad(1, [&]() -> Try<std::string> {
+    negative.put(1, "b");
+    return Error("failed");
+  }));
+  negative.erase(1);
+  EXPECT_SOME_EQ("c", negative.GetOrLoad(1, []() -> Try<std::string> {
+    return "c";
+  }));
+}
+
+
+TEST(CacheTest, GetOrLoadError) {
+  // Without an error TTL failures aren't remembered.
+  Cache<int, std::string> cache(2);
+
+  int loads = 0;
+  auto failing = [&]() -> Try<std::string> {
+    loads++;
+    return Error("failed");
+  };
+
+  EXPECT_ERROR(cache.GetOrLoad(1, failing));
+  EXPECT_ERROR(cache.GetOrLoad(1, failing));
+  EXPECT_EQ(2, loads);
+  EXPECT_EQ(0u, cache.size());
+}
+
+
+TEST(CacheTest, GetOrLoadNegativeCaching) {
+  Cache<int, std::string> cache(2, Milliseconds(50));
+
+  int loads = 0;
+  auto failing = [&]() -> Try<std::string> {
+    loads++;
+    return Error("failed");
+  };
+
+  Try<std::string> result = cache.GetOrLoad(1, failing);
+  ASSERT_ERROR(result);
+  EXPECT_EQ("failed", result.error());
+
+  // The failure is remembered until its TTL elapses.
+  result = cache.GetOrLoad(1, failing);
+  ASSERT_ERROR(result);
+  EXPECT_EQ("failed", result.error());
+  EXPECT_EQ(1, loads);
+  EXPECT_EQ(0u, cache.size());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  EXPECT_SOME_EQ(
+      "a",
+      cache.GetOrLoad(1, [&]() -> Try<std::string> {
+        loads++;
+        return "a";
+      }));
+  EXPECT_EQ(2, loads);
+
+  // An explicit 'put' replaces a remembered failure.
+  EXPECT_ERROR(cache.GetOrLoad(2, failing));
+  cache.put(2, "b");
+  EXPECT_SOME_EQ("b", cache.GetOrLoad(2, failing));
+  EXPECT_EQ(3, loads);
+}
+
+
+TEST(CacheTest, Stats) {
+  Cache<int, std::string> cache(2);
+  EXPECT_NONE(cache.stats());
+
+  cache.enableStats();
+
+  cache.put(1, "a");
+  cache.put(2, "b");
+  cache.get(1);
+  cache.get(3);
+
+  // Evicts '2', the least-recently used.
+  cache.put(3, "c");
+
+  Option<CacheStats> stats = cache.stats();
+  ASSERT_SOME(stats);
+  EXPECT_EQ(1u, stats->hits);
+  EXPECT_EQ(1u, stats->misses);
+  EXPECT_EQ(3u, stats->inserts);
+  EXPECT_EQ(1u, stats->evictions);
+  EXPECT_EQ(0u, stats->expirations);
+  EXPECT_DOUBLE_EQ(0.5, stats->hitRate());
+
+  // '2' was last used 3 uses ago, it would have been a hit with a
+  // capacity of 4 but not 2.
+  EXPECT_NONE(cache.get(2));
+
+  stats = cache.stats();
+  ASSERT_SOME(stats);
+  EXPECT_EQ(2u, stats->misses);
+  EXPECT_DOUBLE_EQ(1.0 / 3, stats->hitRate());
+  EXPECT_DOUBLE_EQ(1.0 / 3, stats->estimateHitRate(2));
+  EXPECT_DOUBLE_EQ(2.0 / 3, stats->estimateHitRate(4));
+
+  EXPECT_EQ(
+      "{\"hits\":1,\"misses\":2,\"inserts\":3,\"evictions\":1,"
+      "\"expirations\":0,\"hit_rate\":0.3333333333333333,"
+      "\"recency\":[0,1,1]}",
+      std::string(jsonify(stats.get())));
+}
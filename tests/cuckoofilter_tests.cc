@@ -0,0 +1,201 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "stout/cuckoofilter.h"
+#include "stout/foreach.h"
+#include "stout/gtest.h"
+#include "stout/hashset.h"
+#include "stout/stopwatch.h"
+#include "stout/try.h"
+
+using std::string;
+using std::vector;
+
+
+TEST(CuckooFilterTest, AddAndRemove) {
+  CuckooFilter<string> filter(1000);
+
+  EXPECT_TRUE(filter.empty());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(filter.add(std::to_string(i))) << i;
+  }
+
+  EXPECT_EQ(1000u, filter.size());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(filter.mayContain(std::to_string(i))) << i;
+  }
+
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_TRUE(filter.remove(std::to_string(i))) << i;
+  }
+
+  EXPECT_EQ(500u, filter.size());
+
+  // Removed elements are (mostly) gone but nothing else is.
+  size_t positives = 0;
+  for (int i = 0; i < 1000; i++) {
+    if (i % 2 == 0) {
+      positives += filter.mayContain(std::to_string(i));
+    } else {
+      EXPECT_TRUE(filter.mayContain(std::to_string(i))) << i;
+    }
+  }
+
+  EXPECT_GT(5u, positives);
+}
+
+
+TEST(CuckooFilterTest, FalsePositiveRate) {
+  CuckooFilter<int> filter(10000);
+
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_TRUE(filter.add(i));
+  }
+
+  size_t positives = 0;
+  for (int i = 10000; i < 1010000; i++) {
+    positives += filter.mayContain(i);
+  }
+
+  // Allow some slack since the rate is only a bound on average.
+  EXPECT_LT(positives / 1000000.0, 0.0002);
+}
+
+
+TEST(CuckooFilterTest, Full) {
+  CuckooFilter<int> filter(100);
+
+  // Keep adding until the filter is full, which must not lose any of
+  // the elements that were added before.
+  int added = 0;
+  while (filter.add(added)) {
+    added++;
+  }
+
+  EXPECT_LE(100, added);
+  EXPECT_EQ(static_cast<size_t>(added), filter.size());
+
+  for (int i = 0; i < added; i++) {
+    EXPECT_TRUE(filter.mayContain(i)) << i;
+  }
+
+  // Removing makes room again. Not every removal does, since the
+  // room may be in buckets that the fingerprints which didn't fit
+  // can't be relocated to.
+  for (int i = 0; i < added; i += 2) {
+    EXPECT_TRUE(filter.remove(i)) << i;
+  }
+
+  for (int i = 0; i < added; i += 2) {
+    EXPECT_TRUE(filter.add(i)) << i;
+  }
+
+  EXPECT_EQ(static_cast<size_t>(added), filter.size());
+
+  for (int i = 0; i < added; i++) {
+    EXPECT_TRUE(filter.mayContain(i)) << i;
+  }
+}
+
+
+TEST(CuckooFilterTest, Serialization) {
+  CuckooFilter<int> filter(100);
+
+  for (int i = 0; i < 100; i += 2) {
+    filter.add(i);
+  }
+
+  const string data = filter.serialize();
+
+  Try<CuckooFilter<int>> parsed = CuckooFilter<int>::parse(data);
+  ASSERT_SOME(parsed);
+
+  EXPECT_EQ(filter.size(), parsed->size());
+  EXPECT_EQ(filter.bytes(), parsed->bytes());
+  EXPECT_EQ(data, parsed->serialize());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(filter.mayContain(i), parsed->mayContain(i)) << i;
+  }
+
+  EXPECT_TRUE(parsed->remove(0));
+  EXPECT_FALSE(parsed->mayContain(0));
+
+  EXPECT_ERROR(CuckooFilter<int>::parse(""));
+  EXPECT_ERROR(CuckooFilter<int>::parse(data.substr(0, data.size() - 1)));
+
+  string corrupt = data;
+  corrupt[26] = 3; // Number of buckets, not a power of two.
+  EXPECT_ERROR(CuckooFilter<int>::parse(corrupt));
+}
+
+
+// Compares a pre-check with the filter against a lookup in a large
+// 'hashset', for both present and absent keys.
+TEST(CuckooFilter_BENCHMARK_Test, Hashset) {
+  const int count = 1000000;
+
+  hashset<string> set;
+  CuckooFilter<string> filter(count);
+
+  for (int i = 0; i < count; i++) {
+    set.insert(std::to_string(i));
+    ASSERT_TRUE(filter.add(std::to_string(i)));
+  }
+
+  std::cout << "CuckooFilter of " << count << " elements uses "
+            << filter.bytes() << " bytes" << std::endl;
+
+  vector<string> keys;
+  for (int i = 0; i < count; i++) {
+    keys.push_back(std::to_string(i * 2));
+  }
+
+  Stopwatch watch;
+  size_t found = 0;
+
+  watch.start();
+  foreach (const string& key, keys) {
+    found += set.contains(key);
+  }
+  watch.stop();
+
+  std::cout << "hashset::contains took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  foreach (const string& key, keys) {
+    found -= filter.mayContain(key) && set.contains(key);
+  }
+  watch.stop();
+
+  std::cout << "CuckooFilter::mayContain before hashset::contains took "
+            << watch.elapsed() << std::endl;
+
+  // Only the first half of the keys were added.
+  watch.start();
+  for (size_t i = 0; i < keys.size() / 2; i++) {
+    found += !filter.remove(keys[i]);
+  }
+  watch.stop();
+
+  std::cout << "CuckooFilter::remove took " << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(0u, found);
+}
@@ -0,0 +1,337 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "stout/flatintervalset.h"
+#include "stout/foreach.h"
+#include "stout/interval.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+using std::string;
+using std::vector;
+
+
+TEST(FlatIntervalSetTest, Addition) {
+  FlatIntervalSet<int> set;
+
+  set += 1;
+  set += 3;
+  set += 2;
+
+  EXPECT_TRUE(set.contains(1));
+  EXPECT_TRUE(set.contains(2));
+  EXPECT_TRUE(set.contains(3));
+  EXPECT_EQ(1u, set.intervalCount());
+  EXPECT_EQ(3u, set.size());
+
+  set += (Bound<int>::closed(5), Bound<int>::closed(6));
+
+  EXPECT_FALSE(set.contains(4));
+  EXPECT_TRUE(set.contains(5));
+  EXPECT_TRUE(set.contains(6));
+  EXPECT_EQ(2u, set.intervalCount());
+  EXPECT_EQ(5u, set.size());
+
+  set += (Bound<int>::open(2), Bound<int>::open(5));
+
+  EXPECT_TRUE(set.contains(4));
+  EXPECT_EQ(1u, set.intervalCount());
+  EXPECT_EQ(6u, set.size());
+
+  // Empty intervals are ignored.
+  set += (Bound<int>::closed(10), Bound<int>::open(10));
+
+  EXPECT_EQ(1u, set.intervalCount());
+
+  FlatIntervalSet<int> set2;
+
+  set2 += (Bound<int>::closed(8), Bound<int>::closed(9));
+  set2 += (Bound<int>::closed(11), Bound<int>::closed(12));
+
+  set += set2;
+
+  EXPECT_TRUE(set.contains(8));
+  EXPECT_TRUE(set.contains(9));
+  EXPECT_FALSE(set.contains(10));
+  EXPECT_EQ(3u, set.intervalCount());
+  EXPECT_EQ(10u, set.size());
+  EXPECT_EQ("{[1,7)[8,10)[11,13)}", stringify(set));
+}
+
+
+TEST(FlatIntervalSetTest, Subtraction) {
+  FlatIntervalSet<int> set(Bound<int>::closed(1), Bound<int>::closed(10));
+
+  set -= 5;
+
+  EXPECT_FALSE(set.contains(5));
+  EXPECT_EQ(2u, set.intervalCount());
+  EXPECT_EQ(9u, set.size());
+
+  set -= (Bound<int>::closed(2), Bound<int>::closed(8));
+
+  EXPECT_FALSE(set.contains(2));
+  EXPECT_FALSE(set.contains(8));
+  EXPECT_EQ(2u, set.intervalCount());
+  EXPECT_EQ(3u, set.size());
+
+  FlatIntervalSet<int> set2;
+
+  set2 += (Bound<int>::open(0), Bound<int>::open(2));
+  set2 += (Bound<int>::open(5), Bound<int>::closed(9));
+
+  set -= set2;
+
+  EXPECT_EQ("{[10,11)}", stringify(set));
+
+  set -= FlatIntervalSet<int>(Bound<int>::closed(0), Bound<int>::closed(20));
+
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(0u, set.intervalCount());
+}
+
+
+TEST(FlatIntervalSetTest, Intersection) {
+  FlatIntervalSet<int> set(Bound<int>::closed(1), Bound<int>::closed(3));
+
+  set &= (Bound<int>::open(1), Bound<int>::open(5));
+
+  EXPECT_FALSE(set.contains(1));
+  EXPECT_EQ(1u, set.intervalCount());
+  EXPECT_EQ(2u, set.size());
+
+  set += (Bound<int>::closed(6), Bound<int>::closed(10));
+
+  FlatIntervalSet<int> set2;
+
+  set2 += (Bound<int>::closed(0), Bound<int>::closed(2));
+  set2 += (Bound<int>::closed(4), Bound<int>::closed(7));
+  set2 += 9;
+
+  set &= set2;
+
+  EXPECT_EQ("{[2,3)[6,8)[9,10)}", stringify(set));
+
+  set &= FlatIntervalSet<int>(11);
+
+  EXPECT_TRUE(set.empty());
+}
+
+
+TEST(FlatIntervalSetTest, Contains) {
+  FlatIntervalSet<int> set(Bound<int>::closed(1), Bound<int>::closed(10));
+
+  EXPECT_TRUE(set.contains(1));
+  EXPECT_TRUE(set.contains(10));
+  EXPECT_FALSE(set.contains(11));
+  EXPECT_FALSE(set.contains(0));
+
+  EXPECT_TRUE(set.contains((Bound<int>::closed(2), Bound<int>::open(11))));
+  EXPECT_FALSE(set.contains((Bound<int>::closed(5), Bound<int>::closed(11))));
+  EXPECT_FALSE(set.contains((Bound<int>::open(0), Bound<int>::closed(20))));
+
+  FlatIntervalSet<int> set2(Bound<int>::open(4), Bound<int>::open(10));
+
+  EXPECT_TRUE(set.contains(set2));
+  EXPECT_FALSE(set2.contains(set));
+
+  FlatIntervalSet<int> set3;
+
+  EXPECT_TRUE(set.contains(set3));
+  EXPECT_FALSE(set3.contains(set2));
+
+  EXPECT_TRUE(set.intersects(set2));
+  EXPECT_FALSE(set.intersects(set3));
+  EXPECT_TRUE(set.intersects((Bound<int>::closed(10), Bound<int>::open(12))));
+  EXPECT_FALSE(set.intersects((Bound<int>::open(10), Bound<int>::open(12))));
+}
+
+
+TEST(FlatIntervalSetTest, IntervalIteration) {
+  FlatIntervalSet<int> set;
+
+  set += (Bound<int>::closed(5), Bound<int>::open(7));
+  set += (Bound<int>::closed(0), Bound<int>::closed(1));
+  set += (Bound<int>::open(7), Bound<int>::closed(9));
+  set += (Bound<int>::open(2), Bound<int>::open(4));
+
+  vector<int> bounds;
+  foreach (const Interval<int>& interval, set) {
+    bounds.push_back(interval.lower());
+    bounds.push_back(interval.upper());
+  }
+
+  EXPECT_EQ(vector<int>({0, 2, 3, 4, 5, 7, 8, 10}), bounds);
+}
+
+
+// Checks that random sequences of operations give the same results
+// as the boost backed 'IntervalSet'.
+TEST(FlatIntervalSetTest, MatchesIntervalSet) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> value(0, 200);
+
+  auto interval = [&]() {
+    const int lower = value(random);
+    const int upper = lower + 1 + value(random) / 8;
+    return (Bound<int>::closed(lower), Bound<int>::open(upper));
+  };
+
+  for (int round = 0; round < 100; round++) {
+    IntervalSet<int> expected;
+    FlatIntervalSet<int> actual;
+
+    IntervalSet<int> other;
+    for (int i = 0; i < 10; i++) {
+      other += interval();
+    }
+
+    for (int i = 0; i < 50; i++) {
+      switch (random() % 6) {
+        case 0: {
+          const Interval<int> next = interval();
+          expected += next;
+          actual += next;
+          break;
+        }
+        case 1: {
+          const Interval<int> next = interval();
+          expected -= next;
+          actual -= next;
+          break;
+        }
+        case 2: {
+          const int next = value(random);
+          expected += next;
+          actual += next;
+          break;
+        }
+        case 3: {
+          expected += other;
+          actual += FlatIntervalSet<int>(other);
+          break;
+        }
+        case 4: {
+          expected -= other;
+          actual -= FlatIntervalSet<int>(other);
+          break;
+        }
+        case 5: {
+          const Interval<int> next = interval();
+          EXPECT_EQ(expected.contains(next), actual.contains(next));
+          EXPECT_EQ(expected.intersects(next), actual.intersects(next));
+          break;
+        }
+      }
+
+      ASSERT_EQ(stringify(expected), stringify(actual));
+      ASSERT_EQ(expected.size(), actual.size());
+    }
+
+    IntervalSet<int> intersection = expected;
+    intersection &= other;
+
+    FlatIntervalSet<int> flatIntersection = actual;
+    flatIntersection &= FlatIntervalSet<int>(other);
+
+    EXPECT_EQ(stringify(intersection), stringify(flatIntersection));
+    EXPECT_EQ(
+        expected.contains(other),
+        actual.contains(FlatIntervalSet<int>(other)));
+    EXPECT_EQ(
+        expected.intersects(other),
+        actual.intersects(FlatIntervalSet<int>(other)));
+    EXPECT_EQ(expected, actual.toIntervalSet());
+  }
+}
+
+
+// Compares the time of common operations on sets of port ranges of
+// various sizes against the boost backed 'IntervalSet'.
+TEST(FlatIntervalSet_BENCHMARK_Test, IntervalSet) {
+  std::mt19937 random(42);
+
+  for (size_t count : {1u, 10u, 100u}) {
+    // Builds sets of 'count' disjoint ranges in [0, 65536).
+    auto ranges = [&]() {
+      const int stride = static_cast<int>(65536 / count);
+      vector<Interval<int>> result;
+      for (size_t i = 0; i < count; i++) {
+        const int lower =
+          static_cast<int>(i) * stride + random() % (stride / 2);
+        const int upper = lower + 1 + random() % (stride / 2);
+        result.push_back((Bound<int>::closed(lower), Bound<int>::open(upper)));
+      }
+      std::shuffle(result.begin(), result.end(), random);
+      return result;
+    };
+
+    const vector<Interval<int>> left = ranges();
+    const vector<Interval<int>> right = ranges();
+
+    const size_t iterations = 100000 / count;
+
+    Stopwatch watch;
+    size_t found = 0;
+
+    watch.start();
+    for (size_t i = 0; i < iterations; i++) {
+      IntervalSet<int> set;
+      foreach (const Interval<int>& interval, left) {
+        set += interval;
+      }
+      IntervalSet<int> other;
+      foreach (const Interval<int>& interval, right) {
+        other += interval;
+      }
+      set += other;
+      set -= other;
+      for (int port = 0; port < 65536; port += 1024) {
+        found += set.contains(port);
+      }
+    }
+    watch.stop();
+
+    std::cout << "IntervalSet with " << count << " intervals: "
+              << watch.elapsed() / iterations << std::endl;
+
+    watch.start();
+    for (size_t i = 0; i < iterations; i++) {
+      FlatIntervalSet<int> set;
+      foreach (const Interval<int>& interval, left) {
+        set += interval;
+      }
+      FlatIntervalSet<int> other;
+      foreach (const Interval<int>& interval, right) {
+        other += interval;
+      }
+      set += other;
+      set -= other;
+      for (int port = 0; port < 65536; port += 1024) {
+        found -= set.contains(port);
+      }
+    }
+    watch.stop();
+
+    std::cout << "FlatIntervalSet with " << count << " intervals: "
+              << watch.elapsed() / iterations << std::endl;
+
+    EXPECT_EQ(0u, found);
+  }
+}
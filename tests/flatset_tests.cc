@@ -0,0 +1,169 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "stout/flatset.h"
+#include "stout/set.h"
+#include "stout/stopwatch.h"
+
+using std::set;
+using std::string;
+using std::vector;
+
+
+// Returns a random set of 'size' integers less than 'max'.
+static set<int32_t> randomSet(size_t size, int32_t max, std::mt19937* random) {
+  std::uniform_int_distribution<int32_t> distribution(0, max - 1);
+  set<int32_t> result;
+  while (result.size() < size) {
+    result.insert(distribution(*random));
+  }
+  return result;
+}
+
+
+TEST(FlatSetTest, Basic) {
+  FlatSet<int> set = {3, 1, 2, 3};
+
+  EXPECT_EQ(3u, set.size());
+  EXPECT_EQ(vector<int>({1, 2, 3}), set.values());
+
+  EXPECT_TRUE(set.contains(2));
+  EXPECT_FALSE(set.contains(4));
+
+  EXPECT_TRUE(set.insert(0));
+  EXPECT_FALSE(set.insert(0));
+  EXPECT_EQ(vector<int>({0, 1, 2, 3}), set.values());
+
+  EXPECT_EQ(1u, set.erase(2));
+  EXPECT_EQ(0u, set.erase(2));
+  EXPECT_EQ(vector<int>({0, 1, 3}), set.values());
+
+  EXPECT_EQ(FlatSet<int>({0, 1, 3}), set);
+  EXPECT_EQ(FlatSet<int>(std::set<int>({0, 1, 3})), set);
+
+  set.clear();
+  EXPECT_TRUE(set.empty());
+}
+
+
+TEST(FlatSetTest, Operators) {
+  const FlatSet<string> left = {"a", "b", "c"};
+  const FlatSet<string> right = {"b", "c", "d"};
+
+  EXPECT_EQ(FlatSet<string>({"a", "b", "c", "d"}), left | right);
+  EXPECT_EQ(FlatSet<string>({"b", "c"}), left & right);
+  EXPECT_EQ(FlatSet<string>({"a"}), left - right);
+  EXPECT_EQ(FlatSet<string>({"a", "b", "c", "e"}), left + string("e"));
+
+  FlatSet<string> set = left;
+  set |= right;
+  EXPECT_EQ(FlatSet<string>({"a", "b", "c", "d"}), set);
+
+  set -= FlatSet<string>({"a", "d", "z"});
+  EXPECT_EQ(FlatSet<string>({"b", "c"}), set);
+
+  set &= FlatSet<string>({"c", "d"});
+  EXPECT_EQ(FlatSet<string>({"c"}), set);
+}
+
+
+// Checks the (SIMD, and skewed) intersections of integer sets against
+// 'std::set_intersection'.
+TEST(FlatSetTest, Intersection) {
+  std::mt19937 generator(42);
+
+  for (size_t left : {0, 1, 5, 100, 1000}) {
+    for (size_t right : {0, 3, 100, 1000, 50000}) {
+      const set<int32_t> a = randomSet(left, 100000, &generator);
+      const set<int32_t> b = randomSet(right, 100000, &generator);
+
+      const FlatSet<int32_t> expected = a & b;
+
+      EXPECT_EQ(expected, FlatSet<int32_t>(a) & FlatSet<int32_t>(b))
+        << left << " & " << right;
+
+      EXPECT_EQ(expected, FlatSet<int32_t>(b) & FlatSet<int32_t>(a))
+        << right << " & " << left;
+
+      FlatSet<uint32_t> c(vector<uint32_t>(a.begin(), a.end()));
+      c &= FlatSet<uint32_t>(vector<uint32_t>(b.begin(), b.end()));
+      EXPECT_EQ(expected.size(), c.size());
+    }
+  }
+
+  // Negative numbers are compared as signed.
+  EXPECT_EQ(
+      FlatSet<int32_t>({-5, -1, 7, 8}),
+      FlatSet<int32_t>({-9, -5, -3, -1, 0, 7, 8, 9}) &
+        FlatSet<int32_t>({-5, -2, -1, 1, 7, 8, 10, 11}));
+}
+
+
+TEST(SetTest, InPlace) {
+  set<int> left = {1, 2, 3, 4, 5};
+
+  left |= set<int>({5, 6});
+  EXPECT_EQ(set<int>({1, 2, 3, 4, 5, 6}), left);
+
+  left -= set<int>({0, 2, 3, 6, 7});
+  EXPECT_EQ(set<int>({1, 4, 5}), left);
+
+  left -= set<int>();
+  EXPECT_EQ(set<int>({1, 4, 5}), left);
+
+  EXPECT_EQ(set<int>({4}), left & set<int>({2, 4, 6}));
+  EXPECT_EQ(set<int>({1, 5}), left - set<int>({2, 4, 6}));
+}
+
+
+// Compares intersecting sets of pids as 'std::set's and 'FlatSet's.
+TEST(FlatSet_BENCHMARK_Test, Intersection) {
+  std::mt19937 generator(42);
+
+  const set<int32_t> a = randomSet(100000, 1 << 22, &generator);
+  const set<int32_t> b = randomSet(100000, 1 << 22, &generator);
+
+  const int rounds = 10;
+
+  size_t size = 0;
+  Stopwatch watch;
+
+  watch.start();
+  for (int round = 0; round < rounds; round++) {
+    size += (a & b).size();
+  }
+  watch.stop();
+
+  std::cout << "std::set took " << watch.elapsed() << std::endl;
+
+  const FlatSet<int32_t> fa = a;
+  const FlatSet<int32_t> fb = b;
+
+  watch.start();
+  for (int round = 0; round < rounds; round++) {
+    size -= (fa & fb).size();
+  }
+  watch.stop();
+
+  std::cout << "FlatSet took " << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(0u, size);
+}
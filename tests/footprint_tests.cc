@@ -0,0 +1,143 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "stout/boundedhashmap.h"
+#include "stout/cache.h"
+#include "stout/footprint.h"
+#include "stout/hashmap.h"
+#include "stout/json.h"
+#include "stout/linkedhashmap.h"
+#include "stout/option.h"
+
+using std::string;
+using std::vector;
+
+namespace footprint {
+
+struct Blob {
+  std::unique_ptr<char[]> data;
+  size_t size = 0;
+};
+
+
+size_t heapFootprint(const Blob& blob) {
+  return blob.size;
+}
+
+} // namespace footprint
+
+
+TEST(FootprintTest, Scalars) {
+  EXPECT_EQ(Bytes(sizeof(int)), stout::footprint(42));
+  EXPECT_EQ(0u, stout::heapFootprint(3.14));
+  EXPECT_EQ(0u, stout::heapFootprint(Option<int>::none()));
+}
+
+
+TEST(FootprintTest, Strings) {
+  // A short string is stored inline.
+  EXPECT_EQ(0u, stout::heapFootprint(string("short")));
+
+  const string s(1000, 'x');
+  EXPECT_LE(1000u, stout::heapFootprint(s));
+  EXPECT_EQ(sizeof(string) + stout::heapFootprint(s),
+            stout::footprint(s).bytes());
+}
+
+
+TEST(FootprintTest, Containers) {
+  vector<string> strings;
+  strings.reserve(10);
+  EXPECT_EQ(10 * sizeof(string), stout::heapFootprint(strings));
+
+  strings.push_back(string(100, 'x'));
+  EXPECT_LE(10 * sizeof(string) + 100, stout::heapFootprint(strings));
+
+  // Nested containers are counted recursively.
+  std::map<int, vector<int>> map;
+  map[1] = vector<int>(1000);
+  EXPECT_LE(1000 * sizeof(int), stout::heapFootprint(map));
+
+  std::list<int> list = {1, 2, 3};
+  EXPECT_LE(3 * sizeof(int), stout::heapFootprint(list));
+
+  // A 'hashmap' is counted as an 'std::unordered_map'.
+  hashmap<int, string> values;
+  const size_t empty = stout::heapFootprint(values);
+  for (int i = 0; i < 100; i++) {
+    values[i] = string(100, 'x');
+  }
+  EXPECT_LE(empty + 100 * 100, stout::heapFootprint(values));
+
+  Option<string> option = string(1000, 'x');
+  EXPECT_LE(1000u, stout::heapFootprint(option));
+
+  std::unique_ptr<vector<int>> pointer(new vector<int>(10));
+  EXPECT_EQ(sizeof(vector<int>) + 10 * sizeof(int),
+            stout::heapFootprint(pointer));
+}
+
+
+TEST(FootprintTest, Collections) {
+  LinkedHashMap<string, string> linked;
+  linked["key"] = string(1000, 'x');
+  EXPECT_LE(1000u, stout::heapFootprint(linked));
+
+  BoundedHashMap<string, string> bounded(10);
+  bounded.set("key", string(1000, 'x'));
+  EXPECT_LE(1000u, stout::heapFootprint(bounded));
+
+  Cache<int, string> cache(10);
+  cache.put(1, string(1000, 'x'));
+  cache.put(2, string(1000, 'x'));
+  EXPECT_LE(2000u, stout::heapFootprint(cache));
+}
+
+
+TEST(FootprintTest, JSON) {
+  JSON::Object object;
+  object.values["string"] = string(1000, 'x');
+  object.values["number"] = 42;
+
+  JSON::Array array;
+  array.values.push_back(string(1000, 'x'));
+  object.values["array"] = array;
+
+  const JSON::Value value = object;
+
+  EXPECT_LE(2000u, stout::heapFootprint(value));
+  EXPECT_LE(sizeof(JSON::Object) + stout::heapFootprint(object),
+            stout::heapFootprint(value));
+}
+
+
+TEST(FootprintTest, CustomOverload) {
+  footprint::Blob blob;
+  blob.data.reset(new char[1000]);
+  blob.size = 1000;
+
+  EXPECT_EQ(1000u, stout::heapFootprint(blob));
+
+  // Also when nested in other containers.
+  vector<footprint::Blob> blobs;
+  blobs.push_back(std::move(blob));
+  EXPECT_EQ(blobs.capacity() * sizeof(footprint::Blob) + 1000,
+            stout::heapFootprint(blobs));
+}
@@ -96,4 +96,40 @@ TEST(GzipTest, Decompressor) {
 
   ASSERT_EQ(s, decompressed);
 }
+
+TEST(GzipTest, Compressor) {
+  string s;
+  for (int i = 0; i < 10000; i++) {
+    s += "Lorem ipsum dolor sit amet " + std::to_string(i) + ", ";
+  }
+
+  gzip::Compressor compressor;
+
+  // Compress 1000 bytes at a time.
+  string compressed;
+  for (size_t i = 0; i < s.size(); i += 1000) {
+    Try<string> compressedChunk = compressor.compress(s.substr(i, 1000));
+    ASSERT_SOME(compressedChunk);
+    compressed += compressedChunk.get();
+  }
+
+  EXPECT_FALSE(compressor.finished());
+
+  Try<string> compressedChunk = compressor.finish();
+  ASSERT_SOME(compressedChunk);
+  compressed += compressedChunk.get();
+
+  EXPECT_TRUE(compressor.finished());
+  EXPECT_ERROR(compressor.compress(s));
+  EXPECT_ERROR(compressor.finish());
+
+  Try<string> decompressed = gzip::decompress(compressed);
+  ASSERT_SOME(decompressed);
+  ASSERT_EQ(s, decompressed.get());
+
+  // An empty stream.
+  gzip::Compressor empty;
+  compressed = empty.finish().get();
+  EXPECT_SOME_EQ("", gzip::decompress(compressed));
+}
 #endif // HAVE_LIBZ
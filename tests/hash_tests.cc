@@ -0,0 +1,242 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "stout/gtest.h"
+#include "stout/hash.h"
+#include "stout/hashmap.h"
+#include "stout/hashset.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+#include "stout/uuid.h"
+
+using std::string;
+using std::vector;
+
+
+enum class Color { RED, GREEN, BLUE };
+
+
+TEST(HashTest, Bytes) {
+  const string data(200, 'x');
+
+  // Every length is handled, and each length hashes differently
+  // (even though the bytes are all the same).
+  hashset<uint64_t> hashes;
+  for (size_t size = 0; size <= data.size(); size++) {
+    const uint64_t hash = stout::hash::bytes(data.data(), size);
+    EXPECT_EQ(hash, stout::hash::bytes(data.data(), size));
+    hashes.insert(hash);
+  }
+
+  EXPECT_EQ(data.size() + 1, hashes.size());
+
+  // A different seed gives a different hash.
+  EXPECT_NE(
+      stout::hash::bytes(data.data(), data.size(), 1),
+      stout::hash::bytes(data.data(), data.size(), 2));
+
+  // Every byte matters.
+  string other = data;
+  other[100] = 'y';
+  EXPECT_NE(
+      stout::hash::bytes(data.data(), data.size()),
+      stout::hash::bytes(other.data(), other.size()));
+}
+
+
+TEST(HashTest, Integers) {
+  EXPECT_EQ(stout::hash::integer(42), stout::hash::integer(42));
+  EXPECT_NE(stout::hash::integer(42), stout::hash::integer(43));
+  EXPECT_NE(stout::hash::integer(42, 1), stout::hash::integer(42, 2));
+
+  // The low bits are well distributed even for keys that are all
+  // multiples of a power of two.
+  hashset<uint64_t> buckets;
+  for (uint64_t i = 0; i < 1024; i++) {
+    buckets.insert(stout::hash::integer(i * 1024) % 64);
+  }
+
+  EXPECT_EQ(64u, buckets.size());
+}
+
+
+TEST(HashTest, Hash) {
+  EXPECT_EQ(stout::Hash<string>()("hello"), stout::Hash<string>()("hello"));
+
+  // All strings with the same contents hash the same.
+  EXPECT_EQ(
+      stout::Hash<string>()("hello"),
+      stout::Hash<std::string_view>()("hello"));
+
+  EXPECT_EQ(
+      stout::Hash<string>()("hello"),
+      stout::Hash<std::pmr::string>()("hello"));
+
+  EXPECT_EQ(
+      stout::Hash<Color>()(Color::GREEN),
+      stout::Hash<int>()(1));
+
+  // Other types use 'std::hash'.
+  const id::UUID uuid = id::UUID::random();
+  EXPECT_EQ(std::hash<id::UUID>()(uuid), stout::Hash<id::UUID>()(uuid));
+
+  // Which for 'id::UUID' is implemented with 'hash::bytes'.
+  EXPECT_EQ(
+      stout::hash::bytes(uuid.toBytes().data(), uuid.toBytes().size()),
+      std::hash<id::UUID>()(uuid));
+}
+
+
+TEST(HashTest, Collections) {
+  hashmap<Color, string> colors;
+  colors[Color::RED] = "red";
+  colors[Color::BLUE] = "blue";
+  EXPECT_SOME_EQ("blue", colors.get(Color::BLUE));
+  EXPECT_NONE(colors.get(Color::GREEN));
+
+  hashset<id::UUID> uuids;
+  const id::UUID uuid = id::UUID::random();
+  uuids.insert(uuid);
+  EXPECT_TRUE(uuids.contains(uuid));
+  EXPECT_FALSE(uuids.contains(id::UUID::random()));
+}
+
+
+// Compares the time to hash keys of various sizes with 'std::hash' and
+// with 'stout::Hash'.
+TEST(Hash_BENCHMARK_Test, Strings) {
+  for (size_t size : {8, 32, 128, 1024}) {
+    vector<string> keys;
+    for (int i = 0; i < 1000; i++) {
+      keys.push_back(string(size - 4, 'x') + stringify(1000 + i));
+    }
+
+    const int rounds = 100 * 1024 / size + 10;
+
+    size_t result = 0;
+    Stopwatch watch;
+
+    watch.start();
+    for (int round = 0; round < rounds; round++) {
+      for (const string& key : keys) {
+        result += std::hash<string>()(key);
+      }
+    }
+    watch.stop();
+
+    std::cout << "std::hash of " << keys.size() * rounds << " strings of "
+              << size << " bytes took " << watch.elapsed() << std::endl;
+
+    watch.start();
+    for (int round = 0; round < rounds; round++) {
+      for (const string& key : keys) {
+        result += stout::Hash<string>()(key);
+      }
+    }
+    watch.stop();
+
+    std::cout << "stout::Hash of " << keys.size() * rounds << " strings of "
+              << size << " bytes took " << watch.elapsed() << std::endl;
+
+    EXPECT_NE(0u, result);
+  }
+}
+
+
+TEST(Hash_BENCHMARK_Test, UUID) {
+  vector<id::UUID> uuids;
+  for (int i = 0; i < 1000; i++) {
+    uuids.push_back(id::UUID::random());
+  }
+
+  const int rounds = 1000;
+
+  size_t result = 0;
+  Stopwatch watch;
+
+  watch.start();
+  for (int round = 0; round < rounds; round++) {
+    for (const id::UUID& uuid : uuids) {
+      result += boost::uuids::hash_value(uuid);
+    }
+  }
+  watch.stop();
+
+  std::cout << "boost::uuids::hash_value took " << watch.elapsed()
+            << std::endl;
+
+  watch.start();
+  for (int round = 0; round < rounds; round++) {
+    for (const id::UUID& uuid : uuids) {
+      result += std::hash<id::UUID>()(uuid);
+    }
+  }
+  watch.stop();
+
+  std::cout << "std::hash<id::UUID> took " << watch.elapsed() << std::endl;
+
+  EXPECT_NE(0u, result);
+}
+
+
+// Lookups of sequential integer keys in a 'hashmap' with the identity
+// hash (the default, unless seeded) and with 'hash::integer'.
+TEST(Hash_BENCHMARK_Test, Hashmap) {
+  const uint64_t size = 1000000;
+
+  struct Mixed {
+    size_t operator()(uint64_t i) const {
+      return stout::hash::integer(i);
+    }
+  };
+
+  hashmap<uint64_t, uint64_t> identity;
+  hashmap<uint64_t, uint64_t, Mixed> mixed;
+  for (uint64_t i = 0; i < size; i++) {
+    identity[i * 64] = i;
+    mixed[i * 64] = i;
+  }
+
+  uint64_t result = 0;
+  Stopwatch watch;
+
+  watch.start();
+  for (uint64_t i = 0; i < size; i++) {
+    result += identity.at(i * 64);
+  }
+  watch.stop();
+
+  std::cout << "hashmap with the identity hash took " << watch.elapsed()
+            << std::endl;
+
+  watch.start();
+  for (uint64_t i = 0; i < size; i++) {
+    result -= mixed.at(i * 64);
+  }
+  watch.stop();
+
+  std::cout << "hashmap with hash::integer took " << watch.elapsed()
+            << std::endl;
+
+  EXPECT_EQ(0u, result);
+}
@@ -15,13 +15,17 @@
 #include <gtest/gtest.h>
 
 #include <boost/functional/hash.hpp>
+#include <iostream>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "stout/gtest.h"
 #include "stout/hashmap.h"
+#include "stout/stopwatch.h"
 
 using std::string;
+using std::vector;
 
 
 TEST(HashMapTest, InitializerList) {
@@ -94,6 +98,82 @@ TEST(HashMapTest, Contains) {
 }
 
 
+TEST(HashMapTest, Views) {
+  hashmap<string, int> map;
+
+  EXPECT_TRUE(map.keys_view().empty());
+  EXPECT_TRUE(map.values_view().empty());
+
+  map["abc"] = 1;
+  map["def"] = 2;
+
+  vector<string> keys;
+  foreach (const string& key, map.keys_view()) {
+    keys.push_back(key);
+  }
+
+  EXPECT_THAT(keys, ::testing::UnorderedElementsAre("abc", "def"));
+
+  // Values can be updated in place through a non-const view.
+  foreach (int& value, map.values_view()) {
+    value *= 10;
+  }
+
+  const hashmap<string, int>& constMap = map;
+
+  vector<int> values;
+  foreach (const int& value, constMap.values_view()) {
+    values.push_back(value);
+  }
+
+  EXPECT_THAT(values, ::testing::UnorderedElementsAre(10, 20));
+
+  // The views iterate the map rather than a copy of it.
+  EXPECT_EQ(&map.begin()->first, &*map.keys_view().begin());
+  EXPECT_EQ(&map.begin()->second, &*map.values_view().begin());
+}
+
+
+// Compares iterating the keys and values of a large map via the views
+// against the copying 'keys()' and 'values()'.
+TEST(HashMap_BENCHMARK_Test, Views) {
+  hashmap<string, int> map;
+  for (int i = 0; i < 1000000; i++) {
+    map[std::to_string(i)] = i;
+  }
+
+  Stopwatch watch;
+  size_t size = 0;
+  long long sum = 0;
+
+  watch.start();
+  foreach (const string& key, map.keys()) {
+    size += key.size();
+  }
+  foreach (int value, map.values()) {
+    sum += value;
+  }
+  watch.stop();
+
+  std::cout << "keys() and values() took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  foreach (const string& key, map.keys_view()) {
+    size -= key.size();
+  }
+  foreach (int value, map.values_view()) {
+    sum -= value;
+  }
+  watch.stop();
+
+  std::cout << "keys_view() and values_view() took " << watch.elapsed()
+            << std::endl;
+
+  EXPECT_EQ(0u, size);
+  EXPECT_EQ(0, sum);
+}
+
+
 TEST(HashMapTest, CustomHashAndEqual) {
   struct CaseInsensitiveHash {
     size_t operator()(const string& key) const {
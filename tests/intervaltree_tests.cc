@@ -0,0 +1,141 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "stout/interval.h"
+#include "stout/intervaltree.h"
+
+using std::string;
+using std::vector;
+
+
+TEST(IntervalTreeTest, Empty) {
+  IntervalTree<int, string> tree;
+
+  EXPECT_TRUE(tree.empty());
+  EXPECT_TRUE(tree.containing(0).empty());
+  EXPECT_TRUE(
+      tree.overlapping((Bound<int>::closed(0), Bound<int>::closed(10)))
+        .empty());
+}
+
+
+TEST(IntervalTreeTest, Containing) {
+  IntervalTree<int, string> tree({
+      {(Bound<int>::closed(0), Bound<int>::closed(100)), "all"},
+      {(Bound<int>::closed(10), Bound<int>::open(20)), "a"},
+      {(Bound<int>::closed(15), Bound<int>::open(30)), "b"},
+      {(Bound<int>::closed(50), Bound<int>::open(60)), "c"},
+      {(Bound<int>::closed(70), Bound<int>::open(70)), "empty"},
+  });
+
+  // The empty interval is dropped.
+  EXPECT_EQ(4u, tree.size());
+
+  EXPECT_EQ(vector<string>({"all"}), tree.containing(0));
+  EXPECT_EQ(vector<string>({"all", "a"}), tree.containing(10));
+  EXPECT_EQ(vector<string>({"all", "a", "b"}), tree.containing(15));
+  EXPECT_EQ(vector<string>({"all", "b"}), tree.containing(20));
+  EXPECT_EQ(vector<string>({"all"}), tree.containing(30));
+  EXPECT_EQ(vector<string>({"all", "c"}), tree.containing(59));
+  EXPECT_EQ(vector<string>({"all"}), tree.containing(70));
+  EXPECT_TRUE(tree.containing(101).empty());
+  EXPECT_TRUE(tree.containing(-1).empty());
+}
+
+
+TEST(IntervalTreeTest, Overlapping) {
+  IntervalTree<int, string> tree({
+      {(Bound<int>::closed(10), Bound<int>::open(20)), "a"},
+      {(Bound<int>::closed(15), Bound<int>::open(30)), "b"},
+      {(Bound<int>::closed(50), Bound<int>::open(60)), "c"},
+  });
+
+  EXPECT_EQ(
+      vector<string>({"a", "b"}),
+      tree.overlapping((Bound<int>::closed(0), Bound<int>::closed(15))));
+
+  EXPECT_EQ(
+      vector<string>({"b"}),
+      tree.overlapping((Bound<int>::closed(20), Bound<int>::open(50))));
+
+  EXPECT_EQ(
+      vector<string>({"b", "c"}),
+      tree.overlapping((Bound<int>::closed(20), Bound<int>::closed(50))));
+
+  EXPECT_TRUE(
+      tree.overlapping((Bound<int>::closed(30), Bound<int>::open(50)))
+        .empty());
+
+  // Empty intervals never overlap.
+  EXPECT_TRUE(
+      tree.overlapping((Bound<int>::closed(15), Bound<int>::open(15)))
+        .empty());
+}
+
+
+// Checks queries against a brute force scan of the entries.
+TEST(IntervalTreeTest, MatchesScan) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> value(0, 1000);
+
+  vector<std::pair<Interval<int>, int>> entries;
+  for (int i = 0; i < 500; i++) {
+    const int lower = value(random);
+    const int upper = lower + 1 + value(random) / 20;
+    entries.emplace_back(
+        (Bound<int>::closed(lower), Bound<int>::open(upper)),
+        i);
+  }
+
+  const IntervalTree<int, int> tree(entries);
+
+  for (int point = -1; point <= 1100; point++) {
+    vector<int> expected;
+    for (const auto& entry : entries) {
+      if (entry.first.lower() <= point && point < entry.first.upper()) {
+        expected.push_back(entry.second);
+      }
+    }
+
+    vector<int> actual = tree.containing(point);
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    ASSERT_EQ(expected, actual) << point;
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    const int lower = value(random);
+    const int upper = lower + 1 + value(random) / 10;
+
+    vector<int> expected;
+    for (const auto& entry : entries) {
+      if (entry.first.lower() < upper && lower < entry.first.upper()) {
+        expected.push_back(entry.second);
+      }
+    }
+
+    vector<int> actual =
+      tree.overlapping((Bound<int>::closed(lower), Bound<int>::open(upper)));
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    ASSERT_EQ(expected, actual) << lower << " " << upper;
+  }
+}
@@ -15,18 +15,177 @@
 #include <stdint.h>
 #include <sys/stat.h>
 
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
 #include <string>
+#include <vector>
+
+// NOTE: PicoJson requires `__STDC_FORMAT_MACROS` before importing
+// <inttypes.h>, which may already have been imported, and we need
+// `PICOJSON_USE_INT64` for `picojson::value::get<uint64_t>()`.
+#undef __STDC_FORMAT_MACROS
+#define PICOJSON_USE_INT64
+#include <picojson.h>
+#define __STDC_FORMAT_MACROS
 
 #include "fmt/format.h"
 #include "stout/gtest.h"
 #include "stout/json.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
 #include "stout/strings.h"
 
 using std::string;
+using std::vector;
 
 using boost::get;
 
 
+// Our implementation of picojson's parsing context that allows
+// us to parse directly into our JSON::Value.
+//
+// https://github.com/kazuho/picojson/blob/v1.3.0/picojson.h#L820-L870
+class ParseContext {
+ public:
+  ParseContext(
+      JSON::Value* _value,
+      size_t _depth = JSON::internal::STOUT_JSON_MAX_DEPTH)
+    : value(_value),
+      depth(_depth) {}
+
+  ParseContext(const ParseContext&) = delete;
+  ParseContext& operator=(const ParseContext&) = delete;
+
+  bool set_null() {
+    *value = JSON::Null();
+    return true;
+  }
+  bool set_bool(bool b) {
+    *value = JSON::Boolean(b);
+    return true;
+  }
+  bool set_int64(int64_t i) {
+    *value = JSON::Number(i);
+    return true;
+  }
+
+  bool set_number(double f) {
+    // We take a trip through picojson::value here because it
+    // is where the validation takes place (i.e. it throws):
+    //   https://github.com/kazuho/picojson/issues/94
+    //   https://github.com/kazuho/picojson/blob/v1.3.0/picojson.h#L195-L208
+    picojson::value v(f);
+    *value = JSON::Number(v.get<double>());
+    return true;
+  }
+
+  template <typename Iter>
+  bool parse_string(picojson::input<Iter>& in) {
+    *value = JSON::String();
+    return picojson::_parse_string(value->as<JSON::String>().value, in);
+  }
+
+  bool parse_array_start() {
+    if (depth <= 0) {
+      return false;
+    }
+    --depth;
+    *value = JSON::Array();
+    return true;
+  }
+
+  template <typename Iter>
+  bool parse_array_item(picojson::input<Iter>& in, size_t) {
+    JSON::Array& array = value->as<JSON::Array>();
+    array.values.push_back(JSON::Value());
+    ParseContext context(&array.values.back(), depth);
+    return picojson::_parse(context, in);
+  }
+
+  bool parse_array_stop(size_t) {
+    ++depth;
+    return true;
+  }
+
+  bool parse_object_start() {
+    if (depth <= 0) {
+      return false;
+    }
+    --depth;
+    *value = JSON::Object();
+    return true;
+  }
+
+  template <typename Iter>
+  bool parse_object_item(picojson::input<Iter>& in, const std::string& key) {
+    JSON::Object& object = value->as<JSON::Object>();
+    ParseContext context(&object.values[key], depth);
+    return picojson::_parse(context, in);
+  }
+
+  bool parse_object_stop() {
+    ++depth;
+    return true;
+  }
+
+  JSON::Value* value;
+  size_t depth;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+// Parses with picojson, a byte at a time. This was the implementation
+// of 'JSON::parse' before the structural index parser, and is kept to
+// check that the two accept (and produce) the same.
+static Try<JSON::Value> picojsonParse(const std::string& s) {
+  const char* parseBegin = s.c_str();
+  JSON::Value value;
+  std::string error;
+
+  // Because PicoJson supports repeated parsing of multiple objects/arrays in a
+  // stream, it will quietly ignore trailing non-whitespace characters. We
+  // would rather throw an error, however, so use `last_char` to check for
+  // this.
+  //
+  // TODO(alexr): Address cases when `s` is empty or consists only of
+  // whitespace characters.
+  const char* lastVisibleChar =
+      parseBegin + s.find_last_not_of(strings::WHITESPACE);
+
+  // Parse the string, returning a pointer to the character immediately
+  // following the last one parsed. Convert exceptions to `Error`s.
+  //
+  // TODO(alexr): Remove `try-catch` wrapper once picojson stops throwing
+  // on parsing, see https://github.com/kazuho/picojson/issues/94
+  const char* parseEnd;
+  try {
+    ParseContext context(&value);
+    parseEnd =
+        picojson::_parse(context, parseBegin, parseBegin + s.size(), &error);
+  } catch (const std::overflow_error&) {
+    return Error("Value out of range");
+  } catch (...) {
+    return Error("Unknown JSON parse error");
+  }
+
+  if (!error.empty()) {
+    return Error(error);
+  } else if (parseEnd != lastVisibleChar + 1) {
+    return Error(
+        "Parsed JSON included non-whitespace trailing characters: "
+        + s.substr(parseEnd - parseBegin, lastVisibleChar + 1 - parseEnd));
+  }
+
+  // TODO(bmahler): Newer compilers (clang-3.9 and gcc-5.1) can
+  // perform a move into the resultant Try with optimization on.
+  // Consider removing the `std::move` when we require these
+  // compilers.
+  return std::move(value);
+}
+
+
 TEST(JsonTest, DefaultValueIsNull) {
   JSON::Value v;
   EXPECT_EQ("null", fmt::format("{}", v));
@@ -73,6 +232,87 @@ TEST(JsonTest, NumberFormat) {
   EXPECT_EQ(
       "1234567890.12345",
       fmt::format("{}", JSON::Number(1234567890.12345)));
+
+  // Doubles are written with the fewest digits that parse back to the
+  // same double.
+  EXPECT_EQ("0.1", fmt::format("{}", JSON::Number(0.1)));
+  EXPECT_EQ("0.30000000000000004", fmt::format("{}", JSON::Number(0.1 + 0.2)));
+  EXPECT_EQ("-0.0", fmt::format("{}", JSON::Number(-0.0)));
+  EXPECT_EQ("0.000001", fmt::format("{}", JSON::Number(1e-6)));
+  EXPECT_EQ("1e-7", fmt::format("{}", JSON::Number(1e-7)));
+  EXPECT_EQ("1.5e-7", fmt::format("{}", JSON::Number(1.5e-7)));
+  EXPECT_EQ(
+      "100000000000000000000.0",
+      fmt::format("{}", JSON::Number(1e20)));
+  EXPECT_EQ("1e21", fmt::format("{}", JSON::Number(1e21)));
+  EXPECT_EQ("1.25e30", fmt::format("{}", JSON::Number(1.25e30)));
+  EXPECT_EQ("5e-324", fmt::format("{}", JSON::Number(5e-324)));
+  EXPECT_EQ(
+      "1.7976931348623157e308",
+      fmt::format("{}", JSON::Number(1.7976931348623157e308)));
+}
+
+
+TEST(JsonTest, ParseNumbers) {
+  // Integers are exact when they fit in 64 bits, as signed integers up
+  // to INT64_MAX and as unsigned integers after that.
+  Try<JSON::Number> number = JSON::parse<JSON::Number>("9223372036854775807");
+  ASSERT_SOME(number);
+  EXPECT_EQ(JSON::Number::SIGNED_INTEGER, number->type);
+  EXPECT_EQ(INT64_MAX, number->as<int64_t>());
+
+  number = JSON::parse<JSON::Number>("-9223372036854775808");
+  ASSERT_SOME(number);
+  EXPECT_EQ(JSON::Number::SIGNED_INTEGER, number->type);
+  EXPECT_EQ(INT64_MIN, number->as<int64_t>());
+
+  number = JSON::parse<JSON::Number>("9223372036854775809");
+  ASSERT_SOME(number);
+  EXPECT_EQ(JSON::Number::UNSIGNED_INTEGER, number->type);
+  EXPECT_EQ(9223372036854775809U, number->as<uint64_t>());
+
+  number = JSON::parse<JSON::Number>("18446744073709551615");
+  ASSERT_SOME(number);
+  EXPECT_EQ(JSON::Number::UNSIGNED_INTEGER, number->type);
+  EXPECT_EQ(UINT64_MAX, number->as<uint64_t>());
+
+  // Otherwise they're doubles.
+  number = JSON::parse<JSON::Number>("18446744073709551616");
+  ASSERT_SOME(number);
+  EXPECT_EQ(JSON::Number::FLOATING, number->type);
+  EXPECT_EQ(18446744073709551616.0, number->as<double>());
+
+  number = JSON::parse<JSON::Number>("-9223372036854775809");
+  ASSERT_SOME(number);
+  EXPECT_EQ(JSON::Number::FLOATING, number->type);
+
+  number = JSON::parse<JSON::Number>("1e2");
+  ASSERT_SOME(number);
+  EXPECT_EQ(JSON::Number::FLOATING, number->type);
+  EXPECT_EQ(100.0, number->as<double>());
+
+  // Unsigned integers roundtrip.
+  EXPECT_SOME_EQ(
+      JSON::Number(UINT64_MAX),
+      JSON::parse<JSON::Number>(stringify(JSON::Number(UINT64_MAX))));
+
+  // As do doubles.
+  std::mt19937_64 random(42);
+  for (int i = 0; i < 100000; i++) {
+    double value;
+    const uint64_t bits = random();
+    std::memcpy(&value, &bits, sizeof(value));
+
+    if (!std::isfinite(value)) {
+      continue;
+    }
+
+    const string s = stringify(JSON::Number(value));
+    number = JSON::parse<JSON::Number>(s);
+    ASSERT_SOME(number) << s;
+    ASSERT_EQ(JSON::Number::FLOATING, number->type) << s;
+    EXPECT_EQ(value, number->as<double>()) << s;
+  }
 }
 
 
@@ -383,6 +623,86 @@ TEST(JsonTest, Find) {
 }
 
 
+// Expects finding a parsed path to give the same result as finding
+// the path, but without copying.
+template <typename T>
+static void expectSameAsFind(const JSON::Object& object, const string& path) {
+  Result<T> expected = object.find<T>(path);
+
+  Try<JSON::Path> parsed = JSON::Path::parse(path);
+  if (parsed.isError()) {
+    EXPECT_ERROR(expected) << path;
+    return;
+  }
+
+  Result<const T*> actual = object.find<T>(parsed.get());
+
+  ASSERT_EQ(expected.isSome(), actual.isSome()) << path;
+  ASSERT_EQ(expected.isNone(), actual.isNone()) << path;
+
+  if (expected.isSome()) {
+    EXPECT_EQ(JSON::Value(expected.get()), JSON::Value(*actual.get()))
+      << path;
+  } else if (expected.isError()) {
+    EXPECT_EQ(expected.error(), actual.error()) << path;
+  }
+}
+
+
+TEST(JsonTest, FindPath) {
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(
+      R"~(
+      {
+          "nested1": {
+            "nested2": {
+              "string": "string",
+              "integer": -1,
+              "null": null,
+              "array": ["hello", {"a": [1, 2]}]
+            }
+          },
+          "": {"": 1}
+      })~");
+
+  ASSERT_SOME(object);
+
+  const vector<string> paths = {
+    "", ".", "nested1", "nested1.", "nested.nested.string",
+    "nested1.nested2.none", "nested1.nested2.array",
+    "nested1.nested2.array.foo", "nested1.nested2.string",
+    "nested1.nested2.integer", "nested1.nested2.array[0]",
+    "nested1.nested2.array[1].a[1]", "nested1.nested2.array[1].a[2]",
+    "nested1.nested2.array[1].a", "nested1.nested2.array[1", "a[[1]",
+    "nested1.nested2.array[1]]", "nested1.nested2.array.[1]",
+    "nested1.nested2.array[.1]", "nested1.nested2.array[]",
+    "nested1.nested2.array[-1]", "nested1[1].nested2.string",
+    "nested1.nested2.string[1]", "nested1.nested2.null[1]",
+    "nested1.nested2.missing[1]", "nested1.nested2.null",
+  };
+
+  foreach (const string& path, paths) {
+    expectSameAsFind<JSON::Value>(object.get(), path);
+    expectSameAsFind<JSON::String>(object.get(), path);
+    expectSameAsFind<JSON::Number>(object.get(), path);
+    expectSameAsFind<JSON::Object>(object.get(), path);
+    expectSameAsFind<JSON::Array>(object.get(), path);
+    expectSameAsFind<JSON::Null>(object.get(), path);
+  }
+
+  // The result points into the object.
+  Try<JSON::Path> path = JSON::Path::parse("nested1.nested2.array[0]");
+  ASSERT_SOME(path);
+
+  Result<const JSON::String*> string = object->find<JSON::String>(path.get());
+  ASSERT_SOME(string);
+  EXPECT_EQ(
+      &object->values["nested1"].as<JSON::Object>().values["nested2"]
+         .as<JSON::Object>().values["array"].as<JSON::Array>().values[0]
+         .as<JSON::String>(),
+      string.get());
+}
+
+
 TEST(JsonTest, At) {
   JSON::Object object;
 
@@ -801,3 +1121,263 @@ TEST(JsonTest, NestingDepth) {
   Try<JSON::Value> parsed = JSON::parse(deeplyNested);
   ASSERT_ERROR(parsed); // Maximum depth exceeded.
 }
+
+
+// Expects 'JSON::parse' to give the same result as picojson.
+static void expectSameAsPicojson(const string& s) {
+  Try<JSON::Value> expected = picojsonParse(s);
+  Try<JSON::Value> actual = JSON::parse(s);
+
+  ASSERT_EQ(expected.isSome(), actual.isSome())
+    << "'" << s << "': "
+    << (expected.isError() ? expected.error() : actual.error());
+
+  if (expected.isSome()) {
+    EXPECT_EQ(expected.get(), actual.get()) << s;
+  }
+}
+
+
+TEST(JsonTest, ParseMatchesPicojson) {
+  const vector<string> inputs = {
+    "", " ", "{}", "[]", " [ ] ", "{ }", "null", "true", "false",
+    "nul", "nulll", "truefalse", "[true false]", "[true,false]",
+    "0", "-0", "01", "-", "1.5", "-1.5e10", "1e400", "1e-400", "1.",
+    ".5", "[-]", "[1-2]", "[1+2]", "1e+2", "9223372036854775807",
+    "9223372036854775808", "-9223372036854775808",
+    "-9223372036854775809", "123456789012345678",
+    "1234567890123456789", "[1,2,3]", "[1,]", "[,1]", "[1 2]",
+    "[1,,2]", "{\"a\":1}", "{\"a\":1,}", "{\"a\" 1}", "{\"a\":}",
+    "{a:1}", "{\"a\":1,\"a\":2}", "{1:2}", "{\"a\":[{\"b\":null}]}",
+    "\"\"", "\"abc\"", "\"abc", "abc\"", "\"\\\"\"",
+    "\"\\\\\"", "\"\\/\\b\\f\\n\\r\\t\"", "\"\\x\"",
+    "\"\\u0041\\u00e9\\u20ac\"", "\"\\ud83d\\ude00\"",
+    "\"\\ud83d\"", "\"\\ude00\"", "\"\\ud83d\\u0041\"",
+    "\"\\u12\"", "\"\\u12g4\"", "\"tab\there\"",
+    "\"new\nline\"", "\"\xF0\x9F\x98\x80\"", "\"a\"\"b\"",
+    "[\"a\"\"b\"]", "[\"a\":1]", "{\"a\",1}", "[1]x", "[1] x",
+    "[1],", "{}{}", "[\n1,\n2\n]\n", "\t\r\n[]\t\r\n", "[1}",
+    "{]", "]", "}", ":", ",", "[[[]]]", "[[[]]", "[[]]]", "truex",
+    "[nullx]", "[1x]", "[\"a\"x]", "-a", "+1", "[\"\\", "\\",
+  };
+
+  foreach (const string& input, inputs) {
+    expectSameAsPicojson(input);
+  }
+}
+
+
+// Backslashes and quotes at every offset, so that escapes span the
+// blocks of 64 bytes of the first stage of parsing.
+TEST(JsonTest, ParseEscapes) {
+  for (size_t padding = 0; padding < 70; padding++) {
+    for (const string& escapes : {"\\\\", "\\\"", "\\\\\\\""}) {
+      const string s = "[\"" + string(padding, 'x') + escapes + "\", 1]";
+      expectSameAsPicojson(s);
+
+      Try<JSON::Array> array = JSON::parse<JSON::Array>(s);
+      ASSERT_SOME(array) << s;
+      ASSERT_EQ(2u, array->values.size());
+    }
+
+    // An odd number of backslashes escapes the closing quote.
+    expectSameAsPicojson("[\"" + string(padding, 'x') + "\\\", 1]");
+  }
+}
+
+
+// Compares the results of 'JSON::parse' and picojson on random
+// mutations of a document.
+TEST(JsonTest, ParseFuzz) {
+  const string document =
+    "{\"array\": [1, -2.5e3, true, false, null, \"a\\\"b\\\\\"],"
+    " \"object\": {\"key\": \"\\u00e9\\ud83d\\ude00\", \"\": []},"
+    " \"string\": \"" + string(60, 'x') + "\", \"number\": 12345678}";
+
+  expectSameAsPicojson(document);
+
+  const string characters = "{}[]:,\"\\ \nx0-.eE+tfnu\x01\xff";
+
+  std::mt19937 random(42);
+
+  for (int i = 0; i < 20000; i++) {
+    string s = document;
+    for (int mutations = 1 + random() % 3; mutations > 0; mutations--) {
+      const size_t position = random() % s.size();
+      switch (random() % 3) {
+        case 0:
+          s[position] = characters[random() % characters.size()];
+          break;
+        case 1:
+          s.erase(position, 1);
+          break;
+        case 2:
+          s.insert(position, 1, characters[random() % characters.size()]);
+          break;
+      }
+    }
+
+    expectSameAsPicojson(s);
+
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+
+
+// Compares the time to find paths in a large object as strings and
+// as parsed paths.
+TEST(JSON_BENCHMARK_Test, FindPath) {
+  JSON::Object object;
+  for (int i = 0; i < 1000; i++) {
+    JSON::Object labels;
+    for (int j = 0; j < 100; j++) {
+      labels.values["label" + stringify(j)] = stringify(j);
+    }
+
+    JSON::Object task;
+    task.values["labels"] = JSON::Array({labels});
+    object.values["task" + stringify(i)] = task;
+  }
+
+  vector<string> paths;
+  for (int i = 0; i < 1000; i++) {
+    paths.push_back("task" + stringify(i) + ".labels[0].label50");
+  }
+
+  vector<JSON::Path> parsed;
+  foreach (const string& path, paths) {
+    parsed.push_back(JSON::Path::parse(path).get());
+  }
+
+  Stopwatch watch;
+
+  watch.start();
+  foreach (const string& path, paths) {
+    EXPECT_SOME(object.find<JSON::String>(path));
+  }
+  watch.stop();
+
+  std::cout << "Finding " << paths.size() << " paths took "
+            << watch.elapsed() << std::endl;
+
+  watch.start();
+  foreach (const JSON::Path& path, parsed) {
+    EXPECT_SOME(object.find<JSON::String>(path));
+  }
+  watch.stop();
+
+  std::cout << "Finding " << paths.size() << " parsed paths took "
+            << watch.elapsed() << std::endl;
+}
+
+
+// Compares the time to parse a large document with picojson and with
+// 'JSON::parse'.
+TEST(JSON_BENCHMARK_Test, Parse) {
+  JSON::Array array;
+  for (int i = 0; i < 20000; i++) {
+    JSON::Object object;
+    object.values["id"] = i;
+    object.values["name"] = "task-" + stringify(i);
+    object.values["hostname"] = "agent" + stringify(i % 100) + ".example.com";
+    object.values["cpus"] = 0.25 * (i % 8);
+    object.values["active"] = i % 2 == 0;
+    object.values["labels"] = JSON::Array({"a", "b\\\"c", "d\u00e9"});
+    object.values["resources"] = JSON::Object({{"mem", 128}, {"disk", 1024}});
+    array.values.push_back(object);
+  }
+
+  const string s = stringify(array);
+
+  Stopwatch watch;
+
+  watch.start();
+  Try<JSON::Value> expected = picojsonParse(s);
+  watch.stop();
+
+  std::cout << "Parsing " << Bytes(s.size()) << " with picojson took "
+            << watch.elapsed() << std::endl;
+
+  watch.start();
+  Try<JSON::Value> actual = JSON::parse(s);
+  watch.stop();
+
+  std::cout << "Parsing " << Bytes(s.size()) << " with JSON::parse took "
+            << watch.elapsed() << std::endl;
+
+  ASSERT_SOME(expected);
+  EXPECT_SOME_EQ(expected.get(), actual);
+}
+
+
+// Compares the time to parse and to write a document of numbers with
+// picojson and 'JSON::parse', and with rapidjson's 'Writer::Double' and
+// 'jsonify'.
+TEST(JSON_BENCHMARK_Test, Numbers) {
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+
+  JSON::Array array;
+  vector<double> doubles;
+  for (int i = 0; i < 100000; i++) {
+    const double value = distribution(random);
+    doubles.push_back(value);
+
+    JSON::Object object;
+    object.values["double"] = value;
+    object.values["integer"] = static_cast<int64_t>(random());
+    object.values["unsigned"] = static_cast<uint64_t>(random());
+    object.values["small"] = i;
+    array.values.push_back(object);
+  }
+
+  const string s = stringify(array);
+
+  Stopwatch watch;
+
+  watch.start();
+  Try<JSON::Value> expected = picojsonParse(s);
+  watch.stop();
+
+  std::cout << "Parsing " << Bytes(s.size()) << " of numbers with picojson"
+            << " took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  Try<JSON::Value> actual = JSON::parse(s);
+  watch.stop();
+
+  std::cout << "Parsing " << Bytes(s.size()) << " of numbers with"
+            << " JSON::parse took " << watch.elapsed() << std::endl;
+
+  ASSERT_SOME(expected);
+  EXPECT_SOME_EQ(array, actual);
+
+  watch.start();
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.StartArray();
+  foreach (double value, doubles) {
+    writer.Double(value);
+  }
+  writer.EndArray();
+  watch.stop();
+
+  std::cout << "Writing " << doubles.size() << " doubles with rapidjson"
+            << " took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  const string written = jsonify(doubles);
+  watch.stop();
+
+  std::cout << "Writing " << doubles.size() << " doubles with jsonify took "
+            << watch.elapsed() << std::endl;
+
+  Try<JSON::Array> parsed = JSON::parse<JSON::Array>(written);
+  ASSERT_SOME(parsed);
+  ASSERT_EQ(doubles.size(), parsed->values.size());
+  for (size_t i = 0; i < doubles.size(); i++) {
+    EXPECT_EQ(doubles[i], parsed->values[i].as<JSON::Number>().as<double>());
+  }
+}
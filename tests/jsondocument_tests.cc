@@ -0,0 +1,287 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stout/arena.h"
+#include "stout/gtest.h"
+#include "stout/json.h"
+#include "stout/jsondocument.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+
+// Expects a 'JSON::Document' to give the same result as 'JSON::parse'.
+static void expectSameAsParse(const string& s) {
+  Try<JSON::Value> expected = JSON::parse(s);
+  Try<JSON::Document> actual = JSON::Document::parse(s);
+
+  ASSERT_EQ(expected.isSome(), actual.isSome())
+    << "'" << s << "': "
+    << (expected.isError() ? expected.error() : actual.error());
+
+  if (expected.isSome()) {
+    EXPECT_EQ(expected.get(), actual->root().toValue()) << s;
+  } else {
+    EXPECT_EQ(expected.error(), actual.error()) << s;
+  }
+}
+
+
+TEST(JsonDocumentTest, Types) {
+  Try<JSON::Document> document = JSON::Document::parse(
+      "{\"null\": null, \"true\": true, \"integer\": -42,"
+      " \"floating\": 1.5, \"string\": \"a\\nb\", \"array\": [1, \"2\"],"
+      " \"object\": {\"key\": \"value\"}}");
+  ASSERT_SOME(document);
+
+  const JSON::ValueView root = document->root();
+  ASSERT_TRUE(root.is<JSON::ObjectView>());
+  EXPECT_FALSE(root.is<JSON::ArrayView>());
+
+  const JSON::ObjectView object = root.as<JSON::ObjectView>();
+  EXPECT_EQ(7u, object.size());
+
+  // Members are sorted by key.
+  vector<string_view> keys;
+  for (const JSON::Member& member : object) {
+    keys.push_back(member.key);
+  }
+  EXPECT_EQ(
+      vector<string_view>(
+          {"array", "floating", "integer", "null", "object", "string",
+           "true"}),
+      keys);
+
+  EXPECT_TRUE(object.get("null")->is<JSON::Null>());
+  EXPECT_TRUE(object.get("true")->as<JSON::Boolean>().value);
+  EXPECT_EQ(-42, object.get("integer")->as<JSON::Number>().as<int>());
+  EXPECT_EQ(1.5, object.get("floating")->as<JSON::Number>().as<double>());
+  EXPECT_EQ("a\nb", object.get("string")->as<string_view>());
+  EXPECT_EQ("a\nb", object.get("string")->as<JSON::String>().value);
+  EXPECT_NONE(object.get("missing"));
+
+  const JSON::ArrayView array = object.get("array")->as<JSON::ArrayView>();
+  ASSERT_EQ(2u, array.size());
+  EXPECT_TRUE(array[0].is<JSON::Number>());
+  EXPECT_EQ("2", array[1].as<string_view>());
+
+  EXPECT_SOME_EQ("value", object.find<string_view>("object.key"));
+
+  // Integers beyond INT64_MAX are kept exactly.
+  Try<JSON::Document> big =
+    JSON::Document::parse("[18446744073709551615]");
+  ASSERT_SOME(big);
+
+  const JSON::Number number = big->root()
+    .as<JSON::ArrayView>()[0].as<JSON::Number>();
+  EXPECT_EQ(JSON::Number::UNSIGNED_INTEGER, number.type);
+  EXPECT_EQ(UINT64_MAX, number.as<uint64_t>());
+}
+
+
+TEST(JsonDocumentTest, MatchesParse) {
+  const vector<string> inputs = {
+    "", "{}", "[]", "null", "true", "false", "nul", "[true false]",
+    "0", "-0", "01", "1.5", "-1.5e10", "1e400", "9223372036854775808",
+    "[1,2,3]", "[1,]", "[1 2]", "{\"a\":1,}", "{\"a\" 1}",
+    "{\"b\":1,\"a\":2}", "{\"a\":1,\"a\":2}", "{\"b\":1,\"a\":2,\"b\":3}",
+    "{\"a\":[{\"b\":null}]}", "\"\\\"\"", "\"\\u0041\\u00e9\\u20ac\"",
+    "\"\\ud83d\\ude00\"", "\"\\ud83d\"", "\"\\u12g4\"", "\"\\x\"",
+    "[\"a\"\"b\"]", "[\"a\":1]", "{\"a\",1}", "[1]x", "[1}", "{]",
+    "[[[]]", "[[]]]", "{\"a\":{\"b\":1}]", "[{\"a\":1]}",
+  };
+
+  for (const string& input : inputs) {
+    expectSameAsParse(input);
+  }
+
+  std::mt19937 random(42);
+
+  const string document =
+    "{\"array\": [1, -2.5e3, true, false, null, \"a\\\"b\\\\\"],"
+    " \"object\": {\"key\": \"\\u00e9\\ud83d\\ude00\", \"\": []},"
+    " \"z\": {\"y\": 1, \"x\": [[], {}]}, \"number\": 12345678}";
+
+  const string characters = "{}[]:,\"\\ \nx0-.eE+tfnu";
+
+  for (int i = 0; i < 10000; i++) {
+    string s = document;
+    for (int mutations = 1 + random() % 3; mutations > 0; mutations--) {
+      const size_t position = random() % s.size();
+      switch (random() % 3) {
+        case 0:
+          s[position] = characters[random() % characters.size()];
+          break;
+        case 1:
+          s.erase(position, 1);
+          break;
+        case 2:
+          s.insert(position, 1, characters[random() % characters.size()]);
+          break;
+      }
+    }
+
+    expectSameAsParse(s);
+
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+
+
+TEST(JsonDocumentTest, Find) {
+  const string s =
+    "{\"nested1\": {\"nested2\": {\"string\": \"string\", \"integer\": 1,"
+    " \"array\": [{\"a\": 1}, null, 2]}, \"null\": null}}";
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(s);
+  ASSERT_SOME(object);
+
+  Try<JSON::Document> document = JSON::Document::parse(s);
+  ASSERT_SOME(document);
+
+  const JSON::ObjectView view = document->root().as<JSON::ObjectView>();
+
+  // The same results (and errors) as 'Object::find'.
+  const vector<string> paths = {
+    "nested1.nested2.string", "nested1.nested2.integer",
+    "nested1.nested2.array[0].a", "nested1.nested2.array[1]",
+    "nested1.nested2.array[2]", "nested1.nested2.array[3]",
+    "nested1.nested2.array[-1]", "nested1.nested2.array[x]",
+    "nested1.nested2.array[0", "nested1.nested2.string[0]",
+    "nested1.nested2.string.x", "nested1.null", "nested1.null[0]",
+    "nested1.missing", "missing.x", "", "nested1.",
+  };
+
+  for (const string& path : paths) {
+    Result<JSON::Value> expected = object->find<JSON::Value>(path);
+    Result<JSON::ValueView> actual = view.find<JSON::ValueView>(path);
+
+    ASSERT_EQ(expected.isSome(), actual.isSome()) << path;
+    ASSERT_EQ(expected.isNone(), actual.isNone()) << path;
+    if (expected.isSome()) {
+      EXPECT_EQ(expected.get(), actual->toValue()) << path;
+    } else if (expected.isError()) {
+      EXPECT_EQ(expected.error(), actual.error()) << path;
+    }
+  }
+
+  EXPECT_SOME_EQ("string", view.find<string_view>("nested1.nested2.string"));
+  EXPECT_ERROR(view.find<string_view>("nested1.nested2.integer"));
+  EXPECT_NONE(view.find<string_view>("nested1.null"));
+
+  const JSON::ObjectView nested1 =
+    view.at<JSON::ObjectView>("nested1").get();
+  EXPECT_SOME(nested1.at<JSON::ObjectView>("nested2"));
+  EXPECT_ERROR(nested1.at<JSON::ArrayView>("nested2"));
+  EXPECT_NONE(nested1.at<JSON::ObjectView>("missing"));
+}
+
+
+// Strings point into the document's own text, which must not move
+// with the document (even for a short string).
+TEST(JsonDocumentTest, Move) {
+  Try<JSON::Document> parsed = JSON::Document::parse("[\"a\\tb\"]");
+  ASSERT_SOME(parsed);
+
+  JSON::Document document = std::move(parsed.get());
+  parsed = JSON::Document::parse("[]");
+
+  const JSON::ArrayView array = document.root().as<JSON::ArrayView>();
+  ASSERT_EQ(1u, array.size());
+  EXPECT_EQ("a\tb", array[0].as<string_view>());
+}
+
+
+TEST(JsonDocumentTest, Arena) {
+  stout::Arena arena;
+
+  vector<JSON::Document> documents;
+  for (int i = 0; i < 10; i++) {
+    Try<JSON::Document> document =
+      JSON::Document::parse("[{\"i\": " + stringify(i) + "}, [1, 2]]", &arena);
+    ASSERT_SOME(document);
+    documents.push_back(std::move(document.get()));
+  }
+
+  // Two arrays of two elements and an object of one member each.
+  EXPECT_EQ(
+      10 * (4 * sizeof(JSON::ValueView) + sizeof(JSON::Member)),
+      arena.allocated().bytes());
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_SOME_EQ(
+        JSON::Number(i),
+        documents[i].root().as<JSON::ArrayView>()[0]
+          .as<JSON::ObjectView>().at<JSON::Number>("i"));
+  }
+
+  // Freeing all of the documents' arrays and objects at once.
+  documents.clear();
+  arena.reset();
+  EXPECT_EQ(0u, arena.allocated().bytes());
+}
+
+
+// Compares the time to parse a large document and the memory used by
+// the result with 'JSON::parse' and with 'JSON::Document'.
+TEST(JsonDocument_BENCHMARK_Test, Parse) {
+  JSON::Array array;
+  for (int i = 0; i < 20000; i++) {
+    JSON::Object object;
+    object.values["id"] = i;
+    object.values["name"] = "task-" + stringify(i);
+    object.values["hostname"] = "agent" + stringify(i % 100) + ".example.com";
+    object.values["cpus"] = 0.25 * (i % 8);
+    object.values["active"] = i % 2 == 0;
+    object.values["labels"] = JSON::Array({"a", "b\\\"c", "d\u00e9"});
+    object.values["resources"] = JSON::Object({{"mem", 128}, {"disk", 1024}});
+    array.values.push_back(object);
+  }
+
+  const string s = stringify(array);
+
+  Stopwatch watch;
+
+  watch.start();
+  Try<JSON::Value> expected = JSON::parse(s);
+  watch.stop();
+
+  std::cout << "Parsing " << Bytes(s.size()) << " with JSON::parse took "
+            << watch.elapsed() << " and uses "
+            << stout::footprint(expected.get()) << std::endl;
+
+  watch.start();
+  Try<JSON::Document> actual = JSON::Document::parse(s);
+  watch.stop();
+
+  std::cout << "Parsing " << Bytes(s.size()) << " with JSON::Document took "
+            << watch.elapsed() << " and uses "
+            << stout::footprint(actual.get()) << std::endl;
+
+  ASSERT_SOME(expected);
+  ASSERT_SOME(actual);
+  EXPECT_EQ(expected.get(), actual->root().toValue());
+}
@@ -0,0 +1,273 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "stout/gtest.h"
+#include "stout/json.h"
+#include "stout/jsonfields.h"
+#include "stout/jsonify.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+using std::string;
+using std::vector;
+
+
+namespace fields {
+
+struct Resources {
+  double cpus = 0;
+  int64_t mem = 0;
+};
+
+
+STOUT_JSON_FIELDS(Resources, cpus, mem)
+
+
+struct Task {
+  string id;
+  bool active = false;
+  Resources resources;
+  vector<string> labels;
+  vector<Resources> history;
+};
+
+
+STOUT_JSON_FIELDS(Task, id, active, resources, labels, history)
+
+
+// What 'STOUT_JSON_FIELDS' replaces.
+static void write(JSON::ObjectWriter* writer, const Resources& resources) {
+  writer->field("cpus", resources.cpus);
+  writer->field("mem", resources.mem);
+}
+
+
+static void write(JSON::ObjectWriter* writer, const Task& task) {
+  writer->field("id", task.id);
+  writer->field("active", task.active);
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    write(writer, task.resources);
+  });
+  writer->field("labels", task.labels);
+  writer->field("history", [&](JSON::ArrayWriter* writer) {
+    for (const Resources& resources : task.history) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        write(writer, resources);
+      });
+    }
+  });
+}
+
+
+static Task parse(const JSON::Object& object) {
+  Task task;
+  task.id = object.at<JSON::String>("id")->value;
+  task.active = object.at<JSON::Boolean>("active")->value;
+
+  const JSON::Object resources = object.at<JSON::Object>("resources").get();
+  task.resources.cpus = resources.at<JSON::Number>("cpus")->as<double>();
+  task.resources.mem = resources.at<JSON::Number>("mem")->as<int64_t>();
+
+  const JSON::Array labels = object.at<JSON::Array>("labels").get();
+  for (const JSON::Value& label : labels.values) {
+    task.labels.push_back(label.as<JSON::String>().value);
+  }
+
+  const JSON::Array history = object.at<JSON::Array>("history").get();
+  for (const JSON::Value& value : history.values) {
+    const JSON::Object& resources = value.as<JSON::Object>();
+    task.history.push_back(
+        {resources.at<JSON::Number>("cpus")->as<double>(),
+         resources.at<JSON::Number>("mem")->as<int64_t>()});
+  }
+
+  return task;
+}
+
+
+static Task task(int i) {
+  Task task;
+  task.id = "task-" + stringify(i);
+  task.active = i % 2 == 0;
+  task.resources = {0.5 * i, 128 * i};
+  task.labels = {"a", "b\\\"c", "dé"};
+  task.history = {{0.1, 32}, {1.5, 64}};
+  return task;
+}
+
+} // namespace fields
+
+
+using fields::Resources;
+using fields::Task;
+
+
+static void expectEqual(const Task& expected, const Task& actual) {
+  EXPECT_EQ(expected.id, actual.id);
+  EXPECT_EQ(expected.active, actual.active);
+  EXPECT_EQ(expected.resources.cpus, actual.resources.cpus);
+  EXPECT_EQ(expected.resources.mem, actual.resources.mem);
+  EXPECT_EQ(expected.labels, actual.labels);
+  ASSERT_EQ(expected.history.size(), actual.history.size());
+  for (size_t i = 0; i < expected.history.size(); i++) {
+    EXPECT_EQ(expected.history[i].cpus, actual.history[i].cpus);
+    EXPECT_EQ(expected.history[i].mem, actual.history[i].mem);
+  }
+}
+
+
+TEST(JsonFieldsTest, Jsonify) {
+  const Task task = fields::task(3);
+
+  const string expected = jsonify([&](JSON::ObjectWriter* writer) {
+    fields::write(writer, task);
+  });
+
+  EXPECT_EQ(expected, string(jsonify(task)));
+  EXPECT_EQ(
+      "{\"id\":\"task-3\",\"active\":false,"
+      "\"resources\":{\"cpus\":1.5,\"mem\":384},"
+      "\"labels\":[\"a\",\"b\\\\\\\"c\",\"dé\"],"
+      "\"history\":[{\"cpus\":0.1,\"mem\":32},{\"cpus\":1.5,\"mem\":64}]}",
+      expected);
+
+  // As a field and as elements.
+  EXPECT_EQ(
+      "{\"resources\":{\"cpus\":1.5,\"mem\":384}}",
+      string(jsonify([&](JSON::ObjectWriter* writer) {
+        writer->field("resources", task.resources);
+      })));
+
+  EXPECT_EQ(
+      "[{\"cpus\":0.1,\"mem\":32},{\"cpus\":1.5,\"mem\":64}]",
+      string(jsonify(task.history)));
+}
+
+
+TEST(JsonFieldsTest, Decode) {
+  const Task task = fields::task(3);
+
+  Try<Task> decoded = JSON::decode<Task>(jsonify(task));
+  ASSERT_SOME(decoded);
+  expectEqual(task, decoded.get());
+
+  // Missing and null fields are left as initialized and members that
+  // aren't fields are ignored.
+  decoded = JSON::decode<Task>(
+      "{\"id\": \"t\", \"resources\": {\"mem\": 64, \"disk\": 10},"
+      " \"labels\": null, \"unknown\": [1, 2]}");
+  ASSERT_SOME(decoded);
+  EXPECT_EQ("t", decoded->id);
+  EXPECT_FALSE(decoded->active);
+  EXPECT_EQ(0, decoded->resources.cpus);
+  EXPECT_EQ(64, decoded->resources.mem);
+  EXPECT_TRUE(decoded->labels.empty());
+  EXPECT_TRUE(decoded->history.empty());
+
+  // Arrays of them.
+  Try<vector<Resources>> history =
+    JSON::decode<vector<Resources>>(jsonify(task.history));
+  ASSERT_SOME(history);
+  ASSERT_EQ(2u, history->size());
+  EXPECT_EQ(1.5, history->at(1).cpus);
+  EXPECT_EQ(64, history->at(1).mem);
+
+  // Errors say which field they're for.
+  EXPECT_ERROR(JSON::decode<Task>("{\"id\": \"t\""));
+
+  decoded = JSON::decode<Task>("{\"id\": 1}");
+  ASSERT_ERROR(decoded);
+  EXPECT_EQ(
+      "Failed to decode 'id': Found JSON value of wrong type",
+      decoded.error());
+
+  decoded = JSON::decode<Task>(
+      "{\"history\": [{\"cpus\": 1}, {\"cpus\": \"2\"}]}");
+  ASSERT_ERROR(decoded);
+  EXPECT_EQ(
+      "Failed to decode 'history': Failed to decode element 1:"
+      " Failed to decode 'cpus': Found JSON value of wrong type",
+      decoded.error());
+
+  decoded = JSON::decode<Task>("{\"resources\": 1}");
+  ASSERT_ERROR(decoded);
+  EXPECT_EQ(
+      "Failed to decode 'resources': Failed to decode 'cpus':"
+      " Intermediate JSON value not an object",
+      decoded.error());
+}
+
+
+// Compares writing and parsing structs with hand-written functions
+// (parsing into a 'JSON::Value' first) and with 'STOUT_JSON_FIELDS'.
+TEST(JsonFields_BENCHMARK_Test, Tasks) {
+  vector<Task> tasks;
+  for (int i = 0; i < 100000; i++) {
+    tasks.push_back(fields::task(i));
+  }
+
+  Stopwatch watch;
+
+  watch.start();
+  const string expected = jsonify([&](JSON::ArrayWriter* writer) {
+    for (const Task& task : tasks) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        fields::write(writer, task);
+      });
+    }
+  });
+  watch.stop();
+
+  std::cout << "Writing " << tasks.size() << " tasks by hand took "
+            << watch.elapsed() << std::endl;
+
+  watch.start();
+  const string s = jsonify(tasks);
+  watch.stop();
+
+  std::cout << "Writing " << tasks.size() << " tasks with"
+            << " STOUT_JSON_FIELDS took " << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(expected, s);
+
+  watch.start();
+  Try<JSON::Array> array = JSON::parse<JSON::Array>(s);
+  ASSERT_SOME(array);
+  vector<Task> parsed;
+  for (const JSON::Value& value : array->values) {
+    parsed.push_back(fields::parse(value.as<JSON::Object>()));
+  }
+  watch.stop();
+
+  std::cout << "Parsing " << parsed.size() << " tasks by hand took "
+            << watch.elapsed() << std::endl;
+
+  watch.start();
+  Try<vector<Task>> decoded = JSON::decode<vector<Task>>(s);
+  watch.stop();
+
+  std::cout << "Parsing " << parsed.size() << " tasks with"
+            << " STOUT_JSON_FIELDS took " << watch.elapsed() << std::endl;
+
+  ASSERT_SOME(decoded);
+  ASSERT_EQ(tasks.size(), decoded->size());
+  for (size_t i = 0; i < tasks.size(); i += 997) {
+    expectEqual(parsed[i], decoded->at(i));
+  }
+}
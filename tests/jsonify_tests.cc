@@ -12,13 +12,18 @@
 
 #include <gtest/gtest.h>
 
+#include <iostream>
 #include <map>
 #include <set>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "stout/bytes.h"
 #include "stout/json.h"
 #include "stout/jsonify.h"
+#include "stout/stopwatch.h"
 
 using std::map;
 using std::multimap;
@@ -359,3 +364,137 @@ TEST(JsonifyTest, JSONNull) {
   JSON::Array numbers = JSON::Array{1, JSON::Null(), 3};
   EXPECT_EQ("[1,null,3]", string(jsonify(numbers)));
 }
+
+
+TEST(JsonifyTest, Write) {
+  JSON::Array array;
+  for (int i = 0; i < 1000; i++) {
+    array.values.push_back(
+        JSON::Object({{"i", i}, {"s", string(i % 50, 'x')}}));
+  }
+
+  const string expected = jsonify(array);
+
+  vector<string> chunks;
+  Try<Nothing> write = JSON::write(
+      [&](std::string_view data) -> Try<Nothing> {
+        chunks.emplace_back(data);
+        return Nothing();
+      },
+      array,
+      1000);
+
+  ASSERT_FALSE(write.isError());
+  ASSERT_LT(1u, chunks.size());
+
+  string actual;
+  for (const string& chunk : chunks) {
+    // Flushed after the element that filled the buffer.
+    EXPECT_GT(1100u, chunk.size());
+    actual += chunk;
+  }
+
+  EXPECT_EQ(expected, actual);
+
+  // Writes nested in a write aren't flushed to its sink.
+  chunks.clear();
+  write = JSON::write(
+      [&](std::string_view data) -> Try<Nothing> {
+        chunks.emplace_back(data);
+        return Nothing();
+      },
+      [&](JSON::ObjectWriter* writer) {
+        writer->field("nested", string(jsonify(array)));
+        writer->field("array", array);
+      },
+      1000);
+
+  ASSERT_FALSE(write.isError());
+
+  actual.clear();
+  for (const string& chunk : chunks) {
+    actual += chunk;
+  }
+
+  EXPECT_EQ(
+      "{\"nested\":" + string(jsonify(expected)) + ",\"array\":" + expected
+        + "}",
+      actual);
+
+  // The sink isn't called after it returns an error.
+  size_t calls = 0;
+  write = JSON::write(
+      [&](std::string_view data) -> Try<Nothing> {
+        calls++;
+        return Error("Failed");
+      },
+      array,
+      1000);
+
+  ASSERT_TRUE(write.isError());
+  EXPECT_EQ("Failed", write.error());
+  EXPECT_EQ(1u, calls);
+
+  // Scalars are written with one call.
+  chunks.clear();
+  write = JSON::write(
+      [&](std::string_view data) -> Try<Nothing> {
+        chunks.emplace_back(data);
+        return Nothing();
+      },
+      "string");
+
+  ASSERT_FALSE(write.isError());
+  EXPECT_EQ(vector<string>({"\"string\""}), chunks);
+
+  // Streams are written a buffer at a time too.
+  std::ostringstream stream;
+  stream << jsonify(array);
+  EXPECT_EQ(expected, stream.str());
+}
+
+
+// Nested 'jsonify' calls to strings each render with their own buffer.
+TEST(JsonifyTest, NestedString) {
+  const string inner = jsonify([](JSON::ObjectWriter* writer) {
+    writer->field("inner", string(jsonify(vector<int>{1, 2})));
+  });
+
+  EXPECT_EQ("{\"inner\":\"[1,2]\"}", inner);
+
+  // Large strings don't keep the buffer from being reused.
+  const string large(2 * 1024 * 1024, 'x');
+  EXPECT_EQ(large.size() + 2, string(jsonify(large)).size());
+  EXPECT_EQ("[1,2]", string(jsonify(vector<int>{1, 2})));
+}
+
+
+// Measures rendering many small documents with nested objects and
+// arrays, which reuses the thread's buffer and doesn't allocate for
+// each nested value.
+TEST(Jsonify_BENCHMARK_Test, Nested) {
+  map<string, vector<int>> values;
+  for (int i = 0; i < 20; i++) {
+    values["key" + std::to_string(i)] = vector<int>(10, i);
+  }
+
+  const size_t repetitions = 20000;
+  size_t size = 0;
+
+  Stopwatch watch;
+  watch.start();
+  for (size_t i = 0; i < repetitions; i++) {
+    const string s = jsonify([&](JSON::ObjectWriter* writer) {
+      writer->field("id", i);
+      writer->field("values", values);
+      writer->field("nested", [&](JSON::ObjectWriter* writer) {
+        writer->field("values", values);
+      });
+    });
+    size += s.size();
+  }
+  watch.stop();
+
+  std::cout << "Rendering " << repetitions << " documents ("
+            << Bytes(size) << ") took " << watch.elapsed() << std::endl;
+}
@@ -0,0 +1,269 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "stout/gtest.h"
+#include "stout/json.h"
+#include "stout/jsonlazy.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+using std::string;
+using std::vector;
+
+
+TEST(JsonLazyTest, Get) {
+  Try<JSON::LazyDocument> document = JSON::LazyDocument::parse(
+      "{\"null\": null, \"true\": true, \"integer\": -42,"
+      " \"floating\": 1.5, \"string\": \"a\\nb\", \"array\": [1, \"2\", []],"
+      " \"object\": {\"key\": \"value\", \"k\\u0065y\": \"escaped\"}}");
+  ASSERT_SOME(document);
+
+  EXPECT_SOME_EQ(JSON::Null(), (*document)["null"].get<JSON::Null>());
+  EXPECT_SOME_EQ(JSON::Null(), (*document)["null"].get<JSON::Value>());
+  EXPECT_NONE((*document)["null"].get<int64_t>());
+
+  EXPECT_SOME_TRUE((*document)["true"].get<bool>());
+  EXPECT_SOME_EQ(-42, (*document)["integer"].get<int64_t>());
+  EXPECT_SOME_EQ(-42.0, (*document)["integer"].get<double>());
+  EXPECT_SOME_EQ(1.5, (*document)["floating"].get<double>());
+  EXPECT_SOME_EQ(
+      JSON::Number(1.5),
+      (*document)["floating"].get<JSON::Number>());
+  EXPECT_SOME_EQ("a\nb", (*document)["string"].get<string>());
+  EXPECT_SOME_EQ("a\nb", (*document)["string"].get<JSON::String>());
+
+  EXPECT_SOME_EQ(1, (*document)["array"][0].get<int>());
+  EXPECT_SOME_EQ("2", (*document)["array"][1].get<string>());
+  EXPECT_SOME_EQ(JSON::Array(), (*document)["array"][2].get<JSON::Array>());
+  EXPECT_NONE((*document)["array"][3].get<int>());
+
+  // The last of duplicate keys, compared after unescaping.
+  EXPECT_SOME_EQ("escaped", (*document)["object"]["key"].get<string>());
+
+  EXPECT_SOME_EQ(
+      JSON::parse("{\"key\": \"escaped\"}").get(),
+      (*document)["object"].get<JSON::Value>());
+
+  // Wrong types.
+  EXPECT_ERROR((*document)["integer"].get<string>());
+  EXPECT_ERROR((*document)["string"].get<int64_t>());
+  EXPECT_ERROR((*document)["string"].get<JSON::Object>());
+  EXPECT_ERROR((*document)["array"].get<JSON::Object>());
+
+  // Missing values and errors are carried through lookups.
+  EXPECT_NONE((*document)["missing"]["key"][0].get<int64_t>());
+  EXPECT_NONE((*document)["null"]["key"].get<int64_t>());
+  EXPECT_ERROR((*document)["string"]["key"].get<string>());
+  EXPECT_ERROR((*document)["object"][0].get<string>());
+  EXPECT_ERROR((*document)["string"][0]["key"].get<string>());
+
+  Result<vector<JSON::LazyValue>> values = (*document)["array"].values();
+  ASSERT_SOME(values);
+  ASSERT_EQ(3u, values->size());
+  EXPECT_SOME_EQ("2", values->at(1).get<string>());
+
+  values = (*document)["object"].values();
+  ASSERT_SOME(values);
+  EXPECT_EQ(2u, values->size());
+
+  EXPECT_ERROR((*document)["string"].values());
+  EXPECT_NONE((*document)["missing"].values());
+}
+
+
+TEST(JsonLazyTest, EscapedKeys) {
+  Try<JSON::LazyDocument> document =
+    JSON::LazyDocument::parse("{\"a\\n\": 1, \"b\\\\n\": 2}");
+  ASSERT_SOME(document);
+
+  // Keys with escapes are only compared unescaped.
+  EXPECT_SOME_EQ(1, (*document)["a\n"].get<int>());
+  EXPECT_NONE((*document)["a\\n"].get<int>());
+  EXPECT_SOME_EQ(2, (*document)["b\\n"].get<int>());
+  EXPECT_NONE((*document)["b\\\\n"].get<int>());
+}
+
+
+TEST(JsonLazyTest, Path) {
+  const string s =
+    "{\"nested1\": {\"nested2\": {\"string\": \"string\", \"integer\": 1,"
+    " \"null\": null, \"array\": [{\"a\": 1}, null, 2]}}}";
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(s);
+  ASSERT_SOME(object);
+
+  Try<JSON::LazyDocument> document = JSON::LazyDocument::parse(s);
+  ASSERT_SOME(document);
+
+  // The same results (and errors) as 'Object::find'.
+  const vector<string> paths = {
+    "nested1.nested2.string", "nested1.nested2.integer",
+    "nested1.nested2.array[0].a", "nested1.nested2.array[1]",
+    "nested1.nested2.array[2]", "nested1.nested2.array[3]",
+    "nested1.nested2.string[0]", "nested1.nested2.string.x",
+    "nested1.nested2.null", "nested1.nested2.null[0]",
+    "nested1.nested2.null.x", "nested1.missing", "missing.x",
+    "nested1[0].nested2", "", "nested1.",
+  };
+
+  for (const string& path : paths) {
+    Result<JSON::Value> expected = object->find<JSON::Value>(path);
+    Result<JSON::Value> actual =
+      (*document)[JSON::Path::parse(path).get()].get<JSON::Value>();
+
+    ASSERT_EQ(expected.isSome(), actual.isSome()) << path;
+    ASSERT_EQ(expected.isNone(), actual.isNone()) << path;
+    if (expected.isSome()) {
+      EXPECT_EQ(expected.get(), actual.get()) << path;
+    } else if (expected.isError()) {
+      EXPECT_EQ(expected.error(), actual.error()) << path;
+    }
+  }
+}
+
+
+TEST(JsonLazyTest, Parse) {
+  const vector<string> valid = {
+    "{}", "[]", "null", "true", "1", "\"a\"", " [ 1 , [ ] , { } ] ",
+    "{\"a\": [1, {\"b\": null}], \"c\": \"d\"}",
+  };
+
+  for (const string& s : valid) {
+    Try<JSON::LazyDocument> document = JSON::LazyDocument::parse(s);
+    ASSERT_SOME(document) << s;
+    EXPECT_SOME_EQ(JSON::parse(s).get(), document->root().get<JSON::Value>())
+      << s;
+  }
+
+  const vector<string> invalid = {
+    "", " ", "nul", "nulll", "truefalse", "[true false]", "[1,]",
+    "[,1]", "[1 2]", "{\"a\":1,}", "{\"a\" 1}", "{\"a\":}", "{a:1}",
+    "{1:2}", "[\"a\"\"b\"]", "[\"a\":1]", "{\"a\",1}", "[1]x", "[1],",
+    "{}{}", "[1}", "{]", "]", "[[[]]", "[[]]]", "[1x]", "-a",
+    string(1000, '['),
+  };
+
+  for (const string& s : invalid) {
+    EXPECT_ERROR(JSON::LazyDocument::parse(s)) << s;
+  }
+
+  // Numbers and escapes are only checked when they're decoded.
+  Try<JSON::LazyDocument> document =
+    JSON::LazyDocument::parse("[\"\\x\", 1-2, 1e400]");
+  ASSERT_SOME(document);
+  EXPECT_ERROR((*document)[0].get<string>());
+  EXPECT_ERROR((*document)[1].get<int64_t>());
+  EXPECT_ERROR((*document)[2].get<double>());
+  EXPECT_ERROR(document->root().get<JSON::Value>());
+}
+
+
+// Anything 'JSON::parse' accepts is parsed to the same value.
+TEST(JsonLazyTest, Fuzz) {
+  const string document =
+    "{\"array\": [1, -2.5e3, true, false, null, \"a\\\"b\\\\\"],"
+    " \"object\": {\"key\": \"\\u00e9\\ud83d\\ude00\", \"\": []},"
+    " \"z\": {\"y\": 1, \"x\": [[], {}]}, \"number\": 12345678}";
+
+  const string characters = "{}[]:,\"\\ \nx0-.eE+tfnu";
+
+  std::mt19937 random(42);
+
+  for (int i = 0; i < 10000; i++) {
+    string s = document;
+    for (int mutations = 1 + random() % 3; mutations > 0; mutations--) {
+      const size_t position = random() % s.size();
+      switch (random() % 3) {
+        case 0:
+          s[position] = characters[random() % characters.size()];
+          break;
+        case 1:
+          s.erase(position, 1);
+          break;
+        case 2:
+          s.insert(position, 1, characters[random() % characters.size()]);
+          break;
+      }
+    }
+
+    Try<JSON::Value> expected = JSON::parse(s);
+    Try<JSON::LazyDocument> actual = JSON::LazyDocument::parse(s);
+
+    if (expected.isSome()) {
+      ASSERT_SOME(actual) << s;
+      EXPECT_SOME_EQ(expected.get(), actual->root().get<JSON::Value>()) << s;
+    } else if (actual.isSome()) {
+      EXPECT_ERROR(actual->root().get<JSON::Value>()) << s;
+    }
+  }
+}
+
+
+// Compares the time to get a few values out of a large document with
+// 'JSON::parse' and with a 'JSON::LazyDocument'.
+TEST(JsonLazy_BENCHMARK_Test, Get) {
+  JSON::Object object;
+  JSON::Array tasks;
+  for (int i = 0; i < 20000; i++) {
+    JSON::Object task;
+    task.values["id"] = i;
+    task.values["name"] = "task-" + stringify(i);
+    task.values["hostname"] = "agent" + stringify(i % 100) + ".example.com";
+    task.values["labels"] = JSON::Array({"a", "b\\\"c", "d\u00e9"});
+    task.values["resources"] = JSON::Object({{"mem", 128}, {"disk", 1024}});
+    tasks.values.push_back(task);
+  }
+  object.values["tasks"] = tasks;
+  object.values["version"] = "1.0";
+  object.values["id"] = "cluster";
+
+  const string s = stringify(object);
+
+  Stopwatch watch;
+
+  watch.start();
+  Try<JSON::Object> parsed = JSON::parse<JSON::Object>(s);
+  ASSERT_SOME(parsed);
+  Result<JSON::String> version = parsed->find<JSON::String>("version");
+  Result<JSON::Number> mem =
+    parsed->find<JSON::Number>("tasks[10000].resources.mem");
+  watch.stop();
+
+  std::cout << "Getting 2 values from " << Bytes(s.size())
+            << " with JSON::parse took " << watch.elapsed() << std::endl;
+
+  EXPECT_SOME_EQ("1.0", version);
+  EXPECT_SOME_EQ(JSON::Number(128), mem);
+
+  watch.start();
+  Try<JSON::LazyDocument> document = JSON::LazyDocument::parse(s);
+  ASSERT_SOME(document);
+  Result<string> version2 = (*document)["version"].get<string>();
+  Result<int64_t> mem2 =
+    (*document)["tasks"][10000]["resources"]["mem"].get<int64_t>();
+  watch.stop();
+
+  std::cout << "Getting 2 values from " << Bytes(s.size())
+            << " with JSON::LazyDocument took " << watch.elapsed()
+            << std::endl;
+
+  EXPECT_SOME_EQ("1.0", version2);
+  EXPECT_SOME_EQ(128, mem2);
+}
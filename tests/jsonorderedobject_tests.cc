@@ -0,0 +1,212 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "stout/gtest.h"
+#include "stout/json.h"
+#include "stout/jsonify.h"
+#include "stout/jsonorderedobject.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+using std::string;
+using std::vector;
+
+
+TEST(JsonOrderedObjectTest, Order) {
+  JSON::OrderedObject object;
+  object["z"] = 1;
+  object["a"] = "two";
+  object["m"] = JSON::Array({1, 2});
+  object["a"] = 3; // Replacing keeps the position.
+
+  ASSERT_EQ(3u, object.size());
+  EXPECT_EQ("z", object.values()[0].first);
+  EXPECT_EQ("a", object.values()[1].first);
+  EXPECT_EQ("m", object.values()[2].first);
+
+  EXPECT_EQ("{\"z\":1,\"a\":3,\"m\":[1,2]}", stringify(object));
+  EXPECT_EQ("{\"z\":1,\"a\":3,\"m\":[1,2]}", string(jsonify(object)));
+
+  EXPECT_SOME_EQ(3, object.at<JSON::Number>("a"));
+  EXPECT_NONE(object.at<JSON::Number>("b"));
+  EXPECT_ERROR(object.at<JSON::String>("a"));
+
+  EXPECT_TRUE(object.contains("m"));
+  EXPECT_EQ(nullptr, object.get("b"));
+  EXPECT_FALSE(object.contains("b"));
+
+  EXPECT_EQ(1u, object.erase("z"));
+  EXPECT_EQ(0u, object.erase("z"));
+  EXPECT_EQ("{\"a\":3,\"m\":[1,2]}", stringify(object));
+
+  // Nested in a jsonified object.
+  EXPECT_EQ(
+      "{\"nested\":{\"a\":3,\"m\":[1,2]}}",
+      string(jsonify([&](JSON::ObjectWriter* writer) {
+        writer->field("nested", object);
+      })));
+
+  JSON::OrderedObject initialized = {{"b", 1}, {"a", 2}, {"b", 3}};
+  EXPECT_EQ("{\"b\":3,\"a\":2}", stringify(initialized));
+
+  // Conversions to and from 'Object'.
+  JSON::Object sorted = initialized.toObject();
+  EXPECT_EQ("{\"a\":2,\"b\":3}", stringify(sorted));
+
+  JSON::OrderedObject converted(sorted);
+  EXPECT_EQ("{\"a\":2,\"b\":3}", stringify(converted));
+  EXPECT_EQ(initialized, converted);
+
+  converted["a"] = 4;
+  EXPECT_NE(initialized, converted);
+
+  converted.clear();
+  EXPECT_TRUE(converted.empty());
+  EXPECT_EQ("{}", stringify(converted));
+}
+
+
+// Compares random operations on large (indexed) objects with the same
+// operations on an 'Object'.
+TEST(JsonOrderedObjectTest, Index) {
+  std::mt19937 random(42);
+
+  JSON::OrderedObject object;
+  JSON::Object expected;
+
+  for (int i = 0; i < 20000; i++) {
+    const string key = "key" + stringify(random() % 500);
+    switch (random() % 4) {
+      case 0:
+        EXPECT_EQ(expected.values.erase(key), object.erase(key)) << key;
+        break;
+      case 1:
+        ASSERT_EQ(expected.values.count(key) > 0, object.contains(key));
+        if (object.contains(key)) {
+          EXPECT_EQ(expected.values.at(key), *object.get(key)) << key;
+        }
+        break;
+      default:
+        expected.values[key] = i;
+        object[key] = i;
+        break;
+    }
+
+    ASSERT_EQ(expected.values.size(), object.size());
+  }
+
+  EXPECT_EQ(expected, object.toObject());
+  EXPECT_EQ(object, JSON::OrderedObject(expected));
+}
+
+
+// Returns 'size' distinct keys in a scrambled order.
+static vector<string> keys(size_t size) {
+  vector<string> keys;
+  for (size_t i = 0; i < size; i++) {
+    keys.push_back("field_" + stringify(i * 7919 % size));
+  }
+  return keys;
+}
+
+
+// Compares constructing, looking up every member of and serializing a
+// wide object as an 'Object' and as an 'OrderedObject'.
+TEST(JsonOrderedObject_BENCHMARK_Test, Wide) {
+  const size_t size = 1000;
+  const size_t repetitions = 200;
+
+  const vector<string> fields = keys(size);
+
+  Stopwatch watch;
+
+  watch.start();
+  JSON::Object object;
+  for (size_t i = 0; i < repetitions; i++) {
+    object.values.clear();
+    for (const string& field : fields) {
+      object.values[field] = i;
+    }
+  }
+  watch.stop();
+
+  std::cout << "Constructing " << repetitions << " objects of " << size
+            << " members took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  JSON::OrderedObject ordered;
+  for (size_t i = 0; i < repetitions; i++) {
+    ordered.clear();
+    for (const string& field : fields) {
+      ordered[field] = i;
+    }
+  }
+  watch.stop();
+
+  std::cout << "Constructing " << repetitions << " ordered objects of "
+            << size << " members took " << watch.elapsed() << std::endl;
+
+  size_t found = 0;
+
+  watch.start();
+  for (size_t i = 0; i < repetitions; i++) {
+    for (const string& field : fields) {
+      found += object.values.count(field);
+    }
+  }
+  watch.stop();
+
+  std::cout << "Looking up " << repetitions * size << " members of an"
+            << " object took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  for (size_t i = 0; i < repetitions; i++) {
+    for (const string& field : fields) {
+      found += ordered.contains(field);
+    }
+  }
+  watch.stop();
+
+  std::cout << "Looking up " << repetitions * size << " members of an"
+            << " ordered object took " << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(2 * repetitions * size, found);
+
+  size_t bytes = 0;
+
+  watch.start();
+  for (size_t i = 0; i < repetitions; i++) {
+    bytes += stringify(object).size();
+  }
+  watch.stop();
+
+  std::cout << "Serializing an object " << repetitions << " times took "
+            << watch.elapsed() << std::endl;
+
+  watch.start();
+  for (size_t i = 0; i < repetitions; i++) {
+    bytes -= stringify(ordered).size();
+  }
+  watch.stop();
+
+  std::cout << "Serializing an ordered object " << repetitions
+            << " times took " << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(0u, bytes);
+}
@@ -0,0 +1,431 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stout/gtest.h"
+#include "stout/gzip.h"
+#include "stout/json.h"
+#include "stout/jsonreader.h"
+#include "stout/path.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+#include "stout/os/close.h"
+#include "stout/os/open.h"
+#include "stout/os/write.h"
+
+#include "stout/tests/utils.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+
+// Records every event as a string.
+struct Recorder : JSON::Handler {
+  JSON::Action startObject() { return record("{"); }
+  JSON::Action endObject() { return record("}"); }
+  JSON::Action startArray() { return record("["); }
+  JSON::Action endArray() { return record("]"); }
+
+  JSON::Action key(string_view key) {
+    return record("key:" + std::string(key));
+  }
+
+  JSON::Action string(string_view value) {
+    return record("string:" + std::string(value));
+  }
+
+  JSON::Action number(const JSON::Number& number) {
+    return record("number:" + stringify(number));
+  }
+
+  JSON::Action boolean(bool value) {
+    return record(value ? "true" : "false");
+  }
+
+  JSON::Action null() { return record("null"); }
+
+  JSON::Action record(const std::string& event) {
+    events.push_back(event);
+    return JSON::Action::CONTINUE;
+  }
+
+  vector<std::string> events;
+};
+
+
+// Builds the 'JSON::Value' that was read.
+struct Builder : JSON::Handler {
+  JSON::Action startObject() {
+    values.push_back(JSON::Object());
+    return JSON::Action::CONTINUE;
+  }
+
+  JSON::Action endObject() { return end(); }
+
+  JSON::Action startArray() {
+    values.push_back(JSON::Array());
+    return JSON::Action::CONTINUE;
+  }
+
+  JSON::Action endArray() { return end(); }
+
+  JSON::Action key(string_view key) {
+    keys.push_back(std::string(key));
+    return JSON::Action::CONTINUE;
+  }
+
+  JSON::Action string(string_view value) {
+    return add(JSON::String(std::string(value)));
+  }
+
+  JSON::Action number(const JSON::Number& number) { return add(number); }
+  JSON::Action boolean(bool value) { return add(JSON::Boolean(value)); }
+  JSON::Action null() { return add(JSON::Null()); }
+
+  JSON::Action end() {
+    JSON::Value value = std::move(values.back());
+    values.pop_back();
+    return add(std::move(value));
+  }
+
+  JSON::Action add(JSON::Value value) {
+    if (values.empty()) {
+      result = std::move(value);
+    } else if (values.back().is<JSON::Array>()) {
+      values.back().as<JSON::Array>().values.push_back(std::move(value));
+    } else {
+      values.back().as<JSON::Object>().values[keys.back()] = std::move(value);
+      keys.pop_back();
+    }
+    return JSON::Action::CONTINUE;
+  }
+
+  vector<JSON::Value> values;
+  vector<std::string> keys;
+  JSON::Value result;
+};
+
+
+// Reads 's' in chunks of 'size' bytes.
+template <typename H>
+static Try<Nothing> read(const string& s, H* handler, size_t size) {
+  JSON::Reader<H> reader(handler);
+  for (size_t i = 0; i < s.size(); i += size) {
+    Try<Nothing> read = reader.feed(string_view(s).substr(i, size));
+    if (read.isError()) {
+      return read;
+    }
+  }
+  return reader.finish();
+}
+
+
+TEST(JsonReaderTest, Events) {
+  const string s =
+    "{\"a\": [1, -2.5, true, false, null, \"x\\ny\"],\n"
+    " \"b\\u00e9\": {\"c\": {}, \"d\": []}}";
+
+  const vector<string> expected = {
+    "{", "key:a", "[", "number:1", "number:-2.5", "true", "false", "null",
+    "string:x\ny", "]", "key:b\u00e9", "{", "key:c", "{", "}", "key:d",
+    "[", "]", "}", "}",
+  };
+
+  // In chunks of every size, so that every token is split.
+  for (size_t size = 1; size <= s.size(); size++) {
+    Recorder recorder;
+    ASSERT_SOME(read(s, &recorder, size)) << size;
+    EXPECT_EQ(expected, recorder.events) << size;
+  }
+}
+
+
+TEST(JsonReaderTest, MatchesParse) {
+  const vector<string> inputs = {
+    "", " ", "{}", "[]", "null", "true", "false", "nul", "nulll",
+    "truefalse", "[true false]", "0", "-0", "01", "-", "1.5", "1e400",
+    "1.", ".5", "[-]", "[1-2]", "9223372036854775808", "[1,2,3]",
+    "[1,]", "[,1]", "[1 2]", "{\"a\":1}", "{\"a\":1,}", "{\"a\" 1}",
+    "{\"a\":}", "{a:1}", "{\"a\":1,\"a\":2}", "{1:2}", "\"\\x\"",
+    "\"\\ud83d\\ude00\"", "\"\\ud83d\"", "\"\\u12g4\"", "\"new\nline\"",
+    "[\"a\"\"b\"]", "[\"a\":1]", "{\"a\",1}", "[1]x", "[1],", "{}{}",
+    "[1}", "{]", "]", "}", ":", ",", "[[[]]", "[[]]]", "truex",
+    "[nullx]", "[1x]", "[\"a\"x]", "-a", "+1", "[\"\\", "\\", "1 2",
+  };
+
+  for (const string& input : inputs) {
+    Try<JSON::Value> expected = JSON::parse(input);
+
+    Builder builder;
+    Try<Nothing> actual = read(input, &builder, 1);
+
+    ASSERT_EQ(expected.isSome(), actual.isSome())
+      << "'" << input << "': "
+      << (expected.isError() ? expected.error() : actual.error());
+
+    if (expected.isSome()) {
+      EXPECT_EQ(expected.get(), builder.result) << input;
+    }
+  }
+
+  std::mt19937 random(42);
+
+  const string document =
+    "{\"array\": [1, -2.5e3, true, false, null, \"a\\\"b\\\\\"],"
+    " \"object\": {\"key\": \"\\u00e9\\ud83d\\ude00\", \"\": []},"
+    " \"number\": 12345678}";
+
+  const string characters = "{}[]:,\"\\ \nx0-.eE+tfnu";
+
+  for (int i = 0; i < 10000; i++) {
+    string s = document;
+    for (int mutations = 1 + random() % 3; mutations > 0; mutations--) {
+      const size_t position = random() % s.size();
+      switch (random() % 3) {
+        case 0:
+          s[position] = characters[random() % characters.size()];
+          break;
+        case 1:
+          s.erase(position, 1);
+          break;
+        case 2:
+          s.insert(position, 1, characters[random() % characters.size()]);
+          break;
+      }
+    }
+
+    Try<JSON::Value> expected = JSON::parse(s);
+
+    Builder builder;
+    Try<Nothing> actual = read(s, &builder, 1 + random() % 16);
+
+    ASSERT_EQ(expected.isSome(), actual.isSome())
+      << "'" << s << "': "
+      << (expected.isError() ? expected.error() : actual.error());
+
+    if (expected.isSome()) {
+      EXPECT_EQ(expected.get(), builder.result) << s;
+    }
+  }
+}
+
+
+TEST(JsonReaderTest, Skip) {
+  struct Skipper : Recorder {
+    JSON::Action startArray() {
+      Recorder::startArray();
+      return JSON::Action::SKIP;
+    }
+
+    JSON::Action key(string_view key) {
+      Recorder::key(key);
+      return key == "skip" ? JSON::Action::SKIP : JSON::Action::CONTINUE;
+    }
+  } skipper;
+
+  const string s =
+    "{\"skip\": {\"a\": [1, {\"b\": 2}]}, \"array\": [1, [2], {\"c\": 3}],"
+    " \"skip\": \"string\", \"d\": 4}";
+
+  ASSERT_SOME(read(s, &skipper, 7));
+
+  const vector<string> expected = {
+    "{", "key:skip", "key:array", "[", "key:skip", "key:d", "number:4", "}",
+  };
+  EXPECT_EQ(expected, skipper.events);
+
+  // Skipped values are still checked.
+  EXPECT_ERROR(read("{\"skip\": [1, 2}", &skipper, 1));
+  EXPECT_ERROR(read("{\"skip\": tru}", &skipper, 1));
+  EXPECT_ERROR(read("[1, 2, 0x]", &skipper, 1));
+
+  // Including the escapes of their strings, which aren't kept.
+  string escapes;
+  for (int i = 0; i < 5000; i++) {
+    escapes += "x\\n";
+  }
+
+  for (size_t chunk : {1, 3, 100}) {
+    EXPECT_SOME(read(
+        "{\"skip\": \"a\\n\\u00e9\\ud83d\\ude00\\\"b\"}",
+        &skipper,
+        chunk));
+    EXPECT_SOME(read("[\"" + escapes + "\\u0041\"]", &skipper, chunk));
+
+    EXPECT_ERROR(read("{\"skip\": \"\\x\"}", &skipper, chunk));
+    EXPECT_ERROR(read("{\"skip\": \"\\u12g4\"}", &skipper, chunk));
+    EXPECT_ERROR(read("{\"skip\": \"\\u12\"}", &skipper, chunk));
+    EXPECT_ERROR(read("{\"skip\": \"\\ud83d\"}", &skipper, chunk));
+    EXPECT_ERROR(read("[\"\\ud83dx\\ude00\"]", &skipper, chunk));
+    EXPECT_ERROR(read("[\"" + escapes + "\\x\"]", &skipper, chunk));
+    EXPECT_ERROR(read("[\"\\x" + escapes + "\"]", &skipper, chunk));
+  }
+}
+
+
+TEST(JsonReaderTest, Stop) {
+  struct Stopper : JSON::Handler {
+    JSON::Action key(string_view key) {
+      found = key == "version";
+      return JSON::Action::CONTINUE;
+    }
+
+    JSON::Action string(string_view value) {
+      if (found) {
+        version = std::string(value);
+        return JSON::Action::STOP;
+      }
+      return JSON::Action::CONTINUE;
+    }
+
+    bool found = false;
+    std::string version;
+  } stopper;
+
+  JSON::Reader<Stopper> reader(&stopper);
+  EXPECT_SOME(reader.feed("{\"name\": \"stout\", \"version\": \"1.0\", "));
+  EXPECT_TRUE(reader.stopped());
+  EXPECT_EQ("1.0", stopper.version);
+
+  // The rest of the input (even if not valid) is ignored.
+  EXPECT_SOME(reader.feed("not JSON"));
+  EXPECT_SOME(reader.finish());
+}
+
+
+TEST(JsonReaderTest, Errors) {
+  Recorder recorder;
+  JSON::Reader<Recorder> reader(&recorder);
+
+  EXPECT_SOME(reader.feed("[1,\n2,\n"));
+  Try<Nothing> read = reader.feed("x]");
+  ASSERT_ERROR(read);
+  EXPECT_EQ("syntax error at line 3 near: x]", read.error());
+
+  // The reader keeps failing.
+  EXPECT_ERROR(reader.feed("3]"));
+  EXPECT_ERROR(reader.finish());
+
+  // An incomplete value.
+  JSON::Reader<Recorder> incomplete(&recorder);
+  EXPECT_SOME(incomplete.feed("[1, 2"));
+  EXPECT_ERROR(incomplete.finish());
+
+  // Too deeply nested.
+  JSON::Reader<Recorder> nested(&recorder);
+  EXPECT_ERROR(nested.feed(string(1000, '[')));
+}
+
+
+class JsonReaderFileTest : public TemporaryDirectoryTest {};
+
+
+TEST_F(JsonReaderFileTest, Read) {
+  JSON::Array array;
+  for (int i = 0; i < 1000; i++) {
+    array.values.push_back(JSON::Object({{"i", i}, {"s", stringify(i)}}));
+  }
+
+  const string s = stringify(array);
+  const string path = path::join(sandbox.get(), "file");
+  ASSERT_SOME(os::write(path, s));
+
+  Try<int_fd> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+  ASSERT_SOME(fd);
+
+  Builder builder;
+  JSON::Reader<Builder> reader(&builder);
+  ASSERT_SOME(JSON::read(fd.get(), &reader, 100));
+  ASSERT_SOME(os::close(fd.get()));
+
+  EXPECT_EQ(JSON::Value(array), builder.result);
+
+  // From a compressed stream, decompressed a chunk at a time.
+  Try<string> compressed = gzip::compress(s);
+  ASSERT_SOME(compressed);
+
+  Builder decompressed;
+  JSON::Reader<Builder> reader2(&decompressed);
+  gzip::Decompressor decompressor;
+  for (size_t i = 0; i < compressed->size(); i += 100) {
+    Try<string> data = decompressor.decompress(compressed->substr(i, 100));
+    ASSERT_SOME(data);
+    ASSERT_SOME(reader2.feed(data.get()));
+  }
+  ASSERT_TRUE(decompressor.finished());
+  ASSERT_SOME(reader2.finish());
+
+  EXPECT_EQ(JSON::Value(array), decompressed.result);
+}
+
+
+// Compares the time to read a large document with 'JSON::parse' and
+// with a 'JSON::Reader' that only counts the values.
+TEST(JsonReader_BENCHMARK_Test, Read) {
+  JSON::Array array;
+  for (int i = 0; i < 20000; i++) {
+    JSON::Object object;
+    object.values["id"] = i;
+    object.values["name"] = "task-" + stringify(i);
+    object.values["hostname"] = "agent" + stringify(i % 100) + ".example.com";
+    object.values["cpus"] = 0.25 * (i % 8);
+    object.values["active"] = i % 2 == 0;
+    object.values["labels"] = JSON::Array({"a", "b\\\"c", "d\u00e9"});
+    object.values["resources"] = JSON::Object({{"mem", 128}, {"disk", 1024}});
+    array.values.push_back(object);
+  }
+
+  const string s = stringify(array);
+
+  Stopwatch watch;
+
+  watch.start();
+  Try<JSON::Value> value = JSON::parse(s);
+  watch.stop();
+
+  ASSERT_SOME(value);
+
+  std::cout << "Parsing " << Bytes(s.size()) << " with JSON::parse took "
+            << watch.elapsed() << std::endl;
+
+  struct Counter : JSON::Handler {
+    JSON::Action string(string_view) {
+      count++;
+      return JSON::Action::CONTINUE;
+    }
+
+    JSON::Action number(const JSON::Number&) {
+      count++;
+      return JSON::Action::CONTINUE;
+    }
+
+    size_t count = 0;
+  } counter;
+
+  watch.start();
+  ASSERT_SOME(read(s, &counter, 64 * 1024));
+  watch.stop();
+
+  std::cout << "Reading " << Bytes(s.size()) << " with JSON::Reader took "
+            << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(20000u * 9, counter.count);
+}
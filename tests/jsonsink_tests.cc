@@ -0,0 +1,157 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "stout/bytes.h"
+#include "stout/gtest.h"
+#include "stout/gzip.h"
+#include "stout/json.h"
+#include "stout/jsonsink.h"
+#include "stout/path.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+
+#include "stout/os/close.h"
+#include "stout/os/open.h"
+#include "stout/os/read.h"
+#include "stout/os/write.h"
+
+#include "stout/tests/utils.h"
+
+using std::string;
+
+
+static JSON::Array tasks(int size) {
+  JSON::Array array;
+  for (int i = 0; i < size; i++) {
+    JSON::Object object;
+    object.values["id"] = i;
+    object.values["name"] = "task-" + stringify(i);
+    object.values["hostname"] = "agent" + stringify(i % 100) + ".example.com";
+    object.values["labels"] = JSON::Array({"a", "b\\\"c", "dé"});
+    object.values["resources"] = JSON::Object({{"mem", 128}, {"disk", 1024}});
+    array.values.push_back(object);
+  }
+  return array;
+}
+
+
+class JsonSinkTest : public TemporaryDirectoryTest {};
+
+
+TEST_F(JsonSinkTest, Write) {
+  const JSON::Array array = tasks(1000);
+  const string path = path::join(sandbox.get(), "file");
+
+  Try<int_fd> fd = os::open(
+      path,
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR);
+  ASSERT_SOME(fd);
+
+  ASSERT_SOME(JSON::write(fd.get(), array, 1000));
+  ASSERT_SOME(os::close(fd.get()));
+
+  EXPECT_SOME_EQ(stringify(array), os::read(path));
+
+  // Writing to a closed file descriptor fails.
+  EXPECT_ERROR(JSON::write(fd.get(), array));
+}
+
+
+TEST_F(JsonSinkTest, Compress) {
+  const JSON::Array array = tasks(1000);
+
+  string compressed;
+  ASSERT_SOME(JSON::compress(
+      [&](std::string_view data) -> Try<Nothing> {
+        EXPECT_FALSE(data.empty());
+        compressed += data;
+        return Nothing();
+      },
+      array));
+
+  EXPECT_SOME_EQ(stringify(array), gzip::decompress(compressed));
+
+  // To a file.
+  const string path = path::join(sandbox.get(), "file.gz");
+
+  Try<int_fd> fd = os::open(
+      path,
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR);
+  ASSERT_SOME(fd);
+
+  ASSERT_SOME(JSON::compress(JSON::sink(fd.get()), array, Z_BEST_SPEED));
+  ASSERT_SOME(os::close(fd.get()));
+
+  Try<string> read = os::read(path);
+  ASSERT_SOME(read);
+  EXPECT_SOME_EQ(stringify(array), gzip::decompress(read.get()));
+
+  EXPECT_ERROR(JSON::compress(JSON::sink(fd.get()), array, 10));
+}
+
+
+class JsonSink_BENCHMARK_Test : public TemporaryDirectoryTest {};
+
+
+// Compares the time and the memory held at once to write a large
+// document to a file by rendering it into a string first and with
+// 'JSON::write'.
+TEST_F(JsonSink_BENCHMARK_Test, Write) {
+  const JSON::Array array = tasks(200000);
+  const string path = path::join(sandbox.get(), "file");
+
+  Stopwatch watch;
+
+  watch.start();
+  const string s = stringify(array);
+  ASSERT_SOME(os::write(path, s));
+  watch.stop();
+
+  std::cout << "Writing " << Bytes(s.size()) << " from a string took "
+            << watch.elapsed() << " holding " << Bytes(s.size())
+            << std::endl;
+
+  Try<int_fd> fd = os::open(
+      path,
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR);
+  ASSERT_SOME(fd);
+
+  const JSON::Sink sink = JSON::sink(fd.get());
+
+  size_t largest = 0;
+
+  watch.start();
+  ASSERT_SOME(JSON::write(
+      [&](std::string_view data) {
+        largest = std::max(largest, data.size());
+        return sink(data);
+      },
+      array));
+  watch.stop();
+
+  ASSERT_SOME(os::close(fd.get()));
+
+  std::cout << "Writing " << Bytes(s.size()) << " with JSON::write took "
+            << watch.elapsed() << " holding " << Bytes(largest) << std::endl;
+
+  EXPECT_SOME_EQ(s, os::read(path));
+}
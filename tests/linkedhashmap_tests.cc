@@ -94,6 +94,35 @@ TEST(LinkedHashmapTest, Values) {
 }
 
 
+TEST(LinkedHashmapTest, Views) {
+  LinkedHashMap<string, int> map;
+
+  map["foo"] = 1;
+  map["bar"] = 2;
+  map["caz"] = 3;
+
+  vector<string> keys;
+  foreach (const string& key, map.keys_view()) {
+    keys.push_back(key);
+  }
+
+  ASSERT_EQ(vector<string>({"foo", "bar", "caz"}), keys);
+
+  foreach (int& value, map.values_view()) {
+    value++;
+  }
+
+  const LinkedHashMap<string, int>& constMap = map;
+
+  vector<int> values;
+  foreach (int value, constMap.values_view()) {
+    values.push_back(value);
+  }
+
+  ASSERT_EQ(vector<int>({2, 3, 4}), values);
+}
+
+
 TEST(LinkedHashMapTest, Foreach) {
   LinkedHashMap<string, int> map;
 
@@ -25,6 +25,7 @@
 #include "stout/os/rmdir.h"
 #include "stout/os/socket.h" // For `wsa_*` on Windows.
 #include "stout/os/touch.h"
+#include "stout/strings.h"
 #include "stout/tests/environment.h"
 
 using stout::internal::tests::Environment;
@@ -73,6 +74,28 @@ class SymlinkFilter : public TestFilter {
 };
 
 
+// Disables the benchmarks (tests whose names contain "BENCHMARK_"),
+// which are slow and only print their timings, unless they're
+// explicitly requested with '--gtest_filter', e.g.,
+// '--gtest_filter=*BENCHMARK*'.
+class BenchmarkFilter : public TestFilter {
+ public:
+  BenchmarkFilter() {
+    const string& filter = ::testing::GTEST_FLAG(filter);
+    requested = strings::contains(
+        filter.substr(0, filter.find('-')),
+        "BENCHMARK");
+  }
+
+  bool disable(const ::testing::TestInfo* test) const override {
+    return matches(test, "BENCHMARK_") && !requested;
+  }
+
+ private:
+  bool requested;
+};
+
+
 #ifdef _WIN32
 // A no-op parameter validator. We use this to prevent the Windows
 // implementation of the C runtime from calling `abort` during our test suite.
@@ -111,7 +134,9 @@ int main(int argc, char** argv) {
   _set_invalid_parameter_handler(noop_invalid_parameter_handler);
 #endif // _WIN32
 
-  vector<shared_ptr<TestFilter>> filters = {make_shared<SymlinkFilter>()};
+  vector<shared_ptr<TestFilter>> filters = {
+      make_shared<SymlinkFilter>(),
+      make_shared<BenchmarkFilter>()};
   Environment* environment = new Environment(filters);
   testing::AddGlobalTestEnvironment(environment);
 
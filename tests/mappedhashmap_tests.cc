@@ -0,0 +1,216 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "stout/foreach.h"
+#include "stout/gtest.h"
+#include "stout/hashmap.h"
+#include "stout/mappedhashmap.h"
+#include "stout/stopwatch.h"
+#include "stout/stringify.h"
+#include "stout/tests/utils.h"
+
+using std::string;
+
+typedef MappedHashMap<string, string> StringTable;
+typedef MappedHashMap<string, int> IntTable;
+typedef MappedHashMap<uint64_t, int32_t> IntegerTable;
+
+
+class MappedHashMapTest : public TemporaryDirectoryTest {};
+
+
+TEST_F(MappedHashMapTest, Strings) {
+  hashmap<string, string> map;
+  map.put("one", "1");
+  map.put("two", "2");
+  map.put("a rather long key that spans more than a few words", "long");
+  map.put("", "empty");
+
+  ASSERT_SOME(StringTable::write("table", map));
+
+  Try<StringTable> table = StringTable::open("table");
+
+  ASSERT_SOME(table);
+
+  EXPECT_EQ(4u, table->size());
+  EXPECT_FALSE(table->empty());
+
+  foreachpair (const string& key, const string& value, map) {
+    EXPECT_SOME_EQ(std::string_view(value), table->get(key));
+    EXPECT_TRUE(table->contains(key));
+  }
+
+  EXPECT_NONE(table->get("three"));
+  EXPECT_FALSE(table->contains("three"));
+
+  // Copies share the mapping, which outlives the original.
+  StringTable copy = table.get();
+  table = Error("Closed");
+  EXPECT_SOME_EQ("1", copy.get("one"));
+}
+
+
+TEST_F(MappedHashMapTest, Integers) {
+  hashmap<uint64_t, int32_t> map;
+  for (uint64_t i = 0; i < 10000; i++) {
+    map[i * 7] = static_cast<int32_t>(i);
+  }
+
+  ASSERT_SOME(IntegerTable::write("table", map));
+
+  Try<IntegerTable> table = IntegerTable::open("table");
+
+  ASSERT_SOME(table);
+  EXPECT_EQ(map.size(), table->size());
+
+  for (uint64_t i = 0; i < 10000; i++) {
+    EXPECT_SOME_EQ(static_cast<int32_t>(i), table->get(i * 7));
+    EXPECT_FALSE(table->contains(i * 7 + 1));
+  }
+}
+
+
+TEST_F(MappedHashMapTest, Empty) {
+  const hashmap<string, int> map;
+
+  ASSERT_SOME(IntTable::write("table", map));
+
+  Try<IntTable> table = IntTable::open("table");
+
+  ASSERT_SOME(table);
+  EXPECT_TRUE(table->empty());
+  EXPECT_NONE(table->get("key"));
+}
+
+
+TEST_F(MappedHashMapTest, Rewrite) {
+  hashmap<string, int> map = {{"key", 1}};
+
+  ASSERT_SOME(IntTable::write("table", map));
+
+  Try<IntTable> before = IntTable::open("table");
+
+  ASSERT_SOME(before);
+
+  map["key"] = 2;
+  ASSERT_SOME(IntTable::write("table", map));
+
+  Try<IntTable> after = IntTable::open("table");
+
+  ASSERT_SOME(after);
+
+  // The table that was open before the rewrite is unaffected.
+  EXPECT_SOME_EQ(1, before->get("key"));
+  EXPECT_SOME_EQ(2, after->get("key"));
+}
+
+
+TEST_F(MappedHashMapTest, MismatchedValue) {
+  ASSERT_SOME(IntTable::write("table", hashmap<string, int>({{"key", 1}})));
+
+  // A table opened with a larger 'Value' than it was written with
+  // doesn't read past its values.
+  Try<MappedHashMap<string, uint64_t>> table =
+    MappedHashMap<string, uint64_t>::open("table");
+
+  ASSERT_SOME(table);
+  EXPECT_NONE(table->get("key"));
+  EXPECT_FALSE(table->contains("key"));
+}
+
+
+TEST(MappedHashMapParseTest, Invalid) {
+  EXPECT_ERROR(IntTable::parse(""));
+  EXPECT_ERROR(IntTable::parse(string(1024, 'x')));
+
+  string data = IntTable::serialize(hashmap<string, int>({{"key", 1}}));
+
+  EXPECT_SOME(IntTable::parse(data));
+
+  // Truncated.
+  EXPECT_ERROR(IntTable::parse(data.substr(0, 40)));
+
+  // A corrupt entry isn't found rather than read past the end.
+  Try<IntTable> table = IntTable::parse(data.substr(0, data.size() - 8));
+
+  ASSERT_SOME(table);
+  EXPECT_NONE(table->get("key"));
+}
+
+
+class MappedHashMap_BENCHMARK_Test : public TemporaryDirectoryTest {};
+
+
+// Compares building a 'hashmap' (as done at every process start) with
+// opening a 'MappedHashMap' of the same entries, and their lookups.
+TEST_F(MappedHashMap_BENCHMARK_Test, Open) {
+  const size_t size = 1000000;
+
+  hashmap<string, string> map;
+  for (size_t i = 0; i < size; i++) {
+    map.put("key-" + stringify(i), "value-" + stringify(i));
+  }
+
+  ASSERT_SOME(StringTable::write("table", map));
+
+  Stopwatch watch;
+
+  watch.start();
+  hashmap<string, string> rebuilt;
+  for (size_t i = 0; i < size; i++) {
+    rebuilt.put("key-" + stringify(i), "value-" + stringify(i));
+  }
+  watch.stop();
+
+  std::cout << "Building a hashmap took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  Try<StringTable> table = StringTable::open("table");
+  watch.stop();
+
+  ASSERT_SOME(table);
+
+  std::cout << "Opening a MappedHashMap took " << watch.elapsed()
+            << std::endl;
+
+  std::vector<string> keys;
+  for (size_t i = 0; i < size; i += 7) {
+    keys.push_back("key-" + stringify(i));
+  }
+
+  size_t found = 0;
+
+  watch.start();
+  for (const string& key : keys) {
+    found += rebuilt.contains(key);
+  }
+  watch.stop();
+
+  std::cout << "hashmap lookups took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  for (const string& key : keys) {
+    found -= table->contains(key);
+  }
+  watch.stop();
+
+  std::cout << "MappedHashMap lookups took " << watch.elapsed() << std::endl;
+
+  EXPECT_EQ(0u, found);
+}
@@ -194,3 +194,33 @@ TYPED_TEST(MultimapTest, Foreach) {
     }
   }
 }
+
+
+TEST(MultihashmapTest, Views) {
+  multihashmap<string, uint16_t> map;
+
+  EXPECT_TRUE(map.keys_view().empty());
+  EXPECT_TRUE(map.equal_range_view("foo").empty());
+
+  map.put("foo", 1024);
+  map.put("foo", 1024);
+  map.put("foo", 1025);
+  map.put("bar", 1);
+  map.put("baz", 2);
+
+  set<uint16_t> values;
+  foreach (uint16_t value, map.equal_range_view("foo")) {
+    values.insert(value);
+  }
+
+  EXPECT_EQ(set<uint16_t>({1024, 1025}), values);
+  EXPECT_TRUE(map.equal_range_view("qux").empty());
+
+  // Every key is visited exactly once.
+  std::multiset<string> keys;
+  foreach (const string& key, map.keys_view()) {
+    keys.insert(key);
+  }
+
+  EXPECT_EQ(std::multiset<string>({"bar", "baz", "foo"}), keys);
+}
@@ -0,0 +1,235 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stout/foreach.h"
+#include "stout/gtest.h"
+#include "stout/hashmap.h"
+#include "stout/persistenthashmap.h"
+#include "stout/stopwatch.h"
+
+using std::string;
+using std::vector;
+
+
+TEST(PersistentHashMapTest, Put) {
+  PersistentHashMap<string, int> empty;
+
+  EXPECT_TRUE(empty.empty());
+  EXPECT_NONE(empty.get("foo"));
+
+  PersistentHashMap<string, int> map = empty.put("foo", 1).put("bar", 2);
+
+  EXPECT_EQ(2u, map.size());
+  EXPECT_SOME_EQ(1, map.get("foo"));
+  EXPECT_SOME_EQ(2, map.get("bar"));
+  EXPECT_TRUE(map.contains("foo"));
+  EXPECT_FALSE(map.contains("baz"));
+
+  PersistentHashMap<string, int> map2 = map.put("foo", 3);
+
+  EXPECT_EQ(2u, map2.size());
+  EXPECT_SOME_EQ(3, map2.get("foo"));
+
+  // Previous versions are unchanged.
+  EXPECT_SOME_EQ(1, map.get("foo"));
+  EXPECT_TRUE(empty.empty());
+}
+
+
+TEST(PersistentHashMapTest, Erase) {
+  PersistentHashMap<string, int> map = {{"foo", 1}, {"bar", 2}};
+
+  PersistentHashMap<string, int> map2 = map.erase("foo");
+
+  EXPECT_EQ(1u, map2.size());
+  EXPECT_NONE(map2.get("foo"));
+  EXPECT_SOME_EQ(2, map2.get("bar"));
+
+  EXPECT_EQ(1u, map2.erase("baz").size());
+  EXPECT_TRUE(map2.erase("bar").empty());
+
+  EXPECT_EQ(2u, map.size());
+  EXPECT_SOME_EQ(1, map.get("foo"));
+}
+
+
+TEST(PersistentHashMapTest, Collisions) {
+  struct BadHash {
+    size_t operator()(int key) const {
+      return key % 2;
+    }
+  };
+
+  PersistentHashMap<int, int, BadHash> map;
+  for (int i = 0; i < 100; i++) {
+    map = map.put(i, i * 10);
+  }
+
+  EXPECT_EQ(100u, map.size());
+  for (int i = 0; i < 100; i++) {
+    EXPECT_SOME_EQ(i * 10, map.get(i));
+  }
+
+  for (int i = 0; i < 100; i += 2) {
+    map = map.erase(i);
+  }
+
+  EXPECT_EQ(50u, map.size());
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(i % 2 == 1, map.contains(i));
+  }
+}
+
+
+TEST(PersistentHashMapTest, Foreach) {
+  PersistentHashMap<int, int> map;
+  for (int i = 0; i < 1000; i++) {
+    map = map.put(i, i);
+  }
+
+  hashmap<int, int> visited;
+  foreachpair (int key, int value, map) {
+    EXPECT_FALSE(visited.contains(key));
+    visited[key] = value;
+  }
+
+  EXPECT_EQ(1000u, visited.size());
+  foreachpair (int key, int value, visited) {
+    EXPECT_EQ(key, value);
+  }
+}
+
+
+// Checks random sequences of operations against a 'hashmap', while
+// also checking that older versions are never affected.
+TEST(PersistentHashMapTest, MatchesHashMap) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> key(0, 2000);
+
+  PersistentHashMap<int, int> map;
+  hashmap<int, int> expected;
+
+  PersistentHashMap<int, int> snapshot;
+  hashmap<int, int> expectedSnapshot;
+
+  for (int i = 0; i < 20000; i++) {
+    const int k = key(random);
+    if (random() % 3 == 0) {
+      map = map.erase(k);
+      expected.erase(k);
+    } else {
+      map = map.put(k, i);
+      expected[k] = i;
+    }
+
+    ASSERT_EQ(expected.size(), map.size());
+
+    if (i % 1000 == 0) {
+      snapshot = map;
+      expectedSnapshot = expected;
+    }
+  }
+
+  foreachpair (int k, int v, expected) {
+    EXPECT_SOME_EQ(v, map.get(k));
+  }
+
+  size_t count = 0;
+  foreachpair (int k, int v, snapshot) {
+    EXPECT_SOME_EQ(v, expectedSnapshot.get(k));
+    count++;
+  }
+  EXPECT_EQ(expectedSnapshot.size(), count);
+
+  // Erasing everything leaves an empty map.
+  foreachkey (int k, expected) {
+    map = map.erase(k);
+  }
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
+
+TEST(PersistentHashMapTest, ConcurrentReaders) {
+  PersistentHashMap<int, int> map;
+  for (int i = 0; i < 10000; i++) {
+    map = map.put(i, i);
+  }
+
+  const PersistentHashMap<int, int> snapshot = map;
+
+  // Readers of the snapshot race with a writer creating new versions
+  // that share most of the snapshot's structure.
+  vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&snapshot]() {
+      for (int k = 0; k < 10000; k++) {
+        EXPECT_SOME_EQ(k, snapshot.get(k));
+      }
+    });
+  }
+
+  for (int i = 0; i < 10000; i++) {
+    map = map.put(i, -i).erase(i + 1);
+  }
+
+  foreach (std::thread& reader, readers) {
+    reader.join();
+  }
+}
+
+
+// Compares publishing a new version of a large map after each change
+// via copying a 'hashmap' against creating a new version.
+TEST(PersistentHashMap_BENCHMARK_Test, Snapshot) {
+  const int size = 100000;
+  const int updates = 100;
+
+  hashmap<int, int> map;
+  PersistentHashMap<int, int> persistent;
+  for (int i = 0; i < size; i++) {
+    map[i] = i;
+    persistent = persistent.put(i, i);
+  }
+
+  Stopwatch watch;
+
+  watch.start();
+  for (int i = 0; i < updates; i++) {
+    hashmap<int, int> snapshot = map;
+    snapshot[i] = -i;
+    map = std::move(snapshot);
+  }
+  watch.stop();
+
+  std::cout << "Copying a hashmap of " << size << " entries took "
+            << watch.elapsed() / updates << std::endl;
+
+  watch.start();
+  for (int i = 0; i < updates; i++) {
+    persistent = persistent.put(i, -i);
+  }
+  watch.stop();
+
+  std::cout << "Putting into a PersistentHashMap of " << size
+            << " entries took " << watch.elapsed() / updates << std::endl;
+
+  EXPECT_EQ(map.get(0), persistent.get(0));
+}
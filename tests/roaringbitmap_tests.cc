@@ -0,0 +1,393 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "stout/footprint.h"
+#include "stout/gtest.h"
+#include "stout/hashset.h"
+#include "stout/roaringbitmap.h"
+#include "stout/set.h"
+#include "stout/stopwatch.h"
+#include "stout/try.h"
+
+using std::set;
+using std::string;
+using std::vector;
+
+
+// Fills in a bitmap and the equivalent 'std::set' with values drawn
+// from containers that are sparse, dense and made of runs.
+static void randomBitmap(
+    uint32_t seed,
+    RoaringBitmap* bitmap,
+    set<uint32_t>* values) {
+  std::mt19937 random(seed);
+
+  // Sparse.
+  for (int i = 0; i < 1000; i++) {
+    values->insert(random() % (1 << 20));
+  }
+
+  // Dense.
+  for (int i = 0; i < 30000; i++) {
+    values->insert((5 << 16) + random() % (1 << 16));
+  }
+
+  // Runs.
+  for (uint32_t i = 0; i < 10; i++) {
+    const uint32_t start = (9 << 16) + random() % 60000;
+    for (uint32_t value = start; value < start + 500; value++) {
+      values->insert(value);
+    }
+  }
+
+  for (uint32_t value : *values) {
+    bitmap->add(value);
+  }
+}
+
+
+TEST(RoaringBitmapTest, AddRemoveContains) {
+  RoaringBitmap bitmap;
+  EXPECT_TRUE(bitmap.empty());
+
+  EXPECT_TRUE(bitmap.add(1));
+  EXPECT_FALSE(bitmap.add(1));
+  EXPECT_TRUE(bitmap.add(70000));
+  EXPECT_TRUE(bitmap.add(UINT32_MAX));
+
+  EXPECT_EQ(3u, bitmap.size());
+  EXPECT_TRUE(bitmap.contains(1));
+  EXPECT_TRUE(bitmap.contains(70000));
+  EXPECT_TRUE(bitmap.contains(UINT32_MAX));
+  EXPECT_FALSE(bitmap.contains(2));
+  EXPECT_FALSE(bitmap.contains(65536 + 1));
+
+  EXPECT_TRUE(bitmap.remove(70000));
+  EXPECT_FALSE(bitmap.remove(70000));
+  EXPECT_FALSE(bitmap.contains(70000));
+  EXPECT_EQ(2u, bitmap.size());
+
+  bitmap.clear();
+  EXPECT_TRUE(bitmap.empty());
+  EXPECT_EQ(0u, bitmap.size());
+}
+
+
+// Adding enough values to a container converts it to a bitmap, and
+// removing them converts it back, without changing the contents.
+TEST(RoaringBitmapTest, Dense) {
+  RoaringBitmap bitmap;
+  for (uint32_t i = 0; i < 10000; i++) {
+    EXPECT_TRUE(bitmap.add(i * 3));
+  }
+
+  EXPECT_EQ(10000u, bitmap.size());
+
+  for (uint32_t i = 0; i < 30000; i++) {
+    EXPECT_EQ(i % 3 == 0, bitmap.contains(i)) << i;
+  }
+
+  const size_t dense = bitmap.bytes();
+
+  for (uint32_t i = 0; i < 9000; i++) {
+    EXPECT_TRUE(bitmap.remove(i * 3));
+  }
+
+  EXPECT_EQ(1000u, bitmap.size());
+  EXPECT_FALSE(bitmap.contains(0));
+  EXPECT_TRUE(bitmap.contains(9000 * 3));
+
+  // It's an array again (a copy doesn't keep the spare capacity).
+  const RoaringBitmap copy = bitmap;
+  EXPECT_LT(copy.bytes(), dense / 2);
+}
+
+
+TEST(RoaringBitmapTest, Iterate) {
+  RoaringBitmap bitmap;
+  set<uint32_t> values;
+  randomBitmap(1, &bitmap, &values);
+
+  EXPECT_EQ(values.size(), bitmap.size());
+  EXPECT_EQ(
+      vector<uint32_t>(values.begin(), values.end()),
+      vector<uint32_t>(bitmap.begin(), bitmap.end()));
+
+  // Including the last values of a bitmap container.
+  RoaringBitmap dense;
+  for (uint32_t i = 0; i < 65536; i++) {
+    dense.add(i);
+  }
+  dense.add(UINT32_MAX);
+
+  vector<uint32_t> expected;
+  for (uint32_t i = 0; i < 65536; i++) {
+    expected.push_back(i);
+  }
+  expected.push_back(UINT32_MAX);
+
+  EXPECT_EQ(expected, vector<uint32_t>(dense.begin(), dense.end()));
+}
+
+
+TEST(RoaringBitmapTest, Optimize) {
+  RoaringBitmap bitmap;
+  set<uint32_t> values;
+  randomBitmap(2, &bitmap, &values);
+
+  RoaringBitmap optimized = bitmap;
+  optimized.optimize();
+
+  // The container of runs is now much smaller.
+  EXPECT_LT(optimized.bytes(), bitmap.bytes());
+
+  EXPECT_EQ(bitmap, optimized);
+  EXPECT_EQ(bitmap.size(), optimized.size());
+  EXPECT_EQ(
+      vector<uint32_t>(values.begin(), values.end()),
+      vector<uint32_t>(optimized.begin(), optimized.end()));
+
+  for (uint32_t value : values) {
+    EXPECT_TRUE(optimized.contains(value)) << value;
+    EXPECT_FALSE(optimized.contains(value + (1 << 20) * 16)) << value;
+  }
+
+  // A set made up of a single range is a single run.
+  RoaringBitmap range;
+  for (uint32_t i = 0; i < 65536; i++) {
+    range.add(i);
+  }
+  range.optimize();
+  EXPECT_EQ(65536u, range.size());
+  EXPECT_GT(32u, range.bytes() - sizeof(internal::roaring::Container));
+
+  // Adding to and removing from a container of runs still works.
+  const uint32_t value = *values.rbegin();
+  EXPECT_TRUE(optimized.remove(value));
+  EXPECT_FALSE(optimized.contains(value));
+  EXPECT_TRUE(optimized.add(value));
+  EXPECT_TRUE(optimized.contains(value));
+  EXPECT_EQ(bitmap, optimized);
+}
+
+
+TEST(RoaringBitmapTest, Operators) {
+  RoaringBitmap a, b;
+  set<uint32_t> as, bs;
+  randomBitmap(3, &a, &as);
+  randomBitmap(4, &b, &bs);
+
+  // Combine containers of every type with every other type.
+  RoaringBitmap optimized = b;
+  optimized.optimize();
+
+  for (const RoaringBitmap& other : {b, optimized}) {
+    const set<uint32_t> unite = as | bs;
+    const set<uint32_t> intersect = as & bs;
+    const set<uint32_t> difference = as - bs;
+
+    RoaringBitmap result = a | other;
+    EXPECT_EQ(unite.size(), result.size());
+    EXPECT_EQ(
+        vector<uint32_t>(unite.begin(), unite.end()),
+        vector<uint32_t>(result.begin(), result.end()));
+
+    result = a & other;
+    EXPECT_EQ(intersect.size(), result.size());
+    EXPECT_EQ(
+        vector<uint32_t>(intersect.begin(), intersect.end()),
+        vector<uint32_t>(result.begin(), result.end()));
+
+    result = a - other;
+    EXPECT_EQ(difference.size(), result.size());
+    EXPECT_EQ(
+        vector<uint32_t>(difference.begin(), difference.end()),
+        vector<uint32_t>(result.begin(), result.end()));
+
+    result = other - a;
+    EXPECT_EQ(bs.size() - intersect.size(), result.size());
+  }
+
+  RoaringBitmap c = a;
+  c -= a;
+  EXPECT_TRUE(c.empty());
+
+  c |= a;
+  EXPECT_EQ(a, c);
+
+  c &= RoaringBitmap();
+  EXPECT_TRUE(c.empty());
+
+  EXPECT_EQ(RoaringBitmap({1, 2, 3}), RoaringBitmap({3, 2, 1}));
+  EXPECT_NE(RoaringBitmap({1, 2, 3}), RoaringBitmap({1, 2}));
+}
+
+
+TEST(RoaringBitmapTest, Serialize) {
+  RoaringBitmap bitmap;
+  set<uint32_t> values;
+  randomBitmap(5, &bitmap, &values);
+
+  RoaringBitmap optimized = bitmap;
+  optimized.optimize();
+
+  for (const RoaringBitmap& expected : {bitmap, optimized, RoaringBitmap()}) {
+    const string data = expected.serialize();
+
+    Try<RoaringBitmap> parsed = RoaringBitmap::parse(data);
+    ASSERT_SOME(parsed);
+    EXPECT_EQ(expected, parsed.get());
+
+    EXPECT_ERROR(RoaringBitmap::parse(data.substr(0, data.size() - 1)));
+    EXPECT_ERROR(RoaringBitmap::parse(data + "x"));
+  }
+
+  EXPECT_ERROR(RoaringBitmap::parse(""));
+  EXPECT_ERROR(RoaringBitmap::parse("not a bitmap"));
+}
+
+
+// Returns a serialized bitmap of one container with the given type,
+// cardinality and 'values' (or 'words' if it's a bitmap container).
+static string serialized(
+    uint8_t type,
+    uint32_t cardinality,
+    const vector<uint64_t>& values) {
+  using internal::roaring::encode;
+
+  string data = internal::roaring::MAGIC;
+  encode(&data, 1, 4);
+  encode(&data, 0, 2);
+  encode(&data, type, 1);
+  encode(&data, cardinality, 4);
+  encode(&data, values.size(), 4);
+  for (uint64_t value : values) {
+    encode(&data, value, type == 1 ? 8 : 2);
+  }
+  return data;
+}
+
+
+TEST(RoaringBitmapTest, ParseCorrupt) {
+  // Sanity check the helper.
+  EXPECT_SOME_EQ(RoaringBitmap({1, 2}), RoaringBitmap::parse(
+      serialized(0, 2, {1, 2})));
+  EXPECT_SOME_EQ(RoaringBitmap({1, 2, 3, 7}), RoaringBitmap::parse(
+      serialized(2, 4, {1, 2, 7, 0})));
+
+  // Empty array and run containers.
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(0, 0, {})));
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(2, 0, {})));
+
+  // Unsorted or duplicate array values.
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(0, 2, {2, 1})));
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(0, 2, {1, 1})));
+
+  // Runs past the end of the container.
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(2, 2, {0xffff, 1})));
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(2, 0x10000, {1, 0xffff})));
+
+  // Unsorted or overlapping runs.
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(2, 4, {10, 1, 1, 1})));
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(2, 4, {1, 2, 3, 0})));
+
+  // Run cardinality that doesn't match the runs.
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(2, 5, {1, 2, 7, 0})));
+
+  // Bitmap cardinality that doesn't match the bits, or is small
+  // enough for an array container.
+  vector<uint64_t> words(internal::roaring::WORDS, 0);
+  for (size_t i = 0; i < 100; i++) {
+    words[i] = ~uint64_t(0);
+  }
+  EXPECT_SOME(RoaringBitmap::parse(serialized(1, 6400, words)));
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(1, 6401, words)));
+
+  words.assign(internal::roaring::WORDS, 0);
+  words[0] = 1;
+  EXPECT_ERROR(RoaringBitmap::parse(serialized(1, 1, words)));
+}
+
+
+TEST(RoaringBitmapTest, Footprint) {
+  RoaringBitmap bitmap;
+  for (uint32_t i = 0; i < 100000; i++) {
+    bitmap.add(i);
+  }
+
+  // Two bitmap containers.
+  EXPECT_LE(2 * 8192u, stout::footprint(bitmap).bytes());
+  EXPECT_GT(3 * 8192u, stout::footprint(bitmap).bytes());
+}
+
+
+// Compares the memory used by and the time to intersect sets of pids
+// as 'std::set', 'hashset' and 'RoaringBitmap'.
+TEST(RoaringBitmap_BENCHMARK_Test, Intersect) {
+  std::mt19937 random(42);
+
+  vector<uint32_t> values1, values2;
+  for (int i = 0; i < 1000000; i++) {
+    values1.push_back(random() % 4000000);
+    values2.push_back(random() % 4000000);
+  }
+
+  const set<uint32_t> set1(values1.begin(), values1.end());
+  const set<uint32_t> set2(values2.begin(), values2.end());
+
+  hashset<uint32_t> hashset1, hashset2;
+  hashset1.insert(values1.begin(), values1.end());
+  hashset2.insert(values2.begin(), values2.end());
+
+  const RoaringBitmap bitmap1(values1.begin(), values1.end());
+  const RoaringBitmap bitmap2(values2.begin(), values2.end());
+
+  std::cout << "std::set uses " << stout::footprint(set1) << ", hashset uses "
+            << stout::footprint(hashset1) << ", RoaringBitmap uses "
+            << stout::footprint(bitmap1) << std::endl;
+
+  Stopwatch watch;
+
+  watch.start();
+  const set<uint32_t> intersection = set1 & set2;
+  watch.stop();
+
+  std::cout << "std::set intersection took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  size_t count = 0;
+  for (uint32_t value : hashset1) {
+    count += hashset2.contains(value);
+  }
+  watch.stop();
+
+  std::cout << "hashset intersection took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  const RoaringBitmap result = bitmap1 & bitmap2;
+  watch.stop();
+
+  std::cout << "RoaringBitmap intersection took " << watch.elapsed()
+            << std::endl;
+
+  EXPECT_EQ(intersection.size(), count);
+  EXPECT_EQ(intersection.size(), result.size());
+}
@@ -13,15 +13,20 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <iostream>
 #include <string>
+#include <vector>
 
 #include "stout/check.h"
 #include "stout/gtest.h"
+#include "stout/stopwatch.h"
 #include "stout/uuid.h"
 
 using id::UUID;
 
 using std::string;
+using std::vector;
 
 
 TEST(UUIDTest, Test) {
@@ -71,3 +76,148 @@ TEST(UUIDTest, MalformedUUID) {
   EXPECT_SOME(UUID::fromString(UUID::random().toString()));
   EXPECT_ERROR(UUID::fromString("malformed-uuid"));
 }
+
+
+TEST(UUIDTest, TimeOrdered) {
+  const vector<UUID> uuids = UUID::timeOrdered(10000);
+  ASSERT_EQ(10000u, uuids.size());
+
+  vector<string> strings;
+  for (const UUID& uuid : uuids) {
+    EXPECT_EQ(7, uuid.data[6] >> 4);
+    EXPECT_EQ(UUID::variant_rfc_4122, uuid.variant());
+    strings.push_back(uuid.toString());
+  }
+
+  // They're strictly increasing, both as bytes and as strings.
+  for (size_t i = 1; i < uuids.size(); i++) {
+    EXPECT_LT(uuids[i - 1], uuids[i]);
+  }
+
+  EXPECT_TRUE(std::is_sorted(strings.begin(), strings.end()));
+
+  // They start with the current time.
+  const UUID uuid = UUID::timeOrdered();
+  uint64_t timestamp = 0;
+  for (int i = 0; i < 6; i++) {
+    timestamp = (timestamp << 8) | uuid.data[i];
+  }
+
+  const uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  EXPECT_LE(timestamp, now);
+  EXPECT_GE(timestamp + 1000, now);
+
+  // And can be round tripped.
+  EXPECT_SOME_EQ(uuid, UUID::fromBytes(uuid.toBytes()));
+  EXPECT_SOME_EQ(uuid, UUID::fromString(uuid.toString()));
+}
+
+
+TEST(UUIDTest, Chars) {
+  const UUID uuid = UUID::random();
+
+  char chars[UUID::STRING_SIZE];
+  EXPECT_EQ(chars + UUID::STRING_SIZE, uuid.toChars(chars));
+
+  const string string(chars, UUID::STRING_SIZE);
+  EXPECT_EQ(to_string(uuid), string);
+
+  EXPECT_SOME_EQ(uuid, UUID::fromChars(string));
+
+  // Uppercase and without hyphens.
+  std::string upper;
+  for (char c : string) {
+    if (c != '-') {
+      upper.push_back(toupper(c));
+    }
+  }
+  EXPECT_SOME_EQ(uuid, UUID::fromChars(upper));
+
+  EXPECT_NONE(UUID::fromChars(""));
+  EXPECT_NONE(UUID::fromChars(string.substr(1)));
+  EXPECT_NONE(UUID::fromChars(string + "0"));
+  EXPECT_NONE(UUID::fromChars("{" + string.substr(2) + "}"));
+
+  std::string invalid = string;
+  invalid[8] = '0';
+  EXPECT_NONE(UUID::fromChars(invalid));
+
+  invalid = string;
+  invalid[0] = 'g';
+  EXPECT_NONE(UUID::fromChars(invalid));
+
+  // 'fromString' still accepts the forms that boost does.
+  EXPECT_SOME_EQ(uuid, UUID::fromString("{" + string + "}"));
+}
+
+
+// Compares converting UUIDs to and from strings with boost and with
+// 'toChars'/'fromChars'.
+TEST(UUID_BENCHMARK_Test, Chars) {
+  const vector<UUID> uuids = UUID::random(100000);
+
+  vector<string> strings;
+  strings.reserve(uuids.size());
+
+  Stopwatch watch;
+
+  watch.start();
+  for (const UUID& uuid : uuids) {
+    strings.push_back(to_string(uuid));
+  }
+  watch.stop();
+
+  std::cout << "to_string took " << watch.elapsed() << std::endl;
+
+  char chars[UUID::STRING_SIZE];
+  size_t result = 0;
+
+  watch.start();
+  for (const UUID& uuid : uuids) {
+    result += *(uuid.toChars(chars) - 1);
+  }
+  watch.stop();
+
+  std::cout << "toChars took " << watch.elapsed() << std::endl;
+
+  watch.start();
+  for (const string& string : strings) {
+    boost::uuids::string_generator generator;
+    result += generator(string).data[0];
+  }
+  watch.stop();
+
+  std::cout << "boost::uuids::string_generator took " << watch.elapsed()
+            << std::endl;
+
+  watch.start();
+  for (const string& string : strings) {
+    result += UUID::fromChars(string)->data[0];
+  }
+  watch.stop();
+
+  std::cout << "fromChars took " << watch.elapsed() << std::endl;
+
+  EXPECT_NE(0u, result);
+}
+
+
+TEST(UUID_BENCHMARK_Test, Generate) {
+  Stopwatch watch;
+
+  watch.start();
+  vector<UUID> uuids = UUID::random(100000);
+  watch.stop();
+
+  std::cout << "Generating " << uuids.size() << " random UUIDs took "
+            << watch.elapsed() << std::endl;
+
+  watch.start();
+  uuids = UUID::timeOrdered(100000);
+  watch.stop();
+
+  std::cout << "Generating " << uuids.size() << " time ordered UUIDs took "
+            << watch.elapsed() << std::endl;
+}